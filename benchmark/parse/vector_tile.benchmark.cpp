@@ -26,3 +26,25 @@ static void Parse_VectorTile(benchmark::State& state) {
 }
 
 BENCHMARK(Parse_VectorTile);
+
+static void Parse_VectorTileGeometries(benchmark::State& state) {
+    auto data = std::make_shared<std::string>(util::read_file("test/fixtures/api/assets/streets/10-163-395.vector.pbf"));
+
+    while (state.KeepRunning()) {
+        std::size_t length = 0;
+        VectorTileData tile(data);
+        for (const auto& name : { "building", "landuse" }) {
+            if (auto layer = tile.getLayer(name)) {
+                const std::size_t count = layer->featureCount();
+                for (std::size_t i = 0; i < count; i++) {
+                    for (const auto& ring : layer->getFeature(i)->getGeometries()) {
+                        length += ring.size();
+                    }
+                }
+            }
+        }
+        benchmark::DoNotOptimize(length);
+    }
+}
+
+BENCHMARK(Parse_VectorTileGeometries);
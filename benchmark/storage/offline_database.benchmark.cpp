@@ -4,10 +4,13 @@
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/response.hpp>
 #include <mbgl/storage/sqlite3.hpp>
+#include <mbgl/util/io.hpp>
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/logging.hpp>
 
+#include <list>
 #include <random>
+#include <tuple>
 
 class OfflineDatabase : public benchmark::Fixture {
 public:
@@ -194,3 +197,56 @@ BENCHMARK_F(OfflineDatabase, ResizeDatabase)(benchmark::State& state) {
         }
     }
 }
+
+// Writes to a database file, so that the cost of syncing commits to disk is included.
+static void OfflineDatabase_PutTilesToFile(benchmark::State& state,
+                                           mbgl::OfflineDatabase::JournalMode journalMode,
+                                           mbgl::OfflineDatabase::Durability durability) {
+    using namespace mbgl;
+
+    const std::string path = "benchmark_offline.db";
+    const auto batchSize = static_cast<std::size_t>(state.range(0));
+
+    Response response;
+    response.data = std::make_shared<std::string>(50 * 1024, 0);
+    response.expires = util::now() + std::chrono::hours(1);
+
+    util::deleteFile(path);
+    {
+        OfflineDatabase db(path, TileServerOptions::DefaultConfiguration());
+        db.setJournalMode(journalMode);
+        db.setDurability(durability);
+
+        std::size_t count = 0;
+        std::list<std::tuple<Resource, Response>> batch;
+        while (state.KeepRunning()) {
+            const Resource ambient = Resource::tile("mapbox://PutTilesToFile" + util::toString(count++), 1, 0, 0, 0, Tileset::Scheme::XYZ);
+            if (batchSize == 1) {
+                db.put(ambient, response);
+            } else {
+                batch.emplace_back(ambient, response);
+                if (batch.size() == batchSize) {
+                    db.putAmbientResources(batch);
+                    batch.clear();
+                }
+            }
+        }
+        db.putAmbientResources(batch);
+    }
+    util::deleteFile(path);
+    util::deleteFile(path + "-wal");
+    util::deleteFile(path + "-shm");
+}
+
+static void OfflineDatabase_PutTilesToFileDelete(benchmark::State& state) {
+    OfflineDatabase_PutTilesToFile(
+        state, mbgl::OfflineDatabase::JournalMode::Delete, mbgl::OfflineDatabase::Durability::Full);
+}
+
+static void OfflineDatabase_PutTilesToFileWAL(benchmark::State& state) {
+    OfflineDatabase_PutTilesToFile(
+        state, mbgl::OfflineDatabase::JournalMode::WAL, mbgl::OfflineDatabase::Durability::Normal);
+}
+
+BENCHMARK(OfflineDatabase_PutTilesToFileDelete)->Arg(1)->Arg(64);
+BENCHMARK(OfflineDatabase_PutTilesToFileWAL)->Arg(1)->Arg(64);
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/offline.hpp>
+#include <mbgl/storage/offline_database.hpp>
+#include <mbgl/storage/offline_download.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/run_loop.hpp>
+#include <mbgl/util/timer.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using namespace mbgl;
+
+namespace {
+
+const std::string styleJSON = R"({
+    "version": 8,
+    "sources": {
+        "vector": { "type": "vector", "tiles": [ "http://127.0.0.1/{z}/{x}/{y}.pbf" ], "maxzoom": 14 }
+    },
+    "layers": []
+})";
+
+// Serves every resource after a delay, like a server that handles a few requests at a time and
+// queues the rest, so that the latency grows with the number of requests in flight.
+class StubServer : public FileSource {
+public:
+    class Request : public AsyncRequest {
+    public:
+        Request(StubServer& server_) : server(server_) { server.inFlight++; }
+        ~Request() override { server.inFlight--; }
+
+        StubServer& server;
+        util::Timer timer;
+    };
+
+    std::unique_ptr<AsyncRequest> request(const Resource& resource, Callback callback) override {
+        auto req = std::make_unique<Request>(*this);
+        const auto latency = Milliseconds(1) * std::max<std::size_t>(1, inFlight / 8);
+        req->timer.start(latency, Duration::zero(), [this, resource, callback] {
+            Response response;
+            response.data = std::make_shared<std::string>(resource.kind == Resource::Kind::Style ? styleJSON : tile);
+            callback(response);
+        });
+        return req;
+    }
+
+    bool canRequest(const Resource&) const override { return true; }
+    void setResourceOptions(ResourceOptions) override {}
+    ResourceOptions getResourceOptions() override {
+        return ResourceOptions().withTileServerOptions(TileServerOptions::DefaultConfiguration());
+    }
+
+    std::size_t inFlight = 0;
+    const std::string tile = std::string(16 * 1024, 'x');
+};
+
+class Observer : public OfflineRegionObserver {
+public:
+    void statusChanged(OfflineRegionStatus status) override {
+        if (status.downloadState == OfflineRegionDownloadState::Inactive) {
+            util::RunLoop::Get()->stop();
+        }
+    }
+};
+
+void download(OfflineDatabase& db, StubServer& server, int64_t regionID, const OfflineRegionDefinition& definition) {
+    OfflineDownload download(regionID, definition, db, server);
+    download.setObserver(std::make_unique<Observer>());
+    download.setState(OfflineRegionDownloadState::Active);
+    util::RunLoop::Get()->run();
+}
+
+} // namespace
+
+// Downloads a region of 1365 tiles (zoom levels 0 to 5) into an empty database.
+static void OfflineDownload_Download(benchmark::State& state) {
+    util::RunLoop loop;
+    const OfflineTilePyramidRegionDefinition definition{"http://127.0.0.1/style.json", LatLngBounds::world(), 0, 5, 1.0, false};
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        OfflineDatabase db(":memory:", TileServerOptions::DefaultConfiguration());
+        StubServer server;
+        const auto regionID = db.createRegion(definition, {})->getID();
+        state.ResumeTiming();
+
+        download(db, server, regionID, definition);
+    }
+}
+
+// Downloads the same region again, with all of its resources already in the database.
+static void OfflineDownload_Redownload(benchmark::State& state) {
+    util::RunLoop loop;
+    const OfflineTilePyramidRegionDefinition definition{"http://127.0.0.1/style.json", LatLngBounds::world(), 0, 5, 1.0, false};
+
+    OfflineDatabase db(":memory:", TileServerOptions::DefaultConfiguration());
+    StubServer server;
+    const auto regionID = db.createRegion(definition, {})->getID();
+    download(db, server, regionID, definition);
+
+    while (state.KeepRunning()) {
+        download(db, server, regionID, definition);
+    }
+}
+
+BENCHMARK(OfflineDownload_Download)->Unit(benchmark::kMillisecond);
+BENCHMARK(OfflineDownload_Redownload)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+
+#include <mbgl/layout/symbol_instance.hpp>
+#include <mbgl/renderer/buckets/symbol_bucket.hpp>
+#include <mbgl/text/cross_tile_symbol_index.hpp>
+#include <mbgl/util/string.hpp>
+#include <mbgl/util/utf.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+SymbolInstance makeSymbolInstance(float x, float y, std::u16string key) {
+    GeometryCoordinates line;
+    ImageMap imageMap;
+    const ShapedTextOrientations shaping{};
+    style::SymbolLayoutProperties::Evaluated layout;
+    IndexedSubfeature subfeature(0, "", "", 0);
+    Anchor anchor(x, y, 0, 0);
+    std::array<float, 2> textOffset{{0.0f, 0.0f}};
+    std::array<float, 2> iconOffset{{0.0f, 0.0f}};
+    std::array<float, 2> variableTextOffset{{0.0f, 0.0f}};
+    style::SymbolPlacementType placementType = style::SymbolPlacementType::Point;
+
+    auto sharedData = std::make_shared<SymbolInstanceSharedData>(std::move(line),
+                                                                 shaping,
+                                                                 nullopt,
+                                                                 nullopt,
+                                                                 layout,
+                                                                 placementType,
+                                                                 textOffset,
+                                                                 imageMap,
+                                                                 0,
+                                                                 SymbolContent::IconSDF,
+                                                                 false,
+                                                                 false);
+    return SymbolInstance(anchor, std::move(sharedData), shaping, nullopt, nullopt, 0, 0, placementType, textOffset, 0, 0, iconOffset, subfeature, 0, 0, key, 0.0f, 0.0f, 0.0f, variableTextOffset, false);
+}
+
+struct TileBucket {
+    OverscaledTileID id;
+    std::unique_ptr<SymbolBucket> bucket;
+};
+
+// A burst of tile loads, like after a zoom: the 4x4 tiles of a zoom level and the 8x8 tiles of
+// the next one, with about `symbolCount` labels each. Every label of the lower zoom level is also
+// in the higher one, and many labels share a key, like house numbers or road shields do.
+std::vector<TileBucket> makeTileBuckets(std::size_t symbolCount) {
+    Immutable<style::SymbolLayoutProperties::PossiblyEvaluated> layout =
+        makeMutable<style::SymbolLayoutProperties::PossiblyEvaluated>();
+
+    struct Label {
+        Point<float> position; // In tile units of the higher zoom level
+        std::u16string key;
+    };
+    std::minstd_rand generator(7);
+    std::uniform_real_distribution<float> position(0, 8 * util::EXTENT);
+    std::uniform_int_distribution<int> key(0, 50);
+    std::vector<Label> labels;
+    for (std::size_t i = 0; i < 64 * symbolCount; ++i) {
+        labels.push_back({{position(generator), position(generator)},
+                          u"Label " + util::convertUTF8ToUTF16(util::toString(key(generator)))});
+    }
+
+    std::vector<TileBucket> buckets;
+    uint32_t bucketInstanceId = 0;
+    for (uint32_t z = 12; z <= 13; ++z) {
+        // The tiles of the lower zoom level cover twice the area and show a quarter of the labels.
+        const uint32_t tiles = z == 12 ? 4 : 8;
+        const float scale = z == 12 ? 0.5f : 1.0f;
+        for (uint32_t x = 0; x < tiles; ++x) {
+            for (uint32_t y = 0; y < tiles; ++y) {
+                std::vector<SymbolInstance> instances;
+                for (std::size_t i = 0; i < labels.size(); ++i) {
+                    const Point<float> anchor = labels[i].position * scale -
+                                                Point<float>(x * util::EXTENT, y * util::EXTENT);
+                    if ((z == 13 || i % 4 == 0) && anchor.x >= 0 && anchor.x < util::EXTENT && anchor.y >= 0 &&
+                        anchor.y < util::EXTENT) {
+                        instances.push_back(makeSymbolInstance(anchor.x, anchor.y, labels[i].key));
+                    }
+                }
+                auto bucket = std::make_unique<SymbolBucket>(layout,
+                                                             std::map<std::string, Immutable<style::LayerProperties>>{},
+                                                             16.0f,
+                                                             1.0f,
+                                                             z,
+                                                             false,
+                                                             false,
+                                                             "bucket",
+                                                             std::move(instances),
+                                                             std::vector<SortKeyRange>{},
+                                                             1.0f,
+                                                             false,
+                                                             std::vector<style::TextWritingModeType>{},
+                                                             false);
+                bucket->bucketInstanceId = ++bucketInstanceId;
+                const uint32_t offset = 1u << (z - 10);
+                const auto zoom = static_cast<uint8_t>(z);
+                buckets.push_back({OverscaledTileID(zoom, 0, zoom, offset + x, offset + y), std::move(bucket)});
+            }
+        }
+    }
+    return buckets;
+}
+
+} // namespace
+
+static void CrossTileSymbolIndex_TileLoadBurst(benchmark::State& state) {
+    auto buckets = makeTileBuckets(state.range(0));
+
+    while (state.KeepRunning()) {
+        uint32_t maxCrossTileID = 0;
+        CrossTileSymbolLayerIndex index(maxCrossTileID);
+        for (auto& tile : buckets) {
+            index.addBucket(tile.id, mat4{}, *tile.bucket);
+        }
+        benchmark::DoNotOptimize(maxCrossTileID);
+    }
+}
+
+BENCHMARK(CrossTileSymbolIndex_TileLoadBurst)->Arg(100)->Arg(1000);
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <mbgl/geometry/feature_index.hpp>
+#include <mbgl/util/grid_index.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+using Grid = GridIndex<IndexedSubfeature>;
+
+// Label boxes scattered over a padded 1024x768 viewport, in the proportions of a label-dense city view.
+std::vector<Grid::BBox> generateBoxes(std::size_t count) {
+    std::minstd_rand generator(42);
+    std::uniform_real_distribution<float> x(0, 1224);
+    std::uniform_real_distribution<float> y(0, 968);
+    std::uniform_real_distribution<float> width(20, 120);
+    std::uniform_real_distribution<float> height(12, 24);
+
+    std::vector<Grid::BBox> boxes;
+    boxes.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const mapbox::geometry::point<float> min{x(generator), y(generator)};
+        boxes.push_back({min, {min.x + width(generator), min.y + height(generator)}});
+    }
+    return boxes;
+}
+
+// Places labels the way CollisionIndex does: each label is tested against the labels
+// placed so far and inserted when it doesn't collide.
+std::size_t place(Grid& grid, const std::vector<Grid::BBox>& boxes) {
+    std::size_t placed = 0;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        if (!grid.hitTest(boxes[i], [](const IndexedSubfeature& feature) { return feature.collisionGroupId == 0; })) {
+            grid.insert(IndexedSubfeature(i, "", "", 0), boxes[i]);
+            ++placed;
+        }
+    }
+    return placed;
+}
+
+} // namespace
+
+static void GridIndex_Place(benchmark::State& state) {
+    const auto boxes = generateBoxes(state.range(0));
+    std::size_t placed = 0;
+
+    while (state.KeepRunning()) {
+        Grid grid(1224, 968, 25);
+        placed += place(grid, boxes);
+    }
+    benchmark::DoNotOptimize(placed);
+}
+
+static void GridIndex_PlaceReserved(benchmark::State& state) {
+    const auto boxes = generateBoxes(state.range(0));
+    Grid previous(1224, 968, 25);
+    std::size_t placed = place(previous, boxes);
+
+    while (state.KeepRunning()) {
+        Grid grid(1224, 968, 25);
+        grid.reserve(previous);
+        placed += place(grid, boxes);
+    }
+    benchmark::DoNotOptimize(placed);
+}
+
+BENCHMARK(GridIndex_Place)->Arg(1000)->Arg(10000);
+BENCHMARK(GridIndex_PlaceReserved)->Arg(1000)->Arg(10000);
@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+
+#include <mbgl/util/thread_pool.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+using namespace mbgl;
+
+namespace {
+
+// Blocks until the given number of tasks have called done().
+class Latch {
+public:
+    explicit Latch(std::size_t count_) : count(count_) {}
+
+    void done() {
+        if (--count == 0) {
+            // Notify while holding the lock, so wait() can't return and destroy
+            // the latch before we're done with it.
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+            cv.notify_one();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return finished; });
+    }
+
+private:
+    std::atomic<std::size_t> count;
+    bool finished = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+constexpr std::size_t fanOut = 16;
+
+void work(std::size_t iterations) {
+    std::size_t value = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        benchmark::DoNotOptimize(value += i);
+    }
+}
+
+} // namespace
+
+// All tasks are scheduled from a non-worker thread, like messages sent to the
+// tile workers from the render thread.
+template <std::size_t N>
+static void ThreadPool_ScheduleExternal(benchmark::State& state) {
+    ThreadedScheduler<N> scheduler;
+    const auto tasks = std::size_t(state.range(0));
+
+    while (state.KeepRunning()) {
+        Latch latch(tasks);
+        for (std::size_t i = 0; i < tasks; ++i) {
+            scheduler.schedule([&latch] {
+                work(1000);
+                latch.done();
+            });
+        }
+        latch.wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Tasks are scheduled from the workers themselves, like mailboxes rescheduling
+// themselves after processing a message.
+template <std::size_t N>
+static void ThreadPool_ScheduleInternal(benchmark::State& state) {
+    ThreadedScheduler<N> scheduler;
+    const auto tasks = std::size_t(state.range(0));
+
+    while (state.KeepRunning()) {
+        Latch latch(tasks * fanOut);
+        for (std::size_t i = 0; i < tasks; ++i) {
+            scheduler.schedule([&scheduler, &latch] {
+                for (std::size_t j = 0; j < fanOut; ++j) {
+                    scheduler.schedule([&latch] {
+                        work(1000);
+                        latch.done();
+                    });
+                }
+            });
+        }
+        latch.wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0) * fanOut);
+}
+
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 1)->Arg(1000)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 2)->Arg(1000)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 4)->Arg(1000)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 8)->Arg(1000)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 16)->Arg(1000)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleExternal, 32)->Arg(1000)->UseRealTime();
+
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 1)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 2)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 4)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 8)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 16)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(ThreadPool_ScheduleInternal, 32)->Arg(100)->UseRealTime();
@@ -1,7 +1,9 @@
 #include <mbgl/storage/file_source_manager.hpp>
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/resource_options.hpp>
+#include <mbgl/storage/sqlite3.hpp>
 #include <mbgl/util/chrono.hpp>
+#include <mbgl/util/compression.hpp>
 #include <mbgl/util/run_loop.hpp>
 
 #include <args.hxx>
@@ -12,16 +14,56 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Trains a zstd dictionary from the most recently used tiles in the cache database. Tiles that
+// are already compressed with zstd are skipped, as their dictionary may be the one being replaced.
+int trainDictionary(const std::string& cachePath,
+                    const std::string& dictionaryPath,
+                    int64_t sampleCount,
+                    std::size_t dictionarySize) try {
+    mapbox::sqlite::Database db = mapbox::sqlite::Database::open(cachePath, mapbox::sqlite::ReadOnly);
+    mapbox::sqlite::Statement statement{db,
+                                        "SELECT data, compressed FROM tiles "
+                                        "WHERE data IS NOT NULL AND compressed IN (0, 1) "
+                                        "ORDER BY accessed DESC LIMIT ?1"};
+    mapbox::sqlite::Query query{statement};
+    query.bind(1, sampleCount);
+
+    std::vector<std::string> samples;
+    while (query.run()) {
+        auto data = query.get<std::string>(0);
+        samples.push_back(query.get<int>(1) ? mbgl::util::decompress(data) : std::move(data));
+    }
+
+    const std::string dictionary = mbgl::util::trainDictionary(samples, dictionarySize);
+    auto written = mapbox::base::io::writeFile(dictionaryPath, dictionary);
+    if (!written) {
+        std::cerr << written.error() << std::endl;
+        return 3;
+    }
+
+    std::cout << "Trained a " << dictionary.size() << " byte dictionary from " << samples.size() << " tiles"
+              << std::endl;
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 4;
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     args::ArgumentParser p("Mapbox GL cache tool", "");
     args::HelpFlag helpFlag(p, "help", "Display this help menu", {'h'});
 
-    args::ValueFlag<std::string> urlValue(p, "URL", "Resource URL (required)", {'u'}, args::Options::Required);
+    args::ValueFlag<std::string> urlValue(p, "URL", "Resource URL (required unless --train-dictionary)", {'u'});
     args::ValueFlag<std::string> cacheValue(
         p, "cache", "Path to the cache database (required)", {'c'}, args::Options::Required);
     args::ValueFlag<std::string> dataValue(
-        p, "data", "Path to the resource data (required)", {'d'}, args::Options::Required);
+        p, "data", "Path to the resource data (required unless --train-dictionary)", {'d'});
     args::ValueFlag<std::string> etagValue(p, "etag", "Cache eTag, none otherwise", {'t'});
     args::ValueFlag<unsigned long> expiresValue(p, "expires", "Expires date, will use 'now' otherwise", {'e'});
     args::ValueFlag<unsigned long> modifiedValue(p, "modified", "Modified date, will use 'now' otherwise", {'m'});
@@ -34,19 +76,29 @@ int main(int argc, char* argv[]) {
                                                                   {"style", mbgl::Resource::Style},
                                                                   {"tile", mbgl::Resource::Tile}};
 
-    std::string typeHelp("One of the following (required):");
+    std::string typeHelp("One of the following (required unless --train-dictionary):");
     for (auto key : typeMap) {
         typeHelp += " " + key.first;
     }
 
-    args::MapFlag<std::string, mbgl::Resource::Kind> typeFlag(
-        p, "type", typeHelp, {"type"}, typeMap, args::Options::Required);
+    args::MapFlag<std::string, mbgl::Resource::Kind> typeFlag(p, "type", typeHelp, {"type"}, typeMap);
 
     args::Group tileIdGroup(p, "Coordinates (required for 'tile')", args::Group::Validators::AllOrNone);
     args::ValueFlag<int32_t> xValueFlag(tileIdGroup, "x", "Tile x coordinate", {'x'});
     args::ValueFlag<int32_t> yValueFlag(tileIdGroup, "y", "Tile y coordinate", {'y'});
     args::ValueFlag<int32_t> zValueFlag(tileIdGroup, "z", "The zoom level", {'z'});
 
+    args::Group trainGroup(p, "Dictionary training, instead of adding a resource");
+    args::ValueFlag<std::string> trainValue(trainGroup,
+                                            "dictionary",
+                                            "Train a zstd compression dictionary from the tiles in the cache and "
+                                            "write it to this path",
+                                            {"train-dictionary"});
+    args::ValueFlag<int64_t> samplesValue(
+        trainGroup, "samples", "Number of tiles to train from, 10000 otherwise", {"samples"});
+    args::ValueFlag<std::size_t> dictionarySizeValue(
+        trainGroup, "size", "Maximum dictionary size in bytes, 112640 otherwise", {"dictionary-size"});
+
     try {
         p.ParseCLI(argc, argv);
     } catch (const args::Help&) {
@@ -62,6 +114,19 @@ int main(int argc, char* argv[]) {
         exit(2);
     }
 
+    if (trainValue) {
+        return trainDictionary(args::get(cacheValue),
+                               args::get(trainValue),
+                               samplesValue ? args::get(samplesValue) : 10000,
+                               dictionarySizeValue ? args::get(dictionarySizeValue) : 112640);
+    }
+
+    if (!urlValue || !dataValue || !typeFlag) {
+        std::cerr << "Error: -u, -d and --type are required unless --train-dictionary is given" << std::endl;
+        std::cerr << p;
+        exit(1);
+    }
+
     auto file = mapbox::base::io::readFile(args::get(dataValue));
     if (!file) {
         std::cerr << file.error() << std::endl;
@@ -56,6 +56,14 @@ public:
         return future;
     }
 
+    // Returns the priority used for processing the messages sent to the actor.
+    TaskPriority getPriority() const {
+        if (auto mailbox = weakMailbox.lock()) {
+            return mailbox->getPriority();
+        }
+        return TaskPriority::Normal;
+    }
+
 private:
     Object* object;
     std::weak_ptr<Mailbox> weakMailbox;
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <mbgl/actor/scheduler.hpp>
 #include <mbgl/util/optional.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -11,7 +14,6 @@
 
 namespace mbgl {
 
-class Scheduler;
 class Message;
 
 class Mailbox : public std::enable_shared_from_this<Mailbox> {
@@ -33,22 +35,35 @@ public:
 
     bool isOpen() const;
 
+    // Sets the priority used when scheduling the processing of the queued messages.
+    // Messages that are already queued move to the new priority as well; it can be
+    // changed at any time and from any thread.
+    void setPriority(TaskPriority);
+    TaskPriority getPriority() const { return priority; }
+
     void push(std::unique_ptr<Message>);
     void receive();
 
-    static void maybeReceive(const std::weak_ptr<Mailbox>&);
-    static std::function<void()> makeClosure(std::weak_ptr<Mailbox>);
+    static void maybeReceive(const std::weak_ptr<Mailbox>&, uint64_t generation);
+    static std::function<void()> makeClosure(std::weak_ptr<Mailbox>, uint64_t generation);
 
 private:
+    // Must be called with the queue mutex held.
+    void schedule();
+
     mapbox::base::WeakPtr<Scheduler> weakScheduler;
 
     std::recursive_mutex receivingMutex;
     std::mutex pushingMutex;
 
     bool closed { false };
+    std::atomic<TaskPriority> priority { TaskPriority::Normal };
 
     std::mutex queueMutex;
     std::queue<std::unique_ptr<Message>> queue;
+    // Identifies the most recently scheduled closure. Changing the priority schedules a new
+    // closure; the one it supersedes does nothing when it runs.
+    uint64_t generation = 0;
 };
 
 } // namespace mbgl
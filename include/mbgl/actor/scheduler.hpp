@@ -4,6 +4,7 @@
 
 #include <mapbox/std/weak.hpp>
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -11,6 +12,14 @@ namespace mbgl {
 
 class Mailbox;
 
+// Relative priority of the tasks scheduled to a Scheduler. Tasks with a higher
+// priority are picked up before the ones with a lower priority.
+enum class TaskPriority : uint8_t {
+    High,
+    Normal,
+    Low
+};
+
 /*
     A `Scheduler` is responsible for coordinating the processing of messages by
     one or more actors via their mailboxes. It's an abstract interface. Currently,
@@ -24,7 +33,7 @@ class Mailbox;
         concurrency within a mailbox
 
       Subject to these constraints, processing can happen on whatever thread in the
-      pool is available.
+      pool is available. Idle threads steal work from the queues of busy ones.
 
     * `Scheduler::GetCurrent()` is typically used to create a mailbox and `ActorRef`
       for an object that lives on the main thread and is not itself wrapped an
@@ -39,6 +48,9 @@ public:
 
     // Enqueues a function for execution.
     virtual void schedule(std::function<void()>) = 0;
+    // Enqueues a function for execution with the given priority. Schedulers that
+    // don't support priorities execute it like any other function.
+    virtual void scheduleWithPriority(TaskPriority, std::function<void()> fn) { schedule(std::move(fn)); }
     // Makes a weak pointer to this Scheduler.
     virtual mapbox::base::WeakPtr<Scheduler> makeWeakPtr() = 0;
 
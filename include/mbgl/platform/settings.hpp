@@ -15,6 +15,38 @@ DECLARE_MAPBOX_SETTING(EXPERIMENTAL_THREAD_PRIORITY_FILE, thread_priority_file);
 DECLARE_MAPBOX_SETTING(EXPERIMENTAL_THREAD_PRIORITY_NETWORK, thread_priority_network);
 DECLARE_MAPBOX_SETTING(EXPERIMENTAL_THREAD_PRIORITY_DATABASE, thread_priority_database);
 
+// The value for EXPERIMENTAL_WORKER_THREADS_* keys, must be a positive integer.
+// Read once, when the shared background thread pool is created.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_WORKER_THREADS_MIN, worker_threads_min);
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_WORKER_THREADS_MAX, worker_threads_max);
+
+// The value for EXPERIMENTAL_PARALLEL_TILE_PARSING key, must be a boolean.
+// When true, the layer groups of a vector tile are parsed in parallel on the
+// background thread pool. Read when a tile is created.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_PARALLEL_TILE_PARSING, parallel_tile_parsing);
+
+// The value for EXPERIMENTAL_PLACEMENT_TIME_BUDGET key, must be a positive number of
+// milliseconds. When set, symbol placement in continuous map mode is split into slices of
+// about this duration that run on consecutive frames, and the previous placement stays in
+// use until the new one is complete. Read when a renderer is created.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_PLACEMENT_TIME_BUDGET, placement_time_budget);
+
+// The EXPERIMENTAL_HTTP_* keys are read once, when an HTTP file source is created, and are only
+// supported by the cURL based implementation. DNS lookups and TLS sessions are always shared
+// between requests.
+// The value for EXPERIMENTAL_HTTP_MULTIPLEXING key, must be a boolean. When true (the default),
+// HTTP/2 is negotiated for HTTPS requests, and concurrent requests to a host share a connection.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_HTTP_MULTIPLEXING, http_multiplexing);
+// The value for EXPERIMENTAL_HTTP_MAX_HOST_CONNECTIONS key, must be a positive integer. Requests
+// wait for a connection to a host once this many are open. Unlimited by default.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_HTTP_MAX_HOST_CONNECTIONS, http_max_host_connections);
+// The value for EXPERIMENTAL_HTTP_MAX_CONCURRENT_STREAMS key, must be a positive integer. The
+// number of requests that may share one HTTP/2 connection. Defaults to 100.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_HTTP_MAX_CONCURRENT_STREAMS, http_max_concurrent_streams);
+// The value for EXPERIMENTAL_HTTP_CONNECTION_CACHE_SIZE key, must be a positive integer. The
+// number of idle connections kept open for reuse.
+DECLARE_MAPBOX_SETTING(EXPERIMENTAL_HTTP_CONNECTION_CACHE_SIZE, http_connection_cache_size);
+
 // Settings class provides non-persistent, in-process key-value storage.
 class Settings final {
 public:
@@ -105,6 +105,19 @@ public:
     void reduceMemoryUse();
     void clearData();
 
+    /**
+     * @brief Limits the estimated bytes retained by the caches of recently used tiles that are
+     * no longer rendered. The budget is split evenly between the sources, so that their caches
+     * together stay within it; the least recently used tiles are evicted first. By default only
+     * the tile count limits the caches.
+     */
+    void setTileCacheMemoryBudget(std::size_t bytes);
+
+    /**
+     * @brief Returns the estimated bytes retained by the tile caches of all sources.
+     */
+    std::size_t getTileCacheMemoryUsage() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl;
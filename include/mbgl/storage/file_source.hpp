@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/resource_transform.hpp>
 #include <mbgl/storage/response.hpp>
 #include <mbgl/storage/resource_options.hpp>
@@ -12,7 +13,6 @@
 namespace mbgl {
 
 class AsyncRequest;
-class Resource;
 
 // TODO: Rename to ResourceProviderType
 enum FileSourceType : uint8_t {
@@ -62,6 +62,10 @@ public:
     // Checks whether a resource could be requested from this file source.
     virtual bool canRequest(const Resource&) const = 0;
 
+    // Changes the priority of a request returned by this file source, e.g. when a tile that was
+    // prefetched becomes visible. Requests keep the priority they were made with otherwise.
+    virtual void setPriority(AsyncRequest&, Resource::Priority) {}
+
     /*
      * Pause file request activity.
      *
@@ -110,10 +114,33 @@ constexpr const char* API_BASE_URL_KEY = "api-base-url";
 // type: unsigned
 constexpr const char* MAX_CONCURRENT_REQUESTS_KEY = "max-concurrent-requests";
 
+// Property name to set / get maximum number of concurrent requests that revalidate resources the requester already
+// has data for, e.g. expired tiles that are still being displayed. These requests also count towards the maximum
+// number of concurrent requests.
+// type: unsigned
+constexpr const char* MAX_CONCURRENT_REVALIDATIONS_KEY = "max-concurrent-revalidations";
+
 // Properties that may be supported by database file sources:
 
 // Property to set database mode. When set, database opens in read-only mode; database opens in read-write-create mode
 // otherwise. type: bool
 constexpr const char* READ_ONLY_MODE_KEY = "read-only-mode";
 
+// Property to batch ambient cache writes. When set, resources put into the ambient cache are committed in groups
+// shortly after they were received, instead of in one transaction each. type: bool
+constexpr const char* AMBIENT_CACHE_WRITE_BEHIND_KEY = "ambient-cache-write-behind";
+
+// Property to set the database journal mode. When set, the database uses a write-ahead log; a rollback journal
+// otherwise. type: bool
+constexpr const char* WAL_MODE_KEY = "wal-mode";
+
+// Property to relax database durability. When set, the database file is synced less often, and a power loss may roll
+// back the most recent writes; meant to be used together with WAL_MODE_KEY. type: bool
+constexpr const char* RELAXED_DURABILITY_KEY = "relaxed-durability";
+
+// Property to compress the resources written to the database with zstd, using the given dictionary unless it is
+// empty. Dictionaries are trained from typical tiles, e.g. with `mbgl-cache --train-dictionary`. Resources written
+// before stay readable. Requires a build with zstd. type: std::string
+constexpr const char* ZSTD_COMPRESSION_DICTIONARY_KEY = "zstd-compression-dictionary";
+
 } // namespace mbgl
@@ -17,6 +17,7 @@ private:
     // FileSource overrides
     std::unique_ptr<AsyncRequest> request(const Resource&, Callback) override;
     bool canRequest(const Resource&) const override;
+    void setPriority(AsyncRequest&, Resource::Priority) override;
     void pause() override;
     void resume() override;
     void setProperty(const std::string&, const mapbox::base::Value&) override;
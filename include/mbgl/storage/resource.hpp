@@ -23,10 +23,15 @@ public:
         Image
     };
 
-    enum class Priority : bool {
-        Regular,
-        Low
+    // Queued network requests are started from the highest priority that has any, and in the
+    // order they were made within one priority.
+    enum class Priority : uint8_t {
+        High,     // Resources needed by many tiles, such as glyphs and sprites.
+        Regular,  // Tiles covering the viewport and everything else by default.
+        Prefetch, // Tiles that are loaded before they become visible.
+        Low       // Offline downloads and revalidations of usable cached resources.
     };
+    static constexpr std::size_t PriorityCount = 4;
 
     enum class Usage : bool {
         Online,
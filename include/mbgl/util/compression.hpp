@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace mbgl {
 namespace util {
@@ -8,5 +11,40 @@ namespace util {
 std::string compress(const std::string& raw);
 std::string decompress(const std::string& raw);
 
+// Identifies how a payload is compressed. The values are persisted by the offline database
+// and must not change.
+enum class CompressionCodec : uint8_t {
+    None = 0,
+    Zlib = 1,
+    Zstd = 2,
+};
+
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    virtual CompressionCodec type() const = 0;
+    virtual std::string compress(const std::string& raw) const = 0;
+    virtual std::string decompress(const std::string& compressed) const = 0;
+};
+
+// Returns whether the codec is available in this build. Zlib always is.
+bool isCodecAvailable(CompressionCodec);
+
+// Creates a codec, using the dictionary if it isn't empty. Only Zstd supports dictionaries,
+// which must be created with trainDictionary(). Payloads compressed with a dictionary can only be
+// decompressed with the same one. Throws std::runtime_error if the codec isn't available.
+std::unique_ptr<Codec> makeCodec(CompressionCodec, const std::string& dictionary = {});
+
+// Trains a Zstd dictionary of at most maxSize bytes from sample payloads, e.g. tiles of the
+// tileset it is going to be used for. Throws std::runtime_error if Zstd isn't available or there
+// are too few samples to train from.
+std::string trainDictionary(const std::vector<std::string>& samples, std::size_t maxSize);
+
+// Returns the ID of a trained dictionary, or of the dictionary a Zstd payload was compressed
+// with; 0 if there is none.
+uint32_t getDictionaryID(const std::string& dictionary);
+uint32_t getPayloadDictionaryID(const std::string& compressed);
+
 } // namespace util
 } // namespace mbgl
@@ -63,6 +63,7 @@ constexpr const char* ASSET_PROTOCOL = "asset://";
 constexpr const char* FILE_PROTOCOL = "file://";
 constexpr const char* MBTILES_PROTOCOL = "mbtiles://";
 constexpr uint32_t DEFAULT_MAXIMUM_CONCURRENT_REQUESTS = 20;
+constexpr uint32_t DEFAULT_MAXIMUM_CONCURRENT_REVALIDATIONS = 4;
 
 constexpr uint8_t TERRAIN_RGB_MAXZOOM = 15;
 
@@ -5,14 +5,19 @@
 #include <mbgl/util/tile_server_options.hpp>
 #include <mbgl/util/exception.hpp>
 #include <mbgl/util/optional.hpp>
+#include <mbgl/util/compression.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/mapbox.hpp>
 #include <mbgl/util/expected.hpp>
 
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace mapbox {
 namespace sqlite {
@@ -38,7 +43,23 @@ struct MapboxTileLimitExceededException :  util::Exception {
 
 class OfflineDatabase {
 public:
-    OfflineDatabase(std::string path, const TileServerOptions& options);
+    // The rollback journal is replaced by a write-ahead log in WAL mode, so that writers
+    // don't block readers and commits append to the log instead of rewriting pages.
+    enum class JournalMode : uint8_t {
+        Delete,
+        WAL
+    };
+
+    // Full syncs the database file on every commit. Normal syncs less often; in WAL mode, a
+    // power loss may roll back the most recent commits but never corrupts the database.
+    enum class Durability : uint8_t {
+        Full,
+        Normal
+    };
+
+    // A read-only database never creates, migrates or deletes the database file, and can be used
+    // alongside a writable one for the same file.
+    OfflineDatabase(std::string path, const TileServerOptions& options, bool readOnly = false);
     ~OfflineDatabase();
 
     void changePath(const std::string&);
@@ -46,9 +67,17 @@ public:
 
     optional<Response> get(const Resource&);
 
+    // Records a cache hit that was served by another, read-only, connection, so that eviction
+    // takes it into account.
+    void markAccessed(const Resource&);
+
     // Return value is (inserted, stored size)
     std::pair<bool, uint64_t> put(const Resource&, const Response&);
 
+    // Inserts the resources into the ambient cache like put(), but within a single transaction.
+    // Returns false if the transaction failed, in which case none of them has been written.
+    bool putAmbientResources(const std::list<std::tuple<Resource, Response>>&);
+
     // Force Mapbox GL Native to revalidate tiles stored in the ambient
     // cache with the tile server before using them, making sure they
     // are the latest version. This is more efficient than cleaning the
@@ -77,9 +106,16 @@ public:
     // Return value is (response, stored size)
     optional<std::pair<Response, uint64_t>> getRegionResource(const Resource&);
     optional<int64_t> hasRegionResource(const Resource&);
+    // Looks up the stored sizes of many resources at once, e.g. to skip the ones that a download
+    // doesn't need to request. Tiles of the same tileset and zoom level share a single query.
+    std::vector<optional<int64_t>> hasRegionResources(const std::vector<Resource>&);
     uint64_t putRegionResource(int64_t regionID, const Resource&, const Response&);
     void putRegionResources(int64_t regionID, const std::list<std::tuple<Resource, Response>>&, OfflineRegionStatus&);
 
+    // Called before region resources are written, e.g. to write out ambient resources that are
+    // still queued, so that they can't replace the newer region data afterwards.
+    void setBeforeRegionWrite(std::function<void()> callback) { beforeRegionWrite = std::move(callback); }
+
     expected<OfflineRegionDefinition, std::exception_ptr> getRegionDefinition(int64_t regionID);
     expected<OfflineRegionStatus, std::exception_ptr> getRegionCompletedStatus(int64_t regionID);
 
@@ -95,6 +131,15 @@ public:
 
     void reopenDatabaseReadOnly(bool readOnly);
 
+    // Both settings are kept for the lifetime of this object, i.e. they are also applied when
+    // the database is changed or reset.
+    std::exception_ptr setJournalMode(JournalMode);
+    std::exception_ptr setDurability(Durability);
+
+    // Sets the codec new entries are compressed with, optionally with a dictionary trained by
+    // util::trainDictionary(). Entries written before stay readable. Deflate is the default.
+    std::exception_ptr setCompressionCodec(util::CompressionCodec, std::string dictionary = {});
+
 private:
     class DatabaseSizeChangeStats;
 
@@ -110,22 +155,26 @@ private:
     void migrateToVersion5();
     void migrateToVersion3();
     void migrateToVersion6();
+    void migrateToVersion7();
     void cleanup();
     bool disabled();
     void vacuum();
     void checkFlags();
+    void applyJournalSettings();
+    void storeCompressionDictionary(const std::string& dictionary);
+    const util::Codec& getDecoder(util::CompressionCodec, const std::string& data);
 
     mapbox::sqlite::Statement& getStatement(const char *);
 
     optional<std::pair<Response, uint64_t>> getTile(const Resource::TileData&);
     optional<int64_t> hasTile(const Resource::TileData&);
     bool putTile(const Resource::TileData&, const Response&,
-                 const std::string&, bool compressed);
+                 const std::string&, util::CompressionCodec);
 
     optional<std::pair<Response, uint64_t>> getResource(const Resource&);
     optional<int64_t> hasResource(const Resource&);
     bool putResource(const Resource&, const Response&,
-                     const std::string&, bool compressed);
+                     const std::string&, util::CompressionCodec);
 
     uint64_t putRegionResourceInternal(int64_t regionID, const Resource&, const Response&);
 
@@ -153,6 +202,16 @@ private:
 
     bool evict(uint64_t neededFreeSize, DatabaseSizeChangeStats& stats);
 
+    // Accessed timestamps of cache hits are kept in memory so that reads don't write to the
+    // database, and are written in bulk before they're needed for eviction.
+    void recordResourceAccess(const std::string& url);
+    void recordTileAccess(const Resource::TileData&);
+    void flushAccessedTimestampsIfNeeded();
+    void flushAccessedTimestamps();
+    std::map<std::string, Timestamp> pendingResourceAccesses;
+    std::map<std::tuple<std::string, uint8_t, int32_t, int32_t, int8_t>, Timestamp> pendingTileAccesses;
+    optional<Timestamp> firstPendingAccess;
+
     TileServerOptions tileServerOptions;
 
     class DatabaseSizeChangeStats {
@@ -186,6 +245,15 @@ private:
 
     bool autopack = true;
     bool readOnly = false;
+    std::function<void()> beforeRegionWrite;
+    JournalMode journalMode = JournalMode::Delete;
+    Durability durability = Durability::Full;
+
+    // Zstd decoders are keyed by the ID of their dictionary, 0 for none.
+    std::string compressionDictionary;
+    std::unique_ptr<util::Codec> encoder = util::makeCodec(util::CompressionCodec::Zlib);
+    const std::unique_ptr<util::Codec> zlibDecoder = util::makeCodec(util::CompressionCodec::Zlib);
+    std::unordered_map<uint32_t, std::unique_ptr<util::Codec>> decoders;
 };
 
 } // namespace mbgl
@@ -3,6 +3,8 @@
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/storage/offline.hpp>
 #include <mbgl/storage/resource.hpp>
+#include <mbgl/util/chrono.hpp>
+#include <mbgl/util/optional.hpp>
 
 #include <list>
 #include <unordered_set>
@@ -49,6 +51,17 @@ private:
      */
     void ensureResource(Resource&&, std::function<void (Response)> = {});
 
+    /*
+     * Looks up the next batch of queued resources in the database at once, and queues the ones
+     * that are missing to be requested.
+     */
+    void checkResources();
+    void requestResource(Resource&&, std::function<void(Response)> = {});
+    void addCompletedResource(Resource::Kind, uint64_t size);
+
+    uint32_t maximumConcurrentRequests() const;
+    void updateConcurrencyLimit(Duration latency);
+
     void onMapboxTileCountLimitExceeded();
 
     int64_t id;
@@ -61,8 +74,16 @@ private:
     std::list<std::unique_ptr<AsyncRequest>> requests;
     std::set<std::string> requiredSourceURLs;
     std::deque<Resource> resourcesRemaining;
+    std::deque<Resource> resourcesToRequest;
+    std::unique_ptr<AsyncRequest> resourcesCheck;
     std::list<Resource> resourcesToBeMarkedAsUsed;
     std::list<std::tuple<Resource, Response>> buffer;
+    std::size_t bufferSize = 0;
+
+    uint32_t concurrencyLimit = 0;
+    uint32_t latencySamples = 0;
+    optional<Duration> minimumLatency;
+    optional<Duration> averageLatency;
 
     void queueResource(Resource&&);
     void queueTiles(style::SourceType, uint16_t tileSize, const Tileset&);
@@ -50,6 +50,10 @@ static constexpr const char* offlineDatabaseSchema =
 "  tile_id INTEGER NOT NULL REFERENCES tiles(id),\n"
 "  UNIQUE (region_id, tile_id)\n"
 ");\n"
+"CREATE TABLE compression_dictionaries (\n"
+"  id INTEGER NOT NULL PRIMARY KEY,\n"
+"  data BLOB NOT NULL\n"
+");\n"
 "CREATE INDEX resources_accessed\n"
 "ON resources (accessed);\n"
 "CREATE INDEX tiles_accessed\n"
@@ -29,10 +29,16 @@ CREATE TABLE resources (
 
   data BLOB,                                       -- Contents of the resource.
 
-  compressed INTEGER NOT NULL DEFAULT 0,           -- If the resource is compressed with Deflate or not. Compression is
-                                                   -- optional and should be used when the compression ratio is
-                                                   -- significant. Using compression will make decoding time slower
-                                                   -- because it will add an extra decompression step.
+  compressed INTEGER NOT NULL DEFAULT 0,           -- Codec the resource is compressed with, taken from
+                                                   -- util::CompressionCodec enumeration:
+                                                   -- none    = 0
+                                                   -- deflate = 1
+                                                   -- zstd    = 2, possibly with a dictionary from
+                                                   --           compression_dictionaries
+                                                   -- Compression is optional and should be used when the
+                                                   -- compression ratio is significant. Using compression will make
+                                                   -- decoding time slower because it will add an extra
+                                                   -- decompression step.
 
   accessed INTEGER NOT NULL,                       -- Last time the resource was used by GL Native. Useful for when
                                                    -- evicting the least used resources from the cache.
@@ -74,10 +80,16 @@ CREATE TABLE tiles (
 
   data BLOB,                                       -- Contents of the tile.
 
-  compressed INTEGER NOT NULL DEFAULT 0,           -- If the tile is compressed with Deflate or not. Compression is
-                                                   -- optional and should be used when the compression ratio is
-                                                   -- significant. Using compression will make decoding time slower
-                                                   -- because it will add an extra decompression step.
+  compressed INTEGER NOT NULL DEFAULT 0,           -- Codec the tile is compressed with, taken from
+                                                   -- util::CompressionCodec enumeration:
+                                                   -- none    = 0
+                                                   -- deflate = 1
+                                                   -- zstd    = 2, possibly with a dictionary from
+                                                   --           compression_dictionaries
+                                                   -- Compression is optional and should be used when the
+                                                   -- compression ratio is significant. Using compression will make
+                                                   -- decoding time slower because it will add an extra
+                                                   -- decompression step.
 
   accessed INTEGER NOT NULL,                       -- Last time the tile was used by GL Native. Useful for when
                                                    -- evicting the least used tiles from the cache.
@@ -148,6 +160,17 @@ CREATE TABLE region_tiles (
   UNIQUE (region_id, tile_id)
 );
 
+--
+-- Dictionaries that resources and tiles compressed with zstd may
+-- have been compressed with. A compressed payload refers to its
+-- dictionary by the ID that zstd stores in it.
+--
+CREATE TABLE compression_dictionaries (
+  id INTEGER NOT NULL PRIMARY KEY,                  -- Dictionary ID assigned by zstd when training the dictionary.
+
+  data BLOB NOT NULL                                -- Contents of the dictionary.
+);
+
 --
 -- Indexes for efficient eviction queries.
 --
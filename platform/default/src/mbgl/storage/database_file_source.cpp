@@ -9,67 +9,293 @@
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/logging.hpp>
 #include <mbgl/util/platform.hpp>
+#include <mbgl/util/string.hpp>
 #include <mbgl/util/thread.hpp>
+#include <mbgl/util/timer.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <list>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace mbgl {
+
+namespace {
+
+// In write-behind mode, ambient cache writes are committed together once this many are
+// pending, or when the oldest of them has waited for the delay.
+constexpr std::size_t WRITE_BEHIND_BATCH_SIZE = 64;
+constexpr Milliseconds WRITE_BEHIND_DELAY{500};
+
+// Whether both resources are stored in the same database row.
+bool isSameResource(const Resource& a, const Resource& b) {
+    if (a.kind == Resource::Kind::Tile || b.kind == Resource::Kind::Tile) {
+        if (a.kind != b.kind || !a.tileData || !b.tileData) {
+            return false;
+        }
+        const auto& lhs = *a.tileData;
+        const auto& rhs = *b.tileData;
+        return lhs.urlTemplate == rhs.urlTemplate && lhs.pixelRatio == rhs.pixelRatio && lhs.x == rhs.x &&
+               lhs.y == rhs.y && lhs.z == rhs.z;
+    }
+    return a.url == b.url;
+}
+
+// Resources stored in the same database row have the same key.
+std::string getResourceKey(const Resource& resource) {
+    if (resource.kind == Resource::Kind::Tile && resource.tileData) {
+        const auto& tile = *resource.tileData;
+        return tile.urlTemplate + '\n' + util::toString(tile.pixelRatio) + '/' + util::toString(tile.z) + '/' +
+               util::toString(tile.x) + '/' + util::toString(tile.y);
+    }
+    return resource.url;
+}
+
+// In-memory databases can't be shared between connections.
+bool isInMemoryDatabase(const std::string& path) {
+    return path == ":memory:" || path.find("mode=memory") != std::string::npos;
+}
+
+// Applies what a "not modified" response changes about a stored resource.
+void applyNotModified(Response& response, const Response& notModified) {
+    response.expires = notModified.expires;
+    response.mustRevalidate = notModified.mustRevalidate;
+}
+
+void respond(optional<Response> offlineResponse, const ActorRef<FileSourceRequest>& req) {
+    if (!offlineResponse) {
+        offlineResponse.emplace();
+        offlineResponse->noContent = true;
+        offlineResponse->error =
+            std::make_unique<Response::Error>(Response::Error::Reason::NotFound, "Not found in offline database");
+    } else if (!offlineResponse->isUsable()) {
+        offlineResponse->error =
+            std::make_unique<Response::Error>(Response::Error::Reason::NotFound, "Cached resource is unusable");
+    }
+    req.invoke(&FileSourceRequest::setResponse, *offlineResponse);
+}
+
+// Shared between the writer and the readers of one database.
+class DatabaseState {
+public:
+    // Writes are visible to requests as soon as they are forwarded, before they are committed.
+    uint64_t addPendingWrite(const Resource& resource, const Response& response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingWrites.emplace(++lastWriteID, std::make_tuple(resource, response));
+        pendingWriteIDs[getResourceKey(resource)].push_back(lastWriteID);
+        return lastWriteID;
+    }
+
+    void removePendingWrite(uint64_t writeID) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pendingWrites.find(writeID);
+        if (it == pendingWrites.end()) {
+            return;
+        }
+
+        auto ids = pendingWriteIDs.find(getResourceKey(std::get<0>(it->second)));
+        assert(ids != pendingWriteIDs.end());
+        ids->second.erase(std::find(ids->second.begin(), ids->second.end(), writeID));
+        if (ids->second.empty()) {
+            pendingWriteIDs.erase(ids);
+        }
+        pendingWrites.erase(it);
+    }
+
+    // Returns the newest pending write of the resource, refreshed by any newer "not modified"
+    // response. If only a "not modified" response is pending, it is returned as is, and has to
+    // be applied to the stored resource with applyNotModified().
+    optional<Response> getPendingWrite(const Resource& resource) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto ids = pendingWriteIDs.find(getResourceKey(resource));
+        if (ids == pendingWriteIDs.end()) {
+            return nullopt;
+        }
+
+        optional<Response> notModified;
+        for (auto id = ids->second.rbegin(); id != ids->second.rend(); ++id) {
+            const auto& write = pendingWrites.at(*id);
+            const Response& response = std::get<1>(write);
+            if (response.error || !isSameResource(std::get<0>(write), resource)) {
+                continue;
+            }
+            if (response.notModified) {
+                if (!notModified) {
+                    notModified = response;
+                }
+                continue;
+            }
+            if (!notModified) {
+                return response;
+            }
+            Response refreshed = response;
+            applyNotModified(refreshed, *notModified);
+            return refreshed;
+        }
+        return notModified;
+    }
+
+    // Readers are only enabled while the writer has the database open, and they reopen their
+    // connections whenever the generation changes.
+    void setDatabase(const std::string& path_, bool readersEnabled_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = path_;
+        readersEnabled = readersEnabled_;
+        ++generation;
+    }
+
+    bool getDatabase(std::string& path_, uint64_t& generation_) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        path_ = path;
+        generation_ = generation;
+        return readersEnabled && !exclusiveOperations;
+    }
+
+    // Operations that change what is stored, like clearing the cache, begin when they are
+    // requested and end once the writer has run them. Readers hand their requests to the
+    // writer in the meantime, so that requests made after such an operation see its result.
+    void beginExclusiveOperation() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++exclusiveOperations;
+    }
+
+    void endExclusiveOperation() {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(exclusiveOperations);
+        --exclusiveOperations;
+    }
+
+private:
+    mutable std::mutex mutex;
+    uint64_t lastWriteID = 0;
+    std::map<uint64_t, std::tuple<Resource, Response>> pendingWrites;
+    // IDs of the pending writes of each resource key, oldest first.
+    std::unordered_map<std::string, std::vector<uint64_t>> pendingWriteIDs;
+    std::string path;
+    bool readersEnabled = false;
+    uint64_t generation = 0;
+    std::size_t exclusiveOperations = 0;
+};
+
+} // namespace
+
 class DatabaseFileSourceThread {
 public:
-    DatabaseFileSourceThread(std::shared_ptr<FileSource> onlineFileSource_, const std::string& cachePath)
+    DatabaseFileSourceThread(std::shared_ptr<FileSource> onlineFileSource_,
+                             const std::string& cachePath,
+                             std::shared_ptr<DatabaseState> state_)
         : db(std::make_unique<OfflineDatabase>(
             cachePath,
             onlineFileSource_->getResourceOptions().tileServerOptions())
-        ), onlineFileSource(std::move(onlineFileSource_)) {}
+        ), onlineFileSource(std::move(onlineFileSource_)), state(std::move(state_)), path(cachePath) {
+        db->setBeforeRegionWrite([this] { flushPendingPuts(); });
+        reopenReaders();
+    }
+
+    ~DatabaseFileSourceThread() {
+        flushPendingPuts();
+        state->setDatabase({}, false);
+    }
 
     void request(const Resource& resource, const ActorRef<FileSourceRequest>& req) {
-        optional<Response> offlineResponse =
-            (resource.storagePolicy != Resource::StoragePolicy::Volatile) ? db->get(resource) : nullopt;
-        if (!offlineResponse) {
-            offlineResponse.emplace();
-            offlineResponse->noContent = true;
-            offlineResponse->error =
-                std::make_unique<Response::Error>(Response::Error::Reason::NotFound, "Not found in offline database");
-        } else if (!offlineResponse->isUsable()) {
-            offlineResponse->error =
-                std::make_unique<Response::Error>(Response::Error::Reason::NotFound, "Cached resource is unusable");
-        }
-        req.invoke(&FileSourceRequest::setResponse, *offlineResponse);
-    }
-
-    void setDatabasePath(const std::string& path, const std::function<void()>& callback) {
-        db->changePath(path);
+        optional<Response> offlineResponse;
+        if (resource.storagePolicy != Resource::StoragePolicy::Volatile) {
+            auto pendingWrite = state->getPendingWrite(resource);
+            if (pendingWrite && !pendingWrite->notModified) {
+                offlineResponse = std::move(pendingWrite);
+            } else {
+                offlineResponse = db->get(resource);
+                if (offlineResponse && pendingWrite) {
+                    applyNotModified(*offlineResponse, *pendingWrite);
+                }
+            }
+        }
+        respond(std::move(offlineResponse), req);
+    }
+
+    void markAccessed(const Resource& resource) { db->markAccessed(resource); }
+
+    void setDatabasePath(const std::string& path_, const std::function<void()>& callback) {
+        flushPendingPuts();
+        db->changePath(path_);
+        path = path_;
+        reopenReaders();
+        state->endExclusiveOperation();
         if (callback) {
             callback();
         }
     }
 
-    void forward(const Resource& resource, const Response& response, const std::function<void()>& callback) {
+    void forward(const Resource& resource,
+                 const Response& response,
+                 uint64_t writeID,
+                 const std::function<void()>& callback) {
+        if (writeBehind) {
+            queuePut(resource, response, writeID, callback);
+            return;
+        }
         db->put(resource, response);
+        state->removePendingWrite(writeID);
         if (callback) {
             callback();
         }
     }
 
-    void resetDatabase(const std::function<void(std::exception_ptr)>& callback) { callback(db->resetDatabase()); }
+    void resetDatabase(const std::function<void(std::exception_ptr)>& callback) {
+        flushPendingPuts();
+        auto result = db->resetDatabase();
+        reopenReaders();
+        state->endExclusiveOperation();
+        callback(result);
+    }
 
-    void packDatabase(const std::function<void(std::exception_ptr)>& callback) { callback(db->pack()); }
+    void packDatabase(const std::function<void(std::exception_ptr)>& callback) {
+        flushPendingPuts();
+        callback(db->pack());
+    }
 
     void runPackDatabaseAutomatically(bool autopack) { db->runPackDatabaseAutomatically(autopack); }
 
-    void put(const Resource& resource, const Response& response) { db->put(resource, response); }
+    void put(const Resource& resource, const Response& response, uint64_t writeID) {
+        if (writeBehind) {
+            queuePut(resource, response, writeID, nullptr);
+            return;
+        }
+        db->put(resource, response);
+        state->removePendingWrite(writeID);
+    }
 
     void invalidateAmbientCache(const std::function<void(std::exception_ptr)>& callback) {
-        callback(db->invalidateAmbientCache());
+        flushPendingPuts();
+        auto result = db->invalidateAmbientCache();
+        state->endExclusiveOperation();
+        callback(result);
     }
 
     void clearAmbientCache(const std::function<void(std::exception_ptr)>& callback) {
-        callback(db->clearAmbientCache());
+        flushPendingPuts();
+        auto result = db->clearAmbientCache();
+        reopenReaders();
+        state->endExclusiveOperation();
+        callback(result);
     }
 
     void setMaximumAmbientCacheSize(uint64_t size, const std::function<void(std::exception_ptr)>& callback) {
-        callback(db->setMaximumAmbientCacheSize(size));
+        flushPendingPuts();
+        auto result = db->setMaximumAmbientCacheSize(size);
+        if (!result) {
+            ambientCacheEnabled = size != 0;
+            reopenReaders();
+        }
+        state->endExclusiveOperation();
+        callback(result);
     }
 
     void listRegions(const std::function<void(expected<OfflineRegions, std::exception_ptr>)>& callback) {
@@ -84,7 +310,10 @@ public:
 
     void mergeOfflineRegions(const std::string& sideDatabasePath,
                              const std::function<void(expected<OfflineRegions, std::exception_ptr>)>& callback) {
-        callback(db->mergeDatabase(sideDatabasePath));
+        flushPendingPuts();
+        auto result = db->mergeDatabase(sideDatabasePath);
+        state->endExclusiveOperation();
+        callback(std::move(result));
     }
 
     void updateMetadata(const int64_t regionID,
@@ -103,12 +332,18 @@ public:
     }
 
     void deleteRegion(OfflineRegion region, const std::function<void(std::exception_ptr)>& callback) {
+        flushPendingPuts();
         downloads.erase(region.getID());
-        callback(db->deleteRegion(std::move(region)));
+        auto result = db->deleteRegion(std::move(region));
+        state->endExclusiveOperation();
+        callback(result);
     }
 
     void invalidateRegion(int64_t regionID, const std::function<void(std::exception_ptr)>& callback) {
-        callback(db->invalidateRegion(regionID));
+        flushPendingPuts();
+        auto result = db->invalidateRegion(regionID);
+        state->endExclusiveOperation();
+        callback(result);
     }
 
     void setRegionObserver(int64_t regionID, std::unique_ptr<OfflineRegionObserver> observer) {
@@ -125,9 +360,77 @@ public:
 
     void setOfflineMapboxTileCountLimit(uint64_t limit) { db->setOfflineMapboxTileCountLimit(limit); }
 
-    void reopenDatabaseReadOnly(bool readOnly) { db->reopenDatabaseReadOnly(readOnly); }
+    void reopenDatabaseReadOnly(bool readOnly) {
+        flushPendingPuts();
+        db->reopenDatabaseReadOnly(readOnly);
+        reopenReaders();
+    }
+
+    void setWriteBehind(bool enabled) {
+        writeBehind = enabled;
+        if (!writeBehind) {
+            flushPendingPuts();
+        }
+    }
+
+    void setJournalMode(OfflineDatabase::JournalMode mode) {
+        flushPendingPuts();
+        db->setJournalMode(mode);
+    }
+
+    void setDurability(OfflineDatabase::Durability durability) { db->setDurability(durability); }
+
+    void setCompressionCodec(util::CompressionCodec codec, const std::string& dictionary) {
+        db->setCompressionCodec(codec, dictionary);
+    }
 
 private:
+    void queuePut(const Resource& resource, const Response& response, uint64_t writeID, std::function<void()> callback) {
+        pendingPuts.emplace_back(resource, response);
+        pendingWriteIDs.push_back(writeID);
+        if (callback) {
+            pendingCallbacks.push_back(std::move(callback));
+        }
+
+        if (pendingPuts.size() >= WRITE_BEHIND_BATCH_SIZE) {
+            flushPendingPuts();
+        } else if (pendingPuts.size() == 1) {
+            flushTimer.start(WRITE_BEHIND_DELAY, Duration::zero(), [this] { flushPendingPuts(); });
+        }
+    }
+
+    void flushPendingPuts() {
+        if (pendingPuts.empty()) {
+            return;
+        }
+
+        flushTimer.stop();
+        if (!db->putAmbientResources(pendingPuts)) {
+            // One bad entry or a transient error must not lose the whole batch.
+            Log::Warning(Event::Database,
+                         "Writing %zu cached resources in a batch failed, writing them one by one",
+                         pendingPuts.size());
+            for (const auto& put : pendingPuts) {
+                db->put(std::get<0>(put), std::get<1>(put));
+            }
+        }
+        pendingPuts.clear();
+        for (const auto writeID : pendingWriteIDs) {
+            state->removePendingWrite(writeID);
+        }
+        pendingWriteIDs.clear();
+
+        auto callbacks = std::move(pendingCallbacks);
+        pendingCallbacks.clear();
+        for (const auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    // Without an ambient cache, only region resources may be served, which the readers can't tell
+    // apart, so all requests go to the writer.
+    void reopenReaders() { state->setDatabase(path, ambientCacheEnabled && !isInMemoryDatabase(path)); }
+
     expected<OfflineDownload*, std::exception_ptr> getDownload(int64_t regionID) {
         if (!onlineFileSource) {
             return unexpected<std::exception_ptr>(
@@ -150,22 +453,119 @@ private:
     std::unique_ptr<OfflineDatabase> db;
     std::map<int64_t, std::unique_ptr<OfflineDownload>> downloads;
     std::shared_ptr<FileSource> onlineFileSource;
+    std::shared_ptr<DatabaseState> state;
+    std::string path;
+    bool ambientCacheEnabled = true;
+
+    bool writeBehind = false;
+    std::list<std::tuple<Resource, Response>> pendingPuts;
+    std::vector<uint64_t> pendingWriteIDs;
+    std::vector<std::function<void()>> pendingCallbacks;
+    util::Timer flushTimer;
+};
+
+// Serves requests on a read-only connection of its own, so that cache lookups run in parallel
+// and don't queue behind writes. Requests that can't be served this way go to the writer.
+class DatabaseFileSourceReader {
+public:
+    DatabaseFileSourceReader(TileServerOptions tileServerOptions_,
+                             std::shared_ptr<DatabaseState> state_,
+                             ActorRef<DatabaseFileSourceThread> writer_)
+        : tileServerOptions(std::move(tileServerOptions_)), state(std::move(state_)), writer(std::move(writer_)) {}
+
+    void request(const Resource& resource, const ActorRef<FileSourceRequest>& req) {
+        if (resource.storagePolicy == Resource::StoragePolicy::Volatile) {
+            respond(nullopt, req);
+            return;
+        }
+
+        std::string path;
+        uint64_t generation;
+        if (!state->getDatabase(path, generation)) {
+            db.reset();
+            writer.invoke(&DatabaseFileSourceThread::request, resource, req);
+            return;
+        }
+
+        auto pendingWrite = state->getPendingWrite(resource);
+        if (pendingWrite && !pendingWrite->notModified) {
+            respond(std::move(pendingWrite), req);
+            return;
+        }
+
+        if (!db || generation != dbGeneration) {
+            db = std::make_unique<OfflineDatabase>(path, tileServerOptions, true);
+            dbGeneration = generation;
+        }
+
+        auto offlineResponse = db->get(resource);
+        if (offlineResponse) {
+            if (pendingWrite) {
+                applyNotModified(*offlineResponse, *pendingWrite);
+            }
+            writer.invoke(&DatabaseFileSourceThread::markAccessed, resource);
+        }
+        respond(std::move(offlineResponse), req);
+    }
+
+private:
+    const TileServerOptions tileServerOptions;
+    std::shared_ptr<DatabaseState> state;
+    ActorRef<DatabaseFileSourceThread> writer;
+
+    std::unique_ptr<OfflineDatabase> db;
+    uint64_t dbGeneration = 0;
 };
 
 class DatabaseFileSource::Impl {
 public:
-    Impl(std::shared_ptr<FileSource> onlineFileSource, const ResourceOptions& options) :
-        thread(std::make_unique<util::Thread<DatabaseFileSourceThread>>(
-              util::makeThreadPrioritySetter(platform::EXPERIMENTAL_THREAD_PRIORITY_DATABASE),
-              "DatabaseFileSource",
-              std::move(onlineFileSource),
-              options.cachePath())),
-        resourceOptions(options.clone()) {}
+    Impl(std::shared_ptr<FileSource> onlineFileSource, const ResourceOptions& options)
+        : state(std::make_shared<DatabaseState>()), resourceOptions(options.clone()) {
+        const TileServerOptions tileServerOptions = onlineFileSource->getResourceOptions().tileServerOptions();
+        thread = std::make_unique<util::Thread<DatabaseFileSourceThread>>(
+            util::makeThreadPrioritySetter(platform::EXPERIMENTAL_THREAD_PRIORITY_DATABASE),
+            "DatabaseFileSource",
+            std::move(onlineFileSource),
+            options.cachePath(),
+            state);
+
+        const std::size_t readerCount = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+        for (std::size_t i = 0; i < readerCount; ++i) {
+            readers.emplace_back(std::make_unique<util::Thread<DatabaseFileSourceReader>>(
+                util::makeThreadPrioritySetter(platform::EXPERIMENTAL_THREAD_PRIORITY_DATABASE),
+                "DatabaseFileSourceReader",
+                tileServerOptions,
+                state,
+                thread->actor()));
+        }
+    }
 
     ActorRef<DatabaseFileSourceThread> actor() const { return thread->actor(); }
 
-    void pause() { thread->pause(); }
-    void resume() { thread->resume(); }
+    ActorRef<DatabaseFileSourceReader> reader() {
+        return readers[nextReader++ % readers.size()]->actor();
+    }
+
+    uint64_t addPendingWrite(const Resource& resource, const Response& response) {
+        return state->addPendingWrite(resource, response);
+    }
+
+    // Must be followed by a writer operation that ends it.
+    void beginExclusiveOperation() { state->beginExclusiveOperation(); }
+
+    void pause() {
+        thread->pause();
+        for (auto& reader : readers) {
+            reader->pause();
+        }
+    }
+
+    void resume() {
+        for (auto& reader : readers) {
+            reader->resume();
+        }
+        thread->resume();
+    }
 
     void setResourceOptions(ResourceOptions options) {
         std::lock_guard<std::mutex> lock(resourceOptionsMutex);
@@ -178,7 +578,11 @@ public:
     }
 
 private:
-    const std::unique_ptr<util::Thread<DatabaseFileSourceThread>> thread;
+    const std::shared_ptr<DatabaseState> state;
+    std::unique_ptr<util::Thread<DatabaseFileSourceThread>> thread;
+    // Declared after the writer, so that they are destroyed before it.
+    std::vector<std::unique_ptr<util::Thread<DatabaseFileSourceReader>>> readers;
+    std::atomic<std::size_t> nextReader{0};
     mutable std::mutex resourceOptionsMutex;
     ResourceOptions resourceOptions;
 };
@@ -192,7 +596,7 @@ DatabaseFileSource::~DatabaseFileSource() = default;
 
 std::unique_ptr<AsyncRequest> DatabaseFileSource::request(const Resource& resource, Callback callback) {
     auto req = std::make_unique<FileSourceRequest>(std::move(callback));
-    impl->actor().invoke(&DatabaseFileSourceThread::request, resource, req->actor());
+    impl->reader().invoke(&DatabaseFileSourceReader::request, resource, req->actor());
     return req;
 }
 
@@ -203,7 +607,11 @@ void DatabaseFileSource::forward(const Resource& res, const Response& response,
     if (callback) {
         wrapper = Scheduler::GetCurrent()->bindOnce(std::move(callback));
     }
-    impl->actor().invoke(&DatabaseFileSourceThread::forward, res, response, std::move(wrapper));
+    impl->actor().invoke(&DatabaseFileSourceThread::forward,
+                         res,
+                         response,
+                         impl->addPendingWrite(res, response),
+                         std::move(wrapper));
 }
 
 bool DatabaseFileSource::canRequest(const Resource& resource) const {
@@ -213,10 +621,12 @@ bool DatabaseFileSource::canRequest(const Resource& resource) const {
 }
 
 void DatabaseFileSource::setDatabasePath(const std::string& path, std::function<void()> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::setDatabasePath, path, std::move(callback));
 }
 
 void DatabaseFileSource::resetDatabase(std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::resetDatabase, std::move(callback));
 }
 
@@ -229,18 +639,21 @@ void DatabaseFileSource::runPackDatabaseAutomatically(bool autopack) {
 }
 
 void DatabaseFileSource::put(const Resource& resource, const Response& response) {
-    impl->actor().invoke(&DatabaseFileSourceThread::put, resource, response);
+    impl->actor().invoke(&DatabaseFileSourceThread::put, resource, response, impl->addPendingWrite(resource, response));
 }
 
 void DatabaseFileSource::invalidateAmbientCache(std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::invalidateAmbientCache, std::move(callback));
 }
 
 void DatabaseFileSource::clearAmbientCache(std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::clearAmbientCache, std::move(callback));
 }
 
 void DatabaseFileSource::setMaximumAmbientCacheSize(uint64_t size, std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::setMaximumAmbientCacheSize, size, std::move(callback));
 }
 
@@ -258,6 +671,7 @@ void DatabaseFileSource::createOfflineRegion(
 
 void DatabaseFileSource::mergeOfflineRegions(
     const std::string& sideDatabasePath, std::function<void(expected<OfflineRegions, std::exception_ptr>)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::mergeOfflineRegions, sideDatabasePath, std::move(callback));
 }
 
@@ -270,11 +684,13 @@ void DatabaseFileSource::updateOfflineMetadata(
 
 void DatabaseFileSource::deleteOfflineRegion(const OfflineRegion& region,
                                              std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::deleteRegion, region, std::move(callback));
 }
 
 void DatabaseFileSource::invalidateOfflineRegion(const OfflineRegion& region,
                                                  std::function<void(std::exception_ptr)> callback) {
+    impl->beginExclusiveOperation();
     impl->actor().invoke(&DatabaseFileSourceThread::invalidateRegion, region.getID(), std::move(callback));
 }
 
@@ -300,6 +716,19 @@ void DatabaseFileSource::setOfflineMapboxTileCountLimit(uint64_t limit) const {
 void DatabaseFileSource::setProperty(const std::string& key, const mapbox::base::Value& value) {
     if (key == READ_ONLY_MODE_KEY && value.getBool()) {
         impl->actor().invoke(&DatabaseFileSourceThread::reopenDatabaseReadOnly, *value.getBool());
+    } else if (key == AMBIENT_CACHE_WRITE_BEHIND_KEY && value.getBool()) {
+        impl->actor().invoke(&DatabaseFileSourceThread::setWriteBehind, *value.getBool());
+    } else if (key == WAL_MODE_KEY && value.getBool()) {
+        impl->actor().invoke(&DatabaseFileSourceThread::setJournalMode,
+                             *value.getBool() ? OfflineDatabase::JournalMode::WAL
+                                              : OfflineDatabase::JournalMode::Delete);
+    } else if (key == RELAXED_DURABILITY_KEY && value.getBool()) {
+        impl->actor().invoke(&DatabaseFileSourceThread::setDurability,
+                             *value.getBool() ? OfflineDatabase::Durability::Normal
+                                              : OfflineDatabase::Durability::Full);
+    } else if (key == ZSTD_COMPRESSION_DICTIONARY_KEY && value.getString()) {
+        impl->actor().invoke(
+            &DatabaseFileSourceThread::setCompressionCodec, util::CompressionCodec::Zstd, *value.getString());
     } else {
         std::string message = "Resource provider does not support property " + key;
         Log::Error(Event::General, message.c_str());
@@ -1,5 +1,6 @@
 #include <mbgl/storage/http_file_source.hpp>
 #include <mbgl/storage/file_source_impl_base.hpp>
+#include <mbgl/platform/settings.hpp>
 #include <mbgl/storage/resource_options.hpp>
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/response.hpp>
@@ -18,6 +19,7 @@
 #include <dlfcn.h>
 #include <queue>
 #include <map>
+#include <mutex>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -36,6 +38,22 @@ static void handleError(CURLcode code) {
 
 namespace mbgl {
 
+namespace {
+
+optional<long> getPositiveSetting(const char* key) {
+    auto value = platform::Settings::getInstance().get(key);
+    if (auto* unsignedValue = value.getUint()) {
+        if (*unsignedValue > 0) return long(*unsignedValue);
+    } else if (auto* integer = value.getInt()) {
+        if (*integer > 0) return long(*integer);
+    } else if (auto* number = value.getDouble()) {
+        if (*number >= 1) return long(*number);
+    }
+    return {};
+}
+
+} // namespace
+
 class HTTPFileSource::Impl {
 public:
     Impl(const ResourceOptions& options);
@@ -64,6 +82,10 @@ public:
     // them all the time.
     std::queue<CURL *> handles;
 
+    // Whether requests negotiate HTTP/2 and wait for a connection they can share rather than
+    // opening a new one.
+    bool multiplexing = false;
+
     void setResourceOptions(ResourceOptions options);
     ResourceOptions getResourceOptions();
 
@@ -105,13 +127,39 @@ HTTPFileSource::Impl::Impl(const ResourceOptions& options): resourceOptions (opt
         throw std::runtime_error("Could not init cURL");
     }
 
+    // All handles are used on this thread, so the shared data needs no locking.
     share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
 
     multi = curl_multi_init();
     handleError(curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, handleSocket));
     handleError(curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this));
     handleError(curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, startTimeout));
     handleError(curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this));
+
+#if LIBCURL_VERSION_NUM >= ((7) << 16 | (47) << 8 | 0) // CURL_HTTP_VERSION_2TLS
+    auto multiplexingValue = platform::Settings::getInstance().get(platform::EXPERIMENTAL_HTTP_MULTIPLEXING);
+    auto* multiplexingSetting = multiplexingValue.getBool();
+    multiplexing = (!multiplexingSetting || *multiplexingSetting) &&
+                   (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2);
+    if (multiplexing) {
+        handleError(curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX));
+    }
+#endif
+#if LIBCURL_VERSION_NUM >= ((7) << 16 | (30) << 8 | 0) // Added in 7.30.0
+    if (auto maxHostConnections = getPositiveSetting(platform::EXPERIMENTAL_HTTP_MAX_HOST_CONNECTIONS)) {
+        handleError(curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, *maxHostConnections));
+    }
+#endif
+#if LIBCURL_VERSION_NUM >= ((7) << 16 | (67) << 8 | 0) // Added in 7.67.0
+    if (auto maxConcurrentStreams = getPositiveSetting(platform::EXPERIMENTAL_HTTP_MAX_CONCURRENT_STREAMS)) {
+        handleError(curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, *maxConcurrentStreams));
+    }
+#endif
+    if (auto connectionCacheSize = getPositiveSetting(platform::EXPERIMENTAL_HTTP_CONNECTION_CACHE_SIZE)) {
+        handleError(curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, *connectionCacheSize));
+    }
 }
 
 HTTPFileSource::Impl::~Impl() {
@@ -233,14 +281,14 @@ int HTTPFileSource::Impl::startTimeout(CURLM * /* multi */, long timeout_ms, voi
     return 0;
 }
 
-void HTTPFileSource::setResourceOptions(ResourceOptions options) {
+void HTTPFileSource::Impl::setResourceOptions(ResourceOptions options) {
     std::lock_guard<std::mutex> lock(resourceOptionsMutex);
     resourceOptions = options;
 }
 
-ResourceOptions& HTTPFileSource::getResourceOptions() {
+ResourceOptions HTTPFileSource::Impl::getResourceOptions() {
     std::lock_guard<std::mutex> lock(resourceOptionsMutex);
-    return resourceOptions;
+    return resourceOptions.clone();
 }
 
 HTTPRequest::HTTPRequest(HTTPFileSource::Impl* context_, Resource resource_, FileSource::Callback callback_)
@@ -279,6 +327,12 @@ HTTPRequest::HTTPRequest(HTTPFileSource::Impl* context_, Resource resource_, Fil
 #endif
     handleError(curl_easy_setopt(handle, CURLOPT_USERAGENT, "MapboxGL/1.0"));
     handleError(curl_easy_setopt(handle, CURLOPT_SHARE, context->share));
+#if LIBCURL_VERSION_NUM >= ((7) << 16 | (47) << 8 | 0) // CURL_HTTP_VERSION_2TLS
+    if (context->multiplexing) {
+        handleError(curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS));
+        handleError(curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L));
+    }
+#endif
 
     // Start requesting the information.
     handleError(curl_multi_add_handle(context->multi, handle));
@@ -439,7 +493,7 @@ void HTTPFileSource::setResourceOptions(ResourceOptions options) {
     impl->setResourceOptions(options.clone());
 }
 
-ResourceOptions& HTTPFileSource::getResourceOptions() {
+ResourceOptions HTTPFileSource::getResourceOptions() {
     return impl->getResourceOptions();
 }
 
@@ -11,6 +11,7 @@
 
 #include <cassert>
 #include <map>
+#include <tuple>
 
 namespace mbgl {
 
@@ -28,7 +29,32 @@ public:
           maptilerFileSource(std::move(maptilerFileSource_)) {}
 
     void request(AsyncRequest* req, const Resource& resource, const ActorRef<FileSourceRequest>& ref) {
-        auto callback = [ref](const Response& res) { ref.invoke(&FileSourceRequest::setResponse, res); };
+        RequestKey key(resource);
+
+        // Join an identical request that is still in flight, and replay the responses it has
+        // already delivered so that the new requester does not wait for the next one.
+        auto it = inFlight.find(key);
+        if (it != inFlight.end()) {
+            std::shared_ptr<RequestGroup> group = it->second;
+            group->requesters.emplace(req, ref);
+            requests.emplace(req, group);
+            group->replay(ref);
+            return;
+        }
+
+        auto group = std::make_shared<RequestGroup>(std::move(key));
+        group->requesters.emplace(req, ref);
+
+        // The group owns the task, so the task (and its callbacks) never outlive the group.
+        RequestGroup* groupPtr = group.get();
+        auto callback = [this, groupPtr](const Response& res) {
+            groupPtr->respond(res);
+            // Requests that don't refresh are done after their response, so later requests
+            // must not join them.
+            if (!groupPtr->refreshing) {
+                removeFromInFlight(groupPtr);
+            }
+        };
 
         auto requestFromNetwork = [=](const Resource& res,
                                       std::unique_ptr<AsyncRequest> parent) -> std::unique_ptr<AsyncRequest> {
@@ -36,6 +62,10 @@ public:
                 return parent;
             }
 
+            // The online file source requests the resource again when it expires.
+            groupPtr->refreshing = true;
+            groupPtr->fromNetwork = true;
+
             // Keep parent request alive while chained request is being processed.
             std::shared_ptr<AsyncRequest> parentKeepAlive = std::move(parent);
 
@@ -57,28 +87,26 @@ public:
             });
         };
 
-        // Initial tasksSize is used to check whether any of
-        // the sources were able to request a resource.
-        const std::size_t tasksSize = tasks.size();
-
         // Waterfall resource request processing and return early once resource was requested.
         if (assetFileSource && assetFileSource->canRequest(resource)) {
             // Asset request
-            tasks[req] = assetFileSource->request(resource, callback);
+            group->task = assetFileSource->request(resource, callback);
         } else if (maptilerFileSource && maptilerFileSource->canRequest(resource)) {
             // Local file request
-            tasks[req] = maptilerFileSource->request(resource, callback);            
+            group->task = maptilerFileSource->request(resource, callback);
         } else if (localFileSource && localFileSource->canRequest(resource)) {
             // Local file request
-            tasks[req] = localFileSource->request(resource, callback);
+            group->task = localFileSource->request(resource, callback);
         } else if (databaseFileSource && databaseFileSource->canRequest(resource)) {
             // Try cache only request if needed.
             if (resource.loadingMethod == Resource::LoadingMethod::CacheOnly) {
-                tasks[req] = databaseFileSource->request(resource, callback);
+                group->task = databaseFileSource->request(resource, callback);
             } else {
                 // Cache request with fallback to network with cache control
-                tasks[req] = databaseFileSource->request(resource, [=](const Response& response) {
+                group->refreshing = true;
+                group->task = databaseFileSource->request(resource, [=](const Response& response) {
                     Resource res = resource;
+                    res.setPriority(groupPtr->key.priority);
 
                     // Resource is in the cache
                     if (!response.noContent) {
@@ -99,36 +127,197 @@ public:
                         res.priorEtag = response.etag;
                     }
 
-                    tasks[req] = requestFromNetwork(res, std::move(tasks[req]));
+                    groupPtr->task = requestFromNetwork(res, std::move(groupPtr->task));
                 });
             }
-        } else if (auto networkReq = requestFromNetwork(resource, nullptr)) {
+        } else {
             // Get from the online file source
-            tasks[req] = std::move(networkReq);
+            group->task = requestFromNetwork(resource, nullptr);
         }
 
-        // If no new tasks were added, notify client that request cannot be processed.
-        if (tasks.size() == tasksSize) {
+        // If no task was created, notify client that request cannot be processed.
+        if (!group->task) {
             Response response;
             response.noContent = true;
             response.error =
                 std::make_unique<Response::Error>(Response::Error::Reason::Other, "Unsupported resource request.");
-            callback(response);
+            ref.invoke(&FileSourceRequest::setResponse, response);
+            return;
         }
+
+        requests.emplace(req, group);
+        inFlight.emplace(group->key, std::move(group));
     }
 
     void cancel(AsyncRequest* req) {
         assert(req);
-        tasks.erase(req);
+        auto it = requests.find(req);
+        if (it == requests.end()) {
+            return;
+        }
+
+        std::shared_ptr<RequestGroup> group = std::move(it->second);
+        requests.erase(it);
+        group->requesters.erase(req);
+
+        // The last requester is gone: drop the group, which cancels the underlying task.
+        if (group->requesters.empty()) {
+            removeFromInFlight(group.get());
+        }
+    }
+
+    void setPriority(AsyncRequest* req, Resource::Priority priority) {
+        assert(req);
+        auto it = requests.find(req);
+        if (it == requests.end()) {
+            return;
+        }
+
+        // A shared request keeps the priority the other requesters asked for.
+        RequestGroup& group = *it->second;
+        if (group.requesters.size() > 1 || group.key.priority == priority) {
+            return;
+        }
+
+        // The priority is part of the key, so the group is filed under the new one.
+        auto inFlightIt = inFlight.find(group.key);
+        const bool isInFlight = inFlightIt != inFlight.end() && inFlightIt->second.get() == &group;
+        if (isInFlight) {
+            inFlight.erase(inFlightIt);
+        }
+        group.key.priority = priority;
+        if (isInFlight) {
+            inFlight.emplace(group.key, it->second);
+        }
+
+        // Refreshes of data the requester already has stay where they are, e.g. in the low
+        // priority lane of usable cached resources.
+        if (group.fromNetwork && group.task && !group.lastData) {
+            onlineFileSource->setPriority(*group.task, priority);
+        }
     }
 
 private:
+    // Identifies requests that would produce the same responses. The URL is the one the caller
+    // passed in: the online file source rewrites it deterministically, so equal keys map to equal
+    // transformed URLs as well.
+    struct RequestKey {
+        using TileKey = std::tuple<std::string, uint8_t, int32_t, int32_t, int8_t>;
+
+        explicit RequestKey(const Resource& resource)
+            : kind(resource.kind),
+              url(resource.url),
+              tileData(resource.tileData
+                           ? optional<TileKey>(std::make_tuple(resource.tileData->urlTemplate,
+                                                               resource.tileData->pixelRatio,
+                                                               resource.tileData->x,
+                                                               resource.tileData->y,
+                                                               resource.tileData->z))
+                           : nullopt),
+              loadingMethod(resource.loadingMethod),
+              usage(resource.usage),
+              priority(resource.priority),
+              storagePolicy(resource.storagePolicy),
+              priorModified(resource.priorModified),
+              priorExpires(resource.priorExpires),
+              priorEtag(resource.priorEtag),
+              priorData(resource.priorData.get()),
+              minimumUpdateInterval(resource.minimumUpdateInterval) {}
+
+        auto tie() const {
+            return std::tie(kind,
+                            url,
+                            tileData,
+                            loadingMethod,
+                            usage,
+                            priority,
+                            storagePolicy,
+                            priorModified,
+                            priorExpires,
+                            priorEtag,
+                            priorData,
+                            minimumUpdateInterval);
+        }
+
+        bool operator<(const RequestKey& other) const { return tie() < other.tie(); }
+
+        Resource::Kind kind;
+        std::string url;
+        optional<TileKey> tileData;
+        Resource::LoadingMethod loadingMethod;
+        Resource::Usage usage;
+        Resource::Priority priority;
+        Resource::StoragePolicy storagePolicy;
+        optional<Timestamp> priorModified;
+        optional<Timestamp> priorExpires;
+        optional<std::string> priorEtag;
+        const std::string* priorData;
+        Duration minimumUpdateInterval;
+    };
+
+    // A single underlying request shared by every requester of the same resource.
+    struct RequestGroup {
+        explicit RequestGroup(RequestKey key_) : key(std::move(key_)) {}
+
+        void respond(const Response& response) {
+            // A "not modified" response only makes sense to requesters that have seen the data
+            // before, and an error doesn't replace the data delivered before it, so requesters
+            // that join later get the last data and the error that followed it.
+            if (response.error) {
+                lastError = response;
+            } else if (response.notModified) {
+                if (lastData) {
+                    lastData->expires = response.expires;
+                    lastData->mustRevalidate = response.mustRevalidate;
+                    lastData->modified = response.modified;
+                    lastData->etag = response.etag;
+                }
+                lastError = nullopt;
+            } else {
+                lastData = response;
+                lastError = nullopt;
+            }
+
+            for (const auto& requester : requesters) {
+                requester.second.invoke(&FileSourceRequest::setResponse, response);
+            }
+        }
+
+        void replay(const ActorRef<FileSourceRequest>& ref) const {
+            if (lastData) {
+                ref.invoke(&FileSourceRequest::setResponse, *lastData);
+            }
+            if (lastError) {
+                ref.invoke(&FileSourceRequest::setResponse, *lastError);
+            }
+        }
+
+        RequestKey key;
+        std::map<AsyncRequest*, ActorRef<FileSourceRequest>> requesters;
+        optional<Response> lastData;
+        optional<Response> lastError;
+        std::unique_ptr<AsyncRequest> task;
+        // Whether the task keeps delivering responses, e.g. when the resource expires.
+        bool refreshing = false;
+        // Whether the task is a request to the online file source.
+        bool fromNetwork = false;
+    };
+
+    void removeFromInFlight(const RequestGroup* group) {
+        auto it = inFlight.find(group->key);
+        // A newer request for the same resource may have taken the place of a completed one.
+        if (it != inFlight.end() && it->second.get() == group) {
+            inFlight.erase(it);
+        }
+    }
+
     const std::shared_ptr<FileSource> assetFileSource;
     const std::shared_ptr<FileSource> databaseFileSource;
     const std::shared_ptr<FileSource> localFileSource;
     const std::shared_ptr<FileSource> onlineFileSource;
     const std::shared_ptr<FileSource> maptilerFileSource;
-    std::map<AsyncRequest*, std::unique_ptr<AsyncRequest>> tasks;
+    std::map<AsyncRequest*, std::shared_ptr<RequestGroup>> requests;
+    std::map<RequestKey, std::shared_ptr<RequestGroup>> inFlight;
 };
 
 class MainResourceLoader::Impl {
@@ -173,6 +362,10 @@ public:
                (maptilerFileSource && maptilerFileSource->canRequest(resource));
     }
 
+    void setPriority(AsyncRequest& req, Resource::Priority priority) {
+        thread->actor().invoke(&MainResourceLoaderThread::setPriority, &req, priority);
+    }
+
     bool supportsCacheOnlyRequests() const { return supportsCacheOnlyRequests_; }
 
     void pause() { thread->pause(); }
@@ -228,6 +421,10 @@ bool MainResourceLoader::canRequest(const Resource& resource) const {
     return impl->canRequest(resource);
 }
 
+void MainResourceLoader::setPriority(AsyncRequest& req, Resource::Priority priority) {
+    impl->setPriority(req, priority);
+}
+
 void MainResourceLoader::pause() {
     impl->pause();
 }
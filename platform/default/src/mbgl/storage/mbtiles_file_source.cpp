@@ -10,19 +10,93 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <mbgl/actor/scheduler.hpp>
 #include <mbgl/util/thread.hpp>
+#include <mbgl/util/thread_pool.hpp>
 #include <mbgl/util/url.hpp>
 #include <mbgl/util/chrono.hpp>
 
 #include <mbgl/storage/sqlite3.hpp>
 #include <zlib.h>
 
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
 namespace {
+
+// Upper bound of the threads reading tiles concurrently. Reads mostly wait for the disk, so there
+// are a few of them even on devices with fewer cores.
+std::size_t maxTileReadThreads() {
+    static const std::size_t count = std::max<std::size_t>(4, std::thread::hardware_concurrency());
+    return count;
+}
+
 //TODO: replace by mbgl::util::MBTILES_PROTOCOL
 const std::string maptilerProtocol = "mbtiles://";
 bool acceptsURL(const std::string& url) {
     return 0 == url.rfind(mbgl::util::MBTILES_PROTOCOL, 0);
 }
+
+std::string url_to_path(const std::string &url) {
+    return mbgl::util::percentDecode(url.substr(maptilerProtocol.size()));
+}
+
+std::string db_path(const std::string &path) {
+    return path.substr(0, path.find('?'));
+}
+
+bool is_compressed(const std::string &v) {
+    return v.size() >= 2 && (((uint8_t) v[0]) == 0x1f) && (((uint8_t) v[1]) == 0x8b);
+}
+
+// Some Mbtiles store GZIP-ed tile data, this function is used for decompression.
+// The gzip trailer stores the uncompressed size, so the output is usually allocated once and
+// inflated into directly. The buffer only grows if the trailer is wrong.
+std::string decompress_string(const std::string &data) {
+    // DEFLATE can't compress better than about 1032:1; ignore trailers claiming more than that.
+    constexpr std::size_t maxRatio = 1032;
+    constexpr std::size_t minSize = 8192;
+
+    std::string outstring;
+    if (data.size() >= 18) {
+        const auto *trailer = reinterpret_cast<const uint8_t *>(data.data() + data.size() - 4);
+        const std::size_t size = uint32_t(trailer[0]) | uint32_t(trailer[1]) << 8 |
+                                 uint32_t(trailer[2]) << 16 | uint32_t(trailer[3]) << 24;
+        if (size <= data.size() * maxRatio) {
+            outstring.resize(size);
+        }
+    }
+
+    z_stream zs{};
+
+    // Init inflate to gzip mode
+    if (inflateInit2(&zs, (16 + MAX_WBITS)) != Z_OK)
+        return "";
+
+    zs.next_in = (Bytef *) data.data();
+    zs.avail_in = (unsigned int) data.size();
+
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        if (zs.total_out == outstring.size()) {
+            outstring.resize(std::max(outstring.size() * 2, minSize));
+        }
+        zs.next_out = reinterpret_cast<Bytef *>(&outstring[zs.total_out]);
+        zs.avail_out = static_cast<unsigned int>(outstring.size() - zs.total_out);
+
+        ret = inflate(&zs, Z_NO_FLUSH);
+    }
+
+    inflateEnd(&zs);
+
+    if (ret != Z_STREAM_END) { // an error occurred that was not EOF
+        return "";
+    }
+
+    outstring.resize(zs.total_out);
+    return outstring;
+}
 } // namespace
 
 namespace mbgl {
@@ -58,59 +132,6 @@ public:
         return std::string(buffer.GetString(), buffer.GetSize());
     }
 
-    std::string url_to_path(const std::string &url) {
-        return mbgl::util::percentDecode(url.substr(maptilerProtocol.size()));
-    }
-
-    std::string db_path(const std::string &path) {
-        return path.substr(0, path.find('?'));
-    }
-
-    bool is_compressed(const std::string &v) {
-        return (((uint8_t) v[0]) == 0x1f) && (((uint8_t) v[1]) == 0x8b);
-    }
-
-    // Some Mbtiles store GZIP-ed tile data, this function is used for decompression
-    std::string decompress_string(const std::string &data) {
-
-        uint32_t OUT_SIZE = 8192;
-
-        int ret;
-        char outbuffer[OUT_SIZE];
-        std::string outstring;
-
-        z_stream zs{};
-
-        // Init inflate to gzip mode
-        if (inflateInit2(&zs, (16 + MAX_WBITS)) != Z_OK)
-            return "";
-
-        zs.next_in = (Bytef *) data.data();
-        zs.avail_in = (unsigned int) data.size();
-
-
-        // get the decompressed bytes blockwise using repeated calls to inflate
-        do {
-            zs.next_out = reinterpret_cast<Bytef *>(outbuffer);
-            zs.avail_out = OUT_SIZE;
-
-            ret = inflate(&zs, 0);
-
-            if (outstring.size() < zs.total_out) {
-                outstring.append(outbuffer, zs.total_out - outstring.size());
-            }
-
-        } while (ret == Z_OK);
-
-        inflateEnd(&zs);
-
-        if (ret != Z_STREAM_END) { // an error occurred that was not EOF
-            return "";
-        }
-
-        return outstring;
-    }
-
     // Generate a tilejson resource from .mbtiles file
     void request_tilejson(const Resource &resource, ActorRef<FileSourceRequest> req) {
         auto path = url_to_path(resource.url);
@@ -220,89 +241,120 @@ public:
         req.invoke(&FileSourceRequest::setResponse, response);
     }
 
-    // Load data for specific tile
-    void request_tile(const Resource &resource, ActorRef<FileSourceRequest> req) {
-        std::string base_path = url_to_path(resource.url);
-        std::string path = db_path(base_path);
-        auto &db = get_db(path);
+    void setResourceOptions(ResourceOptions options) {
+            std::lock_guard<std::mutex> lock(resourceOptionsMutex);
+            resourceOptions = options;
+    }
+
+    ResourceOptions getResourceOptions() {
+        std::lock_guard<std::mutex> lock(resourceOptionsMutex);
+        return resourceOptions.clone();
+    }
 
-        int iy = resource.tileData->y;
-        int iz = resource.tileData->z;
+private:
+    mutable std::mutex resourceOptionsMutex;
+    ResourceOptions resourceOptions;
+};
 
-        auto x = std::to_string(resource.tileData->x);
-        auto y = std::to_string((int)(pow(2, iz) - 1) - iy);
-        auto z = std::to_string(iz);
 
-        std::string sql = "SELECT tile_data FROM tiles where zoom_level = " + z +
-                          " AND tile_column = " + x + " AND tile_row = " + y;
-        mapbox::sqlite::Statement stmt(db, sql.c_str());
+// Read-only connections to .mbtiles files, each with the tile query prepared once. Tiles are read
+// on the background scheduler, and every concurrent read takes its own connection from the pool,
+// so reads from one or more files run in parallel.
+class MaptilerFileSource::TileReaderPool {
+public:
+    // Every read thread may keep a connection to each file.
+    TileReaderPool() : maxIdleReaders(maxTileReadThreads()) {}
+
+    void request_tile(const Resource &resource, ActorRef<FileSourceRequest> req) {
+        const std::string path = db_path(url_to_path(resource.url));
 
         Response response;
         response.noContent = true;
         response.error = std::make_unique<Response::Error>(Response::Error::Reason::Connection,
                                                            "Not found in mbtile database");
 
-        for (mapbox::sqlite::Query q(stmt); q.run();) {
+        try {
+            auto reader = acquire(path);
+
+            const int64_t iz = resource.tileData->z;
+            const int64_t x = resource.tileData->x;
+            const int64_t y = (int64_t(1) << iz) - 1 - resource.tileData->y;
+
+            optional<std::string> data;
+            {
+                mapbox::sqlite::Query q(reader->stmt);
+                q.bind(1, iz);
+                q.bind(2, x);
+                q.bind(3, y);
+                if (q.run()) {
+                    data = q.get<optional<std::string>>(0);
+                }
+            }
+            release(path, std::move(reader));
 
-            optional<std::string> data = q.get<optional<std::string>>(0);
             if (data) {
-                response.data = std::make_shared<std::string>(*data);
                 response.noContent = false;
                 response.expires = Timestamp::max();
                 response.etag = resource.url;
-                response.error.release();
+                response.error.reset();
 
-                if (is_compressed(*response.data)) {
-                    response.data = std::make_shared<std::string>(decompress_string(*response.data));
+                if (is_compressed(*data)) {
+                    response.data = std::make_shared<std::string>(decompress_string(*data));
+                } else {
+                    response.data = std::make_shared<std::string>(std::move(*data));
                 }
             }
+        } catch (const mapbox::sqlite::Exception& ex) {
+            response.error = std::make_unique<Response::Error>(Response::Error::Reason::Other, ex.what());
         }
-        req.invoke(&FileSourceRequest::setResponse, response);
-    }
 
-    void setResourceOptions(ResourceOptions options) {
-            std::lock_guard<std::mutex> lock(resourceOptionsMutex);
-            resourceOptions = options;
-    }
-
-    ResourceOptions getResourceOptions() {
-        std::lock_guard<std::mutex> lock(resourceOptionsMutex);
-        return resourceOptions.clone();
+        req.invoke(&FileSourceRequest::setResponse, response);
     }
 
 private:
-    std::map<std::string, mapbox::sqlite::Database> db_cache;
-
-    void close_db(const std::string &path) {
-        auto ptr = db_cache.find(path);
-        if (ptr != db_cache.end()) {
-            db_cache.erase(path);
+    struct Reader {
+        explicit Reader(const std::string& path)
+            : db(mapbox::sqlite::Database::open(path, mapbox::sqlite::ReadOnly)),
+              stmt(db, "SELECT tile_data FROM tiles WHERE zoom_level = ?1 AND tile_column = ?2 AND tile_row = ?3") {}
+
+        mapbox::sqlite::Database db;
+        mapbox::sqlite::Statement stmt;
+    };
+
+    std::unique_ptr<Reader> acquire(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = idleReaders.find(path);
+            if (it != idleReaders.end() && !it->second.empty()) {
+                auto reader = std::move(it->second.back());
+                it->second.pop_back();
+                return reader;
+            }
         }
+        // Opening a connection is slow, don't block the other readers meanwhile.
+        return std::make_unique<Reader>(path);
     }
 
-    void close_all() {
-        db_cache.clear();
-    }
-
-    // Multiple databases open simultaneoulsy, to effectively support multiple .mbtiles maps
-    mapbox::sqlite::Database &get_db(const std::string &path) {
-        auto ptr = db_cache.find(path);
-        if (ptr != db_cache.end()) {
-            return ptr->second;
-        };
-
-        auto ptr2 = db_cache.insert(std::pair<std::string, mapbox::sqlite::Database>(path, mapbox::sqlite::Database::open(path.c_str(), mapbox::sqlite::ReadOnly)));
-        return ptr2.first->second;
+    void release(const std::string& path, std::unique_ptr<Reader> reader) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& readers = idleReaders[path];
+        if (readers.size() < maxIdleReaders) {
+            readers.push_back(std::move(reader));
+        }
     }
 
-    mutable std::mutex resourceOptionsMutex;
-    ResourceOptions resourceOptions;
+    const std::size_t maxIdleReaders;
+    std::mutex mutex;
+    std::map<std::string, std::vector<std::unique_ptr<Reader>>> idleReaders;
 };
 
-
 MaptilerFileSource::MaptilerFileSource(const ResourceOptions& options) :
     thread(std::make_unique<util::Thread<Impl>>(
-        util::makeThreadPrioritySetter(platform::EXPERIMENTAL_THREAD_PRIORITY_FILE), "MaptilerFileSource", options.clone())) {}
+        util::makeThreadPrioritySetter(platform::EXPERIMENTAL_THREAD_PRIORITY_FILE), "MaptilerFileSource", options.clone())),
+    tileReaders(std::make_shared<TileReaderPool>()),
+    // Reads block on disk I/O, so they get their own threads instead of competing with tile
+    // parsing and layout on the shared background pool.
+    tileScheduler(std::make_unique<ThreadPool>(1, maxTileReadThreads())) {}
 
 
 std::unique_ptr<AsyncRequest> MaptilerFileSource::request(const Resource &resource, FileSource::Callback callback) {
@@ -317,7 +369,9 @@ std::unique_ptr<AsyncRequest> MaptilerFileSource::request(const Resource &resour
 
     } else {
         if (resource.kind == Resource::Tile) {
-            thread->actor().invoke(&Impl::request_tile, resource, req->actor());
+            tileScheduler->schedule([readers = tileReaders, resource, ref = req->actor()] {
+                readers->request_tile(resource, ref);
+            });
         } else {
             thread->actor().invoke(&Impl::request_tilejson, resource, req->actor());
         }
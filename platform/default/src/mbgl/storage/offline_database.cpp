@@ -11,10 +11,22 @@
 #include <mbgl/storage/offline_schema.hpp>
 #include <mbgl/storage/merge_sideloaded.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace mbgl {
 
-OfflineDatabase::OfflineDatabase(std::string path_, const TileServerOptions& options)
-    : path(std::move(path_)), tileServerOptions(options) {
+namespace {
+
+// Accessed timestamps of cache hits are written once this many are pending, or once the
+// oldest of them has been pending for this long.
+constexpr std::size_t ACCESSED_TIMESTAMPS_FLUSH_COUNT = 256;
+constexpr Seconds ACCESSED_TIMESTAMPS_FLUSH_INTERVAL{30};
+
+} // namespace
+
+OfflineDatabase::OfflineDatabase(std::string path_, const TileServerOptions& options, bool readOnly_)
+    : path(std::move(path_)), tileServerOptions(options), readOnly(readOnly_) {
     try {
         initialize();
     } catch (...) {
@@ -52,7 +64,7 @@ void OfflineDatabase::initialize() {
         // Newly created database, or old cache-only database; remove old table if it exists.
         removeOldCacheTable();
         createSchema();
-        return;
+        break;
     case 2:
         migrateToVersion3();
         // fall through
@@ -66,13 +78,20 @@ void OfflineDatabase::initialize() {
         migrateToVersion6();
         // fall through
     case 6:
+        migrateToVersion7();
+        // fall through
+    case 7:
         // Happy path; we're done
-        return;
+        break;
     default:
         // Downgrade: delete the database and try to reinitialize.
         removeExisting();
         initialize();
+        return;
     }
+
+    applyJournalSettings();
+    storeCompressionDictionary(compressionDictionary);
 }
 
 void OfflineDatabase::changePath(const std::string& path_) {
@@ -85,6 +104,7 @@ void OfflineDatabase::changePath(const std::string& path_) {
 void OfflineDatabase::cleanup() {
     // Deleting these SQLite objects may result in exceptions
     try {
+        flushAccessedTimestamps();
         statements.clear();
         db.reset();
     } catch (...) {
@@ -150,10 +170,17 @@ void OfflineDatabase::handleError(const char* action) {
 void OfflineDatabase::removeExisting() {
     Log::Warning(Event::Database, "Removing existing incompatible offline database");
 
+    pendingResourceAccesses.clear();
+    pendingTileAccesses.clear();
+    firstPendingAccess = nullopt;
+    decoders.clear();
     statements.clear();
     db.reset();
 
-    util::deleteFile(path);
+    // The file may be shared with a writable connection, which owns it.
+    if (!readOnly) {
+        util::deleteFile(path);
+    }
 }
 
 void OfflineDatabase::removeOldCacheTable() {
@@ -173,7 +200,7 @@ void OfflineDatabase::createSchema() {
     db->exec("PRAGMA synchronous = FULL");
     mapbox::sqlite::Transaction transaction(*db);
     db->exec(offlineDatabaseSchema);
-    db->exec("PRAGMA user_version = 6");
+    db->exec("PRAGMA user_version = 7");
     transaction.commit();
 }
 
@@ -211,6 +238,18 @@ void OfflineDatabase::migrateToVersion6() {
     transaction.commit();
 }
 
+// Version 7 turns the compressed column into the codec column. Existing values keep their
+// meaning, since 0 and 1 stand for uncompressed and deflate.
+void OfflineDatabase::migrateToVersion7() {
+    assert(db);
+    checkFlags();
+
+    mapbox::sqlite::Transaction transaction(*db);
+    db->exec("CREATE TABLE compression_dictionaries (id INTEGER NOT NULL PRIMARY KEY, data BLOB NOT NULL)");
+    db->exec("PRAGMA user_version = 7");
+    transaction.commit();
+}
+
 void OfflineDatabase::vacuum() {
     assert(db);
     checkFlags();
@@ -229,6 +268,58 @@ void OfflineDatabase::checkFlags() {
     }
 }
 
+void OfflineDatabase::storeCompressionDictionary(const std::string& dictionary) {
+    assert(db);
+
+    if (readOnly || dictionary.empty()) {
+        return;
+    }
+
+    mapbox::sqlite::Query query{
+        getStatement("INSERT OR IGNORE INTO compression_dictionaries (id, data) VALUES (?1, ?2)")};
+    query.bind(1, util::getDictionaryID(dictionary));
+    query.bindBlob(2, dictionary.data(), dictionary.size(), false);
+    query.run();
+}
+
+const util::Codec& OfflineDatabase::getDecoder(util::CompressionCodec codec, const std::string& data) {
+    if (codec == util::CompressionCodec::Zlib) {
+        return *zlibDecoder;
+    }
+
+    if (codec != util::CompressionCodec::Zstd) {
+        throw std::runtime_error("Unknown compression codec");
+    }
+
+    const uint32_t dictionaryID = util::getPayloadDictionaryID(data);
+    auto it = decoders.find(dictionaryID);
+    if (it != decoders.end()) {
+        return *it->second;
+    }
+
+    std::string dictionary;
+    if (dictionaryID != 0) {
+        mapbox::sqlite::Query query{getStatement("SELECT data FROM compression_dictionaries WHERE id = ?1")};
+        query.bind(1, dictionaryID);
+        if (!query.run()) {
+            throw std::runtime_error("Missing compression dictionary");
+        }
+        dictionary = query.get<std::string>(0);
+    }
+
+    return *decoders.emplace(dictionaryID, util::makeCodec(codec, dictionary)).first->second;
+}
+
+void OfflineDatabase::applyJournalSettings() {
+    assert(db);
+    checkFlags();
+
+    // The journal mode is persisted in the database file, whereas the sync setting
+    // only applies to the current connection.
+    db->exec(journalMode == JournalMode::WAL ? "PRAGMA journal_mode = WAL" : "PRAGMA journal_mode = DELETE");
+    db->exec(durability == Durability::Full ? "PRAGMA synchronous = FULL" : "PRAGMA synchronous = NORMAL");
+}
+
 mapbox::sqlite::Statement& OfflineDatabase::getStatement(const char* sql) {
     if (!db) {
         initialize();
@@ -253,12 +344,34 @@ optional<Response> OfflineDatabase::get(const Resource& resource) try {
 }
 
 optional<std::pair<Response, uint64_t>> OfflineDatabase::getInternal(const Resource& resource) {
+    optional<std::pair<Response, uint64_t>> result;
     if (resource.kind == Resource::Kind::Tile) {
         assert(resource.tileData);
-        return getTile(*resource.tileData);
+        result = getTile(*resource.tileData);
     } else {
-        return getResource(resource);
+        result = getResource(resource);
     }
+
+    flushAccessedTimestampsIfNeeded();
+
+    return result;
+}
+
+void OfflineDatabase::markAccessed(const Resource& resource) try {
+    if (readOnly) {
+        return;
+    }
+
+    if (resource.kind == Resource::Kind::Tile) {
+        assert(resource.tileData);
+        recordTileAccess(*resource.tileData);
+    } else {
+        recordResourceAccess(resource.url);
+    }
+
+    flushAccessedTimestampsIfNeeded();
+} catch (...) {
+    handleError("update timestamp");
 }
 
 optional<int64_t> OfflineDatabase::hasInternal(const Resource& resource) {
@@ -290,6 +403,28 @@ std::pair<bool, uint64_t> OfflineDatabase::put(const Resource& resource, const R
     return {false, 0};
 }
 
+bool OfflineDatabase::putAmbientResources(const std::list<std::tuple<Resource, Response>>& resources) try {
+    if (readOnly || resources.empty()) return true;
+
+    if (!db) {
+        initialize();
+    }
+
+    if (disabled()) {
+        return true;
+    }
+
+    mapbox::sqlite::Transaction transaction(*db, mapbox::sqlite::Transaction::Immediate);
+    for (const auto& elem : resources) {
+        putInternal(std::get<0>(elem), std::get<1>(elem), true);
+    }
+    transaction.commit();
+    return true;
+} catch (...) {
+    handleError("write resources");
+    return false;
+}
+
 std::pair<bool, uint64_t> OfflineDatabase::putInternal(const Resource& resource, const Response& response, bool evict_) {
     checkFlags();
 
@@ -298,13 +433,15 @@ std::pair<bool, uint64_t> OfflineDatabase::putInternal(const Resource& resource,
     }
 
     std::string compressedData;
-    bool compressed = false;
+    auto codec = util::CompressionCodec::None;
     uint64_t size = 0;
 
     if (response.data) {
-        compressedData = util::compress(*response.data);
-        compressed = compressedData.size() < response.data->size();
-        size = compressed ? compressedData.size() : response.data->size();
+        compressedData = encoder->compress(*response.data);
+        if (compressedData.size() < response.data->size()) {
+            codec = encoder->type();
+        }
+        size = codec != util::CompressionCodec::None ? compressedData.size() : response.data->size();
     }
 
     optional<DatabaseSizeChangeStats> stats;
@@ -321,12 +458,12 @@ std::pair<bool, uint64_t> OfflineDatabase::putInternal(const Resource& resource,
     if (resource.kind == Resource::Kind::Tile) {
         assert(resource.tileData);
         inserted = putTile(*resource.tileData, response,
-                compressed ? compressedData : response.data ? *response.data : "",
-                compressed);
+                codec != util::CompressionCodec::None ? compressedData : response.data ? *response.data : "",
+                codec);
     } else {
         inserted = putResource(resource, response,
-                compressed ? compressedData : response.data ? *response.data : "",
-                compressed);
+                codec != util::CompressionCodec::None ? compressedData : response.data ? *response.data : "",
+                codec);
     }
 
     if (stats) {
@@ -337,23 +474,6 @@ std::pair<bool, uint64_t> OfflineDatabase::putInternal(const Resource& resource,
 }
 
 optional<std::pair<Response, uint64_t>> OfflineDatabase::getResource(const Resource& resource) {
-    // Update accessed timestamp used for LRU eviction.
-    if (!readOnly) {
-        try {
-            mapbox::sqlite::Query accessedQuery{getStatement("UPDATE resources SET accessed = ?1 WHERE url = ?2")};
-            accessedQuery.bind(1, util::now());
-            accessedQuery.bind(2, resource.url);
-            accessedQuery.run();
-        } catch (const mapbox::sqlite::Exception& ex) {
-            if (ex.code == mapbox::sqlite::ResultCode::NotADB || ex.code == mapbox::sqlite::ResultCode::Corrupt) {
-                throw;
-            }
-
-            // If we don't have any indication that the database is corrupt, continue as usual.
-            Log::Warning(Event::Database, static_cast<int>(ex.code), "Can't update timestamp: %s", ex.what());
-        }
-    }
-
     // clang-format off
     mapbox::sqlite::Query query{ getStatement(
         //        0      1            2            3       4      5
@@ -368,6 +488,11 @@ optional<std::pair<Response, uint64_t>> OfflineDatabase::getResource(const Resou
         return nullopt;
     }
 
+    // Update accessed timestamp used for LRU eviction.
+    if (!readOnly) {
+        recordResourceAccess(resource.url);
+    }
+
     Response response;
     uint64_t size = 0;
 
@@ -377,10 +502,11 @@ optional<std::pair<Response, uint64_t>> OfflineDatabase::getResource(const Resou
     response.modified       = query.get<optional<Timestamp>>(3);
 
     auto data = query.get<optional<std::string>>(4);
+    const auto codec = static_cast<util::CompressionCodec>(query.get<int>(5));
     if (!data) {
         response.noContent = true;
-    } else if (query.get<bool>(5)) {
-        response.data = std::make_shared<std::string>(util::decompress(*data));
+    } else if (codec != util::CompressionCodec::None) {
+        response.data = std::make_shared<std::string>(getDecoder(codec, *data).decompress(*data));
         size = data->length();
     } else {
         response.data = std::make_shared<std::string>(*data);
@@ -403,7 +529,7 @@ optional<int64_t> OfflineDatabase::hasResource(const Resource& resource) {
 bool OfflineDatabase::putResource(const Resource& resource,
                                   const Response& response,
                                   const std::string& data,
-                                  bool compressed) {
+                                  util::CompressionCodec codec) {
     checkFlags();
 
     if (response.notModified) {
@@ -452,7 +578,7 @@ bool OfflineDatabase::putResource(const Resource& resource,
         updateQuery.bind(8, false);
     } else {
         updateQuery.bindBlob(7, data.data(), data.size(), false);
-        updateQuery.bind(8, compressed);
+        updateQuery.bind(8, static_cast<uint8_t>(codec));
     }
 
     updateQuery.run();
@@ -479,7 +605,7 @@ bool OfflineDatabase::putResource(const Resource& resource,
         insertQuery.bind(9, false);
     } else {
         insertQuery.bindBlob(8, data.data(), data.size(), false);
-        insertQuery.bind(9, compressed);
+        insertQuery.bind(9, static_cast<uint8_t>(codec));
     }
 
     insertQuery.run();
@@ -488,37 +614,6 @@ bool OfflineDatabase::putResource(const Resource& resource,
 }
 
 optional<std::pair<Response, uint64_t>> OfflineDatabase::getTile(const Resource::TileData& tile) {
-    // Update accessed timestamp used for LRU eviction.
-    if (!readOnly) {
-        try {
-            // clang-format off
-            mapbox::sqlite::Query accessedQuery{ getStatement(
-                "UPDATE tiles "
-                "SET accessed       = ?1 "
-                "WHERE url_template = ?2 "
-                "  AND pixel_ratio  = ?3 "
-                "  AND x            = ?4 "
-                "  AND y            = ?5 "
-                "  AND z            = ?6 ") };
-            // clang-format on
-
-            accessedQuery.bind(1, util::now());
-            accessedQuery.bind(2, tile.urlTemplate);
-            accessedQuery.bind(3, tile.pixelRatio);
-            accessedQuery.bind(4, tile.x);
-            accessedQuery.bind(5, tile.y);
-            accessedQuery.bind(6, tile.z);
-            accessedQuery.run();
-        } catch (const mapbox::sqlite::Exception& ex) {
-            if (ex.code == mapbox::sqlite::ResultCode::NotADB || ex.code == mapbox::sqlite::ResultCode::Corrupt) {
-                throw;
-            }
-
-            // If we don't have any indication that the database is corrupt, continue as usual.
-            Log::Warning(Event::Database, static_cast<int>(ex.code), "Can't update timestamp: %s", ex.what());
-        }
-    }
-
     // clang-format off
     mapbox::sqlite::Query query{ getStatement(
         //        0      1           2,            3,      4,      5
@@ -541,6 +636,11 @@ optional<std::pair<Response, uint64_t>> OfflineDatabase::getTile(const Resource:
         return nullopt;
     }
 
+    // Update accessed timestamp used for LRU eviction.
+    if (!readOnly) {
+        recordTileAccess(tile);
+    }
+
     Response response;
     uint64_t size = 0;
 
@@ -550,10 +650,11 @@ optional<std::pair<Response, uint64_t>> OfflineDatabase::getTile(const Resource:
     response.modified        = query.get<optional<Timestamp>>(3);
 
     optional<std::string> data = query.get<optional<std::string>>(4);
+    const auto codec = static_cast<util::CompressionCodec>(query.get<int>(5));
     if (!data) {
         response.noContent = true;
-    } else if (query.get<bool>(5)) {
-        response.data = std::make_shared<std::string>(util::decompress(*data));
+    } else if (codec != util::CompressionCodec::None) {
+        response.data = std::make_shared<std::string>(getDecoder(codec, *data).decompress(*data));
         size = data->length();
     } else {
         response.data = std::make_shared<std::string>(*data);
@@ -591,7 +692,7 @@ optional<int64_t> OfflineDatabase::hasTile(const Resource::TileData& tile) {
 bool OfflineDatabase::putTile(const Resource::TileData& tile,
                               const Response& response,
                               const std::string& data,
-                              bool compressed) {
+                              util::CompressionCodec codec) {
     checkFlags();
 
     if (response.notModified) {
@@ -655,7 +756,7 @@ bool OfflineDatabase::putTile(const Resource::TileData& tile,
         updateQuery.bind(7, false);
     } else {
         updateQuery.bindBlob(6, data.data(), data.size(), false);
-        updateQuery.bind(7, compressed);
+        updateQuery.bind(7, static_cast<uint8_t>(codec));
     }
 
     updateQuery.run();
@@ -685,7 +786,7 @@ bool OfflineDatabase::putTile(const Resource::TileData& tile,
         insertQuery.bind(12, false);
     } else {
         insertQuery.bindBlob(11, data.data(), data.size(), false);
-        insertQuery.bind(12, compressed);
+        insertQuery.bind(12, static_cast<uint8_t>(codec));
     }
 
     insertQuery.run();
@@ -857,12 +958,12 @@ OfflineDatabase::mergeDatabase(const std::string& sideDatabasePath) {
         return unexpected<std::exception_ptr>(std::current_exception());
     }
     try {
-        // Support sideloaded databases at user_version = 6. Future schema version
-        // changes will need to implement migration paths for sideloaded databases at
-        // version 6.
+        // Support sideloaded databases at user_version = 6 or later. Version 7 only added the
+        // compression dictionaries, which are copied below. Future schema version changes will
+        // need to implement migration paths for sideloaded databases at version 6.
         auto sideUserVersion = static_cast<int>(getPragma<int64_t>("PRAGMA side.user_version"));
         const auto mainUserVersion = getPragma<int64_t>("PRAGMA user_version");
-        if (sideUserVersion < 6 || sideUserVersion != mainUserVersion) {
+        if (sideUserVersion < 6 || sideUserVersion > mainUserVersion) {
             throw std::runtime_error("Merge database has incorrect user_version");
         }
 
@@ -891,6 +992,9 @@ OfflineDatabase::mergeDatabase(const std::string& sideDatabasePath) {
 
         mapbox::sqlite::Transaction transaction(*db);
         db->exec(mergeSideloadedDatabaseSQL);
+        if (sideUserVersion >= 7) {
+            db->exec("INSERT OR IGNORE INTO compression_dictionaries SELECT id, data FROM side.compression_dictionaries");
+        }
         transaction.commit();
 
         // clang-format off
@@ -976,11 +1080,98 @@ optional<int64_t> OfflineDatabase::hasRegionResource(const Resource& resource) t
     return nullopt;
 }
 
+std::vector<optional<int64_t>> OfflineDatabase::hasRegionResources(const std::vector<Resource>& resources) try {
+    std::vector<optional<int64_t>> result(resources.size());
+
+    if (!db) {
+        initialize();
+    }
+    mapbox::sqlite::Transaction transaction(*db);
+
+    std::map<std::tuple<std::string, uint8_t, int8_t>, std::vector<std::size_t>> tileGroups;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        const auto& resource = resources[i];
+        if (resource.kind == Resource::Kind::Tile) {
+            assert(resource.tileData);
+            const auto& tile = *resource.tileData;
+            tileGroups[std::make_tuple(tile.urlTemplate, tile.pixelRatio, tile.z)].push_back(i);
+        } else {
+            result[i] = hasResource(resource);
+        }
+    }
+
+    for (const auto& group : tileGroups) {
+        const auto& indices = group.second;
+        if (indices.size() == 1) {
+            result[indices.front()] = hasTile(*resources[indices.front()].tileData);
+            continue;
+        }
+
+        // Query the bounding box of the tiles, which are usually adjacent, and pick the requested
+        // ones from the rows.
+        std::map<std::pair<int32_t, int32_t>, std::vector<std::size_t>> positions;
+        int32_t minX = std::numeric_limits<int32_t>::max();
+        int32_t minY = std::numeric_limits<int32_t>::max();
+        int32_t maxX = std::numeric_limits<int32_t>::min();
+        int32_t maxY = std::numeric_limits<int32_t>::min();
+        for (const auto index : indices) {
+            const auto& tile = *resources[index].tileData;
+            positions[std::make_pair(tile.x, tile.y)].push_back(index);
+            minX = std::min(minX, tile.x);
+            minY = std::min(minY, tile.y);
+            maxX = std::max(maxX, tile.x);
+            maxY = std::max(maxY, tile.y);
+        }
+
+        // clang-format off
+        mapbox::sqlite::Query query{ getStatement(
+            "SELECT x, y, length(data) "
+            "FROM tiles "
+            "WHERE url_template = ?1 "
+            "  AND pixel_ratio  = ?2 "
+            "  AND z            = ?3 "
+            "  AND x BETWEEN ?4 AND ?5 "
+            "  AND y BETWEEN ?6 AND ?7 ") };
+        // clang-format on
+
+        query.bind(1, std::get<0>(group.first));
+        query.bind(2, std::get<1>(group.first));
+        query.bind(3, std::get<2>(group.first));
+        query.bind(4, minX);
+        query.bind(5, maxX);
+        query.bind(6, minY);
+        query.bind(7, maxY);
+
+        while (query.run()) {
+            const auto position = std::make_pair(static_cast<int32_t>(query.get<int64_t>(0)),
+                                                 static_cast<int32_t>(query.get<int64_t>(1)));
+            auto it = positions.find(position);
+            if (it == positions.end()) {
+                continue;
+            }
+            const auto size = query.get<optional<int64_t>>(2);
+            for (const auto index : it->second) {
+                result[index] = size;
+            }
+        }
+    }
+
+    transaction.commit();
+    return result;
+} catch (...) {
+    handleError("query region resources");
+    return std::vector<optional<int64_t>>(resources.size());
+}
+
 uint64_t OfflineDatabase::putRegionResource(int64_t regionID,
                                             const Resource& resource,
                                             const Response& response) try {
     checkFlags();
 
+    if (beforeRegionWrite) {
+        beforeRegionWrite();
+    }
+
     if (!db) {
         initialize();
     }
@@ -998,6 +1189,10 @@ void OfflineDatabase::putRegionResources(int64_t regionID,
                                          OfflineRegionStatus& status) try {
     checkFlags();
 
+    if (beforeRegionWrite) {
+        beforeRegionWrite();
+    }
+
     if (!db) {
         initialize();
     }
@@ -1216,6 +1411,7 @@ T OfflineDatabase::getPragma(const char* sql) {
 // us from calling VACUUM or keeping a running total, which can be costly.
 bool OfflineDatabase::evict(uint64_t neededFreeSize, DatabaseSizeChangeStats& stats) {
     checkFlags();
+    flushAccessedTimestamps();
     uint64_t ambientCacheSize =
         (initAmbientCacheSize() == nullptr) ? *currentAmbientCacheSize : maximumAmbientCacheSize;
     uint64_t newAmbientCacheSize = ambientCacheSize + neededFreeSize + stats.pageSize();
@@ -1290,6 +1486,93 @@ bool OfflineDatabase::evict(uint64_t neededFreeSize, DatabaseSizeChangeStats& st
     return true;
 }
 
+void OfflineDatabase::recordResourceAccess(const std::string& url) {
+    const Timestamp now = util::now();
+    pendingResourceAccesses[url] = now;
+    if (!firstPendingAccess) {
+        firstPendingAccess = now;
+    }
+}
+
+void OfflineDatabase::recordTileAccess(const Resource::TileData& tile) {
+    const Timestamp now = util::now();
+    pendingTileAccesses[std::make_tuple(tile.urlTemplate, tile.pixelRatio, tile.x, tile.y, tile.z)] = now;
+    if (!firstPendingAccess) {
+        firstPendingAccess = now;
+    }
+}
+
+void OfflineDatabase::flushAccessedTimestampsIfNeeded() {
+    if (firstPendingAccess &&
+        (pendingResourceAccesses.size() + pendingTileAccesses.size() >= ACCESSED_TIMESTAMPS_FLUSH_COUNT ||
+         util::now() - *firstPendingAccess >= ACCESSED_TIMESTAMPS_FLUSH_INTERVAL)) {
+        flushAccessedTimestamps();
+    }
+}
+
+void OfflineDatabase::flushAccessedTimestamps() {
+    // Keep the timestamps until they can be written.
+    if (!firstPendingAccess || !db || readOnly) {
+        return;
+    }
+
+    auto resources = std::move(pendingResourceAccesses);
+    auto tiles = std::move(pendingTileAccesses);
+    pendingResourceAccesses.clear();
+    pendingTileAccesses.clear();
+    firstPendingAccess = nullopt;
+
+    try {
+        // A savepoint works both within the transaction of a caller and on its own.
+        db->exec("SAVEPOINT accessed");
+        try {
+            // The row may have been written again since it was read, so never move its timestamp back.
+            mapbox::sqlite::Statement& resourceStatement =
+                getStatement("UPDATE resources SET accessed = max(accessed, ?1) WHERE url = ?2");
+            for (const auto& entry : resources) {
+                mapbox::sqlite::Query query{resourceStatement};
+                query.bind(1, entry.second);
+                query.bind(2, entry.first);
+                query.run();
+            }
+
+            // clang-format off
+            mapbox::sqlite::Statement& tileStatement = getStatement(
+                "UPDATE tiles "
+                "SET accessed       = max(accessed, ?1) "
+                "WHERE url_template = ?2 "
+                "  AND pixel_ratio  = ?3 "
+                "  AND x            = ?4 "
+                "  AND y            = ?5 "
+                "  AND z            = ?6 ");
+            // clang-format on
+            for (const auto& entry : tiles) {
+                mapbox::sqlite::Query query{tileStatement};
+                query.bind(1, entry.second);
+                query.bind(2, std::get<0>(entry.first));
+                query.bind(3, std::get<1>(entry.first));
+                query.bind(4, std::get<2>(entry.first));
+                query.bind(5, std::get<3>(entry.first));
+                query.bind(6, std::get<4>(entry.first));
+                query.run();
+            }
+
+            db->exec("RELEASE accessed");
+        } catch (...) {
+            db->exec("ROLLBACK TO accessed");
+            db->exec("RELEASE accessed");
+            throw;
+        }
+    } catch (const mapbox::sqlite::Exception& ex) {
+        if (ex.code == mapbox::sqlite::ResultCode::NotADB || ex.code == mapbox::sqlite::ResultCode::Corrupt) {
+            throw;
+        }
+
+        // If we don't have any indication that the database is corrupt, continue as usual.
+        Log::Warning(Event::Database, static_cast<int>(ex.code), "Can't update timestamp: %s", ex.what());
+    }
+}
+
 std::exception_ptr OfflineDatabase::initAmbientCacheSize() {
     if (!currentAmbientCacheSize) {
         try {
@@ -1456,6 +1739,58 @@ void OfflineDatabase::reopenDatabaseReadOnly(bool readOnly_) {
     }
 }
 
+std::exception_ptr OfflineDatabase::setJournalMode(JournalMode mode) try {
+    journalMode = mode;
+    if (!readOnly) {
+        if (!db) {
+            initialize();
+        } else {
+            applyJournalSettings();
+        }
+    }
+    return nullptr;
+} catch (...) {
+    handleError("set journal mode");
+    return std::current_exception();
+}
+
+std::exception_ptr OfflineDatabase::setDurability(Durability durability_) try {
+    durability = durability_;
+    if (!readOnly) {
+        if (!db) {
+            initialize();
+        } else {
+            applyJournalSettings();
+        }
+    }
+    return nullptr;
+} catch (...) {
+    handleError("set durability");
+    return std::current_exception();
+}
+
+std::exception_ptr OfflineDatabase::setCompressionCodec(util::CompressionCodec codec, std::string dictionary) try {
+    // Payloads refer to their dictionary by its ID, which only trained dictionaries have.
+    if (!dictionary.empty() && util::getDictionaryID(dictionary) == 0) {
+        throw std::runtime_error("Compression dictionary has no ID");
+    }
+    auto newEncoder = util::makeCodec(codec, dictionary);
+    // Store the dictionary before switching codecs, so that a failed store leaves the previous
+    // codec in place instead of writing entries that refer to a missing dictionary.
+    if (!readOnly) {
+        if (!db) {
+            initialize();
+        }
+        storeCompressionDictionary(dictionary);
+    }
+    encoder = std::move(newEncoder);
+    compressionDictionary = std::move(dictionary);
+    return nullptr;
+} catch (...) {
+    handleError("set compression codec");
+    return std::current_exception();
+}
+
 OfflineDatabase::DatabaseSizeChangeStats::DatabaseSizeChangeStats(OfflineDatabase* db_) : db(db_) {
     assert(db);
     pageSize_ = db->getPragma<int64_t>("PRAGMA page_size");
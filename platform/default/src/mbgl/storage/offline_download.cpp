@@ -18,12 +18,18 @@
 #include <mbgl/util/tile_cover.hpp>
 #include <mbgl/util/tileset.hpp>
 
+#include <algorithm>
 #include <set>
+#include <vector>
 
 namespace {
 
-const size_t kResourcesBatchSize = 64;
+// Downloaded resources are inserted together once this many, or this many bytes, are buffered.
+const size_t kResourcesBatchSize = 256;
+const size_t kResourcesBatchBytes = 4 * 1024 * 1024;
+const size_t kResourcesCheckBatchSize = 256;
 const size_t kMarkBatchSize = 200;
+const uint32_t kMinimumConcurrentRequests = 2;
 
 } // namespace
 
@@ -232,6 +238,11 @@ void OfflineDownload::activateDownload() {
     status.downloadState = OfflineRegionDownloadState::Active;
     status.requiredResourceCount++;
 
+    concurrencyLimit = maximumConcurrentRequests();
+    latencySamples = 0;
+    minimumLatency = nullopt;
+    averageLatency = nullopt;
+
     auto styleResource = Resource::style(definition.match([](auto& reg){ return reg.styleURL; }));
     styleResource.setPriority(Resource::Priority::Low);
     styleResource.setUsage(Resource::Usage::Offline);
@@ -367,7 +378,7 @@ void OfflineDownload::activateDownload() {
    the first few errors is fruitless anyway.
 */
 void OfflineDownload::continueDownload() {
-    if (resourcesRemaining.empty()) {
+    if (resourcesRemaining.empty() && resourcesToRequest.empty()) {
         // Flush pending buffers.
         if (!flushResourcesBuffer()) return;
         if (status.complete()) {
@@ -379,23 +390,27 @@ void OfflineDownload::continueDownload() {
 
     if (resourcesToBeMarkedAsUsed.size() >= kMarkBatchSize) markPendingUsedResources();
 
-    uint32_t maxConcurrentRequests = util::DEFAULT_MAXIMUM_CONCURRENT_REQUESTS;
-    auto value = onlineFileSource.getProperty(MAX_CONCURRENT_REQUESTS_KEY);
-    if (uint64_t* maxRequests = value.getUint()) {
-        maxConcurrentRequests = static_cast<uint32_t>(*maxRequests);
+    const uint32_t maxConcurrentRequests = std::min(concurrencyLimit, maximumConcurrentRequests());
+    while (!resourcesToRequest.empty() && requests.size() < maxConcurrentRequests) {
+        requestResource(std::move(resourcesToRequest.front()));
+        resourcesToRequest.pop_front();
     }
 
-    while (!resourcesRemaining.empty() && requests.size() < maxConcurrentRequests) {
-        ensureResource(std::move(resourcesRemaining.front()));
-        resourcesRemaining.pop_front();
+    // Look up the next batch while the requests are in flight, so that it is ready by the time
+    // they complete.
+    if (!resourcesRemaining.empty() && !resourcesCheck && resourcesToRequest.size() < maxConcurrentRequests) {
+        checkResources();
     }
 }
 
 void OfflineDownload::deactivateDownload() {
     requiredSourceURLs.clear();
     resourcesRemaining.clear();
+    resourcesToRequest.clear();
+    resourcesCheck.reset();
     requests.clear();
     buffer.clear();
+    bufferSize = 0;
 }
 
 bool OfflineDownload::flushResourcesBuffer() {
@@ -403,6 +418,7 @@ bool OfflineDownload::flushResourcesBuffer() {
     try {
         offlineDatabase.putRegionResources(id, buffer, status);
         buffer.clear();
+        bufferSize = 0;
         observer->statusChanged(status);
         return true;
     } catch (const MapboxTileLimitExceededException&) {
@@ -448,9 +464,8 @@ void OfflineDownload::ensureResource(Resource&& resource,
     assert(resource.usage == Resource::Usage::Offline);
 
     auto workRequestsIt = requests.insert(requests.begin(), nullptr);
-    *workRequestsIt = util::RunLoop::Get()->invokeCancellable([=]() {
+    *workRequestsIt = util::RunLoop::Get()->invokeCancellable([=]() mutable {
         requests.erase(workRequestsIt);
-        const auto resourceKind = resource.kind;
         auto getResourceSizeInDatabase = [&] () -> optional<int64_t> {
             optional<int64_t> result;
             if (!callback) {
@@ -470,12 +485,7 @@ void OfflineDownload::ensureResource(Resource&& resource,
         optional<int64_t> offlineResponse = getResourceSizeInDatabase();
         if (offlineResponse) {
             assert(!resourcesToBeMarkedAsUsed.empty());
-            status.completedResourceCount++;
-            status.completedResourceSize += *offlineResponse;
-            if (resourceKind == Resource::Kind::Tile) {
-                status.completedTileCount += 1;
-                status.completedTileSize += *offlineResponse;
-            }
+            addCompletedResource(resource.kind, *offlineResponse);
 
             observer->statusChanged(status);
             continueDownload();
@@ -487,44 +497,134 @@ void OfflineDownload::ensureResource(Resource&& resource,
             return;
         }
 
-        auto fileRequestsIt = requests.insert(requests.begin(), nullptr);
-        *fileRequestsIt = onlineFileSource.request(resource, [=](const Response& onlineResponse) {
-            if (onlineResponse.error) {
-                observer->responseError(*onlineResponse.error);
-                if (onlineResponse.error->reason == Response::Error::Reason::NotFound) {
-                    // On error 404, we skip this request and go further.
-                    requests.erase(fileRequestsIt);
-                    assert(status.requiredResourceCount > 0);
-                    status.requiredResourceCount--;
-                    continueDownload();
-                }
+        requestResource(std::move(resource), std::move(callback));
+    });
+}
+
+void OfflineDownload::checkResources() {
+    resourcesCheck = util::RunLoop::Get()->invokeCancellable([this]() {
+        resourcesCheck.reset();
+
+        std::vector<Resource> batch;
+        while (!resourcesRemaining.empty() && batch.size() < kResourcesCheckBatchSize) {
+            batch.push_back(std::move(resourcesRemaining.front()));
+            resourcesRemaining.pop_front();
+        }
+
+        const auto sizes = offlineDatabase.hasRegionResources(batch);
+        bool completed = false;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (sizes[i]) {
+                addCompletedResource(batch[i].kind, *sizes[i]);
+                resourcesToBeMarkedAsUsed.push_back(std::move(batch[i]));
+                completed = true;
+            } else if (offlineDatabase.exceedsOfflineMapboxTileCountLimit(batch[i])) {
+                onMapboxTileCountLimitExceeded();
                 return;
+            } else {
+                resourcesToRequest.push_back(std::move(batch[i]));
             }
+        }
 
-            requests.erase(fileRequestsIt);
+        if (completed) {
+            observer->statusChanged(status);
+        }
+        continueDownload();
+    });
+}
 
-            if (callback) {
-                callback(onlineResponse);
+void OfflineDownload::requestResource(Resource&& resource, std::function<void(Response)> callback) {
+    const TimePoint requested = Clock::now();
+
+    auto fileRequestsIt = requests.insert(requests.begin(), nullptr);
+    *fileRequestsIt = onlineFileSource.request(resource, [=](const Response& onlineResponse) {
+        if (onlineResponse.error) {
+            observer->responseError(*onlineResponse.error);
+            if (onlineResponse.error->reason == Response::Error::Reason::NotFound) {
+                // On error 404, we skip this request and go further.
+                requests.erase(fileRequestsIt);
+                assert(status.requiredResourceCount > 0);
+                status.requiredResourceCount--;
+                continueDownload();
             }
+            return;
+        }
 
-            // Queue up for batched insertion
-            buffer.emplace_back(resource, onlineResponse);
+        requests.erase(fileRequestsIt);
+        updateConcurrencyLimit(Clock::now() - requested);
 
-            // Flush buffer periodically.
-            // Have to keep `resourcesRemaining.empty()` as the following condition would fail otherwise.
-            // TODO: Simplify the tile count limit check code path!
-            if ((buffer.size() == kResourcesBatchSize || resourcesRemaining.empty()) && !flushResourcesBuffer()) return;
+        if (callback) {
+            callback(onlineResponse);
+        }
 
-            if (offlineDatabase.exceedsOfflineMapboxTileCountLimit(resource)) {
-                onMapboxTileCountLimitExceeded();
-                return;
-            }
+        // Queue up for batched insertion
+        buffer.emplace_back(resource, onlineResponse);
+        if (onlineResponse.data) {
+            bufferSize += onlineResponse.data->size();
+        }
 
-            continueDownload();
-        });
+        // Flush buffer periodically.
+        // Have to keep `resourcesRemaining.empty()` as the following condition would fail otherwise.
+        // TODO: Simplify the tile count limit check code path!
+        if ((buffer.size() >= kResourcesBatchSize || bufferSize >= kResourcesBatchBytes ||
+             (resourcesRemaining.empty() && resourcesToRequest.empty())) &&
+            !flushResourcesBuffer())
+            return;
+
+        if (offlineDatabase.exceedsOfflineMapboxTileCountLimit(resource)) {
+            onMapboxTileCountLimitExceeded();
+            return;
+        }
+
+        continueDownload();
     });
 }
 
+void OfflineDownload::addCompletedResource(Resource::Kind kind, uint64_t size) {
+    status.completedResourceCount++;
+    status.completedResourceSize += size;
+    if (kind == Resource::Kind::Tile) {
+        status.completedTileCount += 1;
+        status.completedTileSize += size;
+    }
+}
+
+uint32_t OfflineDownload::maximumConcurrentRequests() const {
+    uint32_t maxConcurrentRequests = util::DEFAULT_MAXIMUM_CONCURRENT_REQUESTS;
+    auto value = onlineFileSource.getProperty(MAX_CONCURRENT_REQUESTS_KEY);
+    if (uint64_t* maxRequests = value.getUint()) {
+        maxConcurrentRequests = static_cast<uint32_t>(*maxRequests);
+    }
+    return maxConcurrentRequests;
+}
+
+/*
+   Adapts the number of requests in flight to the latency of the responses, once per round of
+   `concurrencyLimit` responses. While the average latency stays close to the lowest one seen,
+   the server keeps up and the limit grows by one, up to the file source maximum. Once requests
+   start queueing, upstream or in the file source, the average latency climbs and the limit is
+   cut by a quarter. The baseline then rises a little, so that it follows a network that got
+   slower for good instead of throttling the download forever.
+*/
+void OfflineDownload::updateConcurrencyLimit(Duration latency) {
+    if (!minimumLatency || latency < *minimumLatency) {
+        minimumLatency = latency;
+    }
+    averageLatency = averageLatency ? (*averageLatency * 7 + latency) / 8 : latency;
+
+    if (++latencySamples < concurrencyLimit) {
+        return;
+    }
+    latencySamples = 0;
+
+    if (*averageLatency > *minimumLatency * 2) {
+        concurrencyLimit = std::max(kMinimumConcurrentRequests, concurrencyLimit * 3 / 4);
+        *minimumLatency += *minimumLatency / 8;
+    } else if (concurrencyLimit < maximumConcurrentRequests()) {
+        concurrencyLimit++;
+    }
+}
+
 void OfflineDownload::onMapboxTileCountLimitExceeded() {
     observer->mapboxTileCountLimitExceeded(offlineDatabase.getOfflineMapboxTileCountLimit());
     setState(OfflineRegionDownloadState::Inactive);
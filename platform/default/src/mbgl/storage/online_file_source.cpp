@@ -23,9 +23,12 @@
 #include <mbgl/util/timer.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <list>
 #include <map>
+#include <random>
+#include <unordered_map>
 #include <utility>
 
 namespace mbgl {
@@ -51,6 +54,8 @@ struct OnlineFileRequest {
     void onCancel(std::function<void()>);
 
     Duration getUpdateInterval(optional<Timestamp> expires) const;
+    Duration getRevalidationJitter(Duration timeout);
+    bool isRevalidation() const;
     OnlineFileSourceThread& impl;
     Resource resource;
     std::unique_ptr<AsyncRequest> request;
@@ -70,6 +75,9 @@ struct OnlineFileRequest {
     uint32_t failedRequests = 0;
     Response::Error::Reason failedRequestReason = Response::Error::Reason::Success;
     optional<Timestamp> retryAfter;
+
+    // Whether the request was counted as a revalidation when it was activated.
+    bool revalidating = false;
 };
 
 class OnlineFileSourceThread {
@@ -77,6 +85,7 @@ public:
     OnlineFileSourceThread(const ResourceOptions& options): resourceOptions(options.clone()), httpFileSource(options) {
         NetworkStatus::Subscribe(&reachability);
         setMaximumConcurrentRequests(util::DEFAULT_MAXIMUM_CONCURRENT_REQUESTS);
+        setMaximumConcurrentRevalidations(util::DEFAULT_MAXIMUM_CONCURRENT_REVALIDATIONS);
     }
 
     ~OnlineFileSourceThread() { NetworkStatus::Unsubscribe(&reachability); }
@@ -93,6 +102,18 @@ public:
         tasks.erase(it);
     }
 
+    void setPriority(AsyncRequest* req, Resource::Priority priority) {
+        auto it = tasks.find(req);
+        if (it == tasks.end()) {
+            return;
+        }
+
+        OnlineFileRequest* task = it->second.get();
+        pendingRequests.setPriority(task, priority);
+        pendingRevalidations.setPriority(task, priority);
+        task->resource.setPriority(priority);
+    }
+
     void add(OnlineFileRequest* req) {
         allRequests.insert(req);
         if (resourceTransform) {
@@ -110,9 +131,11 @@ public:
     void remove(OnlineFileRequest* req) {
         allRequests.erase(req);
         if (activeRequests.erase(req)) {
+            deactivateRevalidation(req);
             activatePendingRequest();
         } else {
             pendingRequests.remove(req);
+            pendingRevalidations.remove(req);
         }
     }
 
@@ -121,24 +144,36 @@ public:
         assert(activeRequests.find(req) == activeRequests.end());
         assert(!req->request);
 
-        if (activeRequests.size() >= getMaximumConcurrentRequests()) {
+        if (activeRequests.size() >= getMaximumConcurrentRequests() ||
+            (req->isRevalidation() && activeRevalidations >= getMaximumConcurrentRevalidations())) {
             queueRequest(req);
         } else {
             activateRequest(req);
         }
     }
 
-    void queueRequest(OnlineFileRequest* req) { pendingRequests.insert(req); }
+    void queueRequest(OnlineFileRequest* req) {
+        if (req->isRevalidation()) {
+            pendingRevalidations.insert(req);
+        } else {
+            pendingRequests.insert(req);
+        }
+    }
 
     void activateRequest(OnlineFileRequest* req) {
         auto callback = [=](const Response& response) {
             activeRequests.erase(req);
+            deactivateRevalidation(req);
             req->request.reset();
             req->completed(response);
             activatePendingRequest();
         };
 
         activeRequests.insert(req);
+        req->revalidating = req->isRevalidation();
+        if (req->revalidating) {
+            activeRevalidations++;
+        }
 
         if (online) {
             req->request = httpFileSource.request(req->resource, callback);
@@ -150,15 +185,35 @@ public:
         }
     }
 
+    void deactivateRevalidation(OnlineFileRequest* req) {
+        if (req->revalidating) {
+            assert(activeRevalidations > 0);
+            activeRevalidations--;
+            req->revalidating = false;
+        }
+    }
+
     void activatePendingRequest() {
-        auto req = pendingRequests.pop();
+        // Revalidations only compete with the other pending requests while there is room for
+        // another one; within the same priority level, requests for new resources go first.
+        optional<OnlineFileRequest*> req = pendingRequests.front();
+        if (activeRevalidations < getMaximumConcurrentRevalidations()) {
+            auto revalidation = pendingRevalidations.front();
+            if (revalidation && (!req || (*revalidation)->resource.priority < (*req)->resource.priority)) {
+                req = revalidation;
+            }
+        }
 
         if (req) {
+            pendingRequests.remove(*req);
+            pendingRevalidations.remove(*req);
             activateRequest(*req);
         }
     }
 
-    bool isPending(OnlineFileRequest* req) { return pendingRequests.contains(req); }
+    bool isPending(OnlineFileRequest* req) {
+        return pendingRequests.contains(req) || pendingRevalidations.contains(req);
+    }
 
     bool isActive(OnlineFileRequest* req) { return activeRequests.find(req) != activeRequests.end(); }
 
@@ -187,6 +242,12 @@ public:
         maximumConcurrentRequests = maximumConcurrentRequests_;
     }
 
+    uint32_t getMaximumConcurrentRevalidations() const { return maximumConcurrentRevalidations; }
+
+    void setMaximumConcurrentRevalidations(uint32_t maximumConcurrentRevalidations_) {
+        maximumConcurrentRevalidations = std::max(1u, maximumConcurrentRevalidations_);
+    }
+
     void setAPIBaseURL(std::string t) {
         resourceOptions.withTileServerOptions(TileServerOptions().withBaseURL(std::move(t)));
     }
@@ -200,81 +261,81 @@ private:
     friend struct OnlineFileRequest;
 
     void networkIsReachableAgain() {
-        // Notify regular priority requests.
-        for (auto& req : allRequests) {
-            if (req->resource.priority == Resource::Priority::Regular) {
-                req->networkIsReachableAgain();
-            }
-        }
-
-        // Notify low priority requests.
-        for (auto& req : allRequests) {
-            if (req->resource.priority == Resource::Priority::Low) {
-                req->networkIsReachableAgain();
+        // Notify requests in the order of their priority.
+        for (std::size_t level = 0; level < Resource::PriorityCount; ++level) {
+            for (auto& req : allRequests) {
+                if (static_cast<std::size_t>(req->resource.priority) == level) {
+                    req->networkIsReachableAgain();
+                }
             }
         }
     }
 
-    // Using Pending Requests as an priority queue which processes
-    // file requests in a FIFO manner but prefers regular requests
-    // over offline requests with a low priority such that low priority
-    // requests do not throttle regular requests.
+    // Using Pending Requests as a priority queue which processes file requests in a FIFO
+    // manner within each priority level, but always prefers the higher levels such that e.g.
+    // low priority offline requests do not throttle the requests for the visible map.
     //
-    // The order of a queue is therefore:
+    // Each level is a separate list, and the position of every queued request is indexed, so
+    // that cancelling or re-prioritizing a request doesn't need to search the queue:
     //
-    // hi0 -- hi1 -- hi2 -- hi3 -- lo0 -- lo1 --lo2
-    //                              ^
-    //                              firstLowPriorityRequest
-
-    struct PendingRequests {
-        PendingRequests() : firstLowPriorityRequest(queue.begin()) {}
-
-        std::list<OnlineFileRequest*> queue;
-        std::list<OnlineFileRequest*>::iterator firstLowPriorityRequest;
+    // High:     hi0 -- hi1
+    // Regular:  re0 -- re1 -- re2
+    // Prefetch:
+    // Low:      lo0 -- lo1 -- lo2 -- ...
 
+    class PendingRequests {
+    public:
         void remove(const OnlineFileRequest* request) {
-            auto it = std::find(queue.begin(), queue.end(), request);
-            if (it != queue.end()) {
-                if (it == firstLowPriorityRequest) {
-                    firstLowPriorityRequest++;
-                }
-                queue.erase(it);
+            auto it = positions.find(request);
+            if (it != positions.end()) {
+                queues[it->second.level].erase(it->second.position);
+                positions.erase(it);
             }
         }
 
-        void insert(OnlineFileRequest* request) {
-            if (request->resource.priority == Resource::Priority::Regular) {
-                firstLowPriorityRequest = queue.insert(firstLowPriorityRequest, request);
-                firstLowPriorityRequest++;
-            }
-            else {
-                if (firstLowPriorityRequest == queue.end()) {
-                    firstLowPriorityRequest = queue.insert(queue.end(), request);
-                }
-                else {
-                    queue.insert(queue.end(), request);
-                }
+        // Moves a queued request to the back of the given priority level.
+        void setPriority(const OnlineFileRequest* request, Resource::Priority priority) {
+            auto it = positions.find(request);
+            const auto level = static_cast<std::size_t>(priority);
+            assert(level < queues.size());
+            if (it == positions.end() || it->second.level == level) {
+                return;
             }
+
+            auto& queue = queues[level];
+            queue.splice(queue.end(), queues[it->second.level], it->second.position);
+            it->second.level = level;
         }
 
-        optional<OnlineFileRequest*> pop() {
-            if (queue.empty()) {
-                return {};
-            }
+        void insert(OnlineFileRequest* request) {
+            assert(!contains(request));
+            const auto level = static_cast<std::size_t>(request->resource.priority);
+            assert(level < queues.size());
+            auto& queue = queues[level];
+            positions.emplace(request, Position{level, queue.insert(queue.end(), request)});
+        }
 
-            if (queue.begin() == firstLowPriorityRequest) {
-                firstLowPriorityRequest++;
+        optional<OnlineFileRequest*> front() const {
+            for (const auto& queue : queues) {
+                if (!queue.empty()) {
+                    return {queue.front()};
+                }
             }
-
-            OnlineFileRequest* next = queue.front();
-            queue.pop_front();
-            return {next};
+            return {};
         }
 
-        bool contains(OnlineFileRequest* request) const {
-            return (std::find(queue.begin(), queue.end(), request) != queue.end());
-        }
+        bool contains(const OnlineFileRequest* request) const { return positions.find(request) != positions.end(); }
 
+    private:
+        using Queue = std::list<OnlineFileRequest*>;
+
+        struct Position {
+            std::size_t level;
+            Queue::iterator position;
+        };
+
+        std::array<Queue, Resource::PriorityCount> queues;
+        std::unordered_map<const OnlineFileRequest*, Position> positions;
     };
 
     ResourceTransform resourceTransform;
@@ -290,16 +351,22 @@ private:
      * 4. Back to #1
      *
      * Requests in any state are in `allRequests`. Requests in the pending state are in
-     * `pendingRequests`. Requests in the active state are in `activeRequests`.
+     * `pendingRequests`, or in `pendingRevalidations` when they revalidate a resource the
+     * requester already has. Requests in the active state are in `activeRequests`, and
+     * `activeRevalidations` counts the revalidations among them.
      */
     std::set<OnlineFileRequest*> allRequests;
 
     PendingRequests pendingRequests;
+    PendingRequests pendingRevalidations;
 
     std::set<OnlineFileRequest*> activeRequests;
+    uint32_t activeRevalidations = 0;
 
     bool online = true;
     uint32_t maximumConcurrentRequests;
+    uint32_t maximumConcurrentRevalidations;
+    std::minstd_rand random{static_cast<std::minstd_rand::result_type>(Clock::now().time_since_epoch().count())};
     HTTPFileSource httpFileSource;
     util::AsyncTask reachability{std::bind(&OnlineFileSourceThread::networkIsReachableAgain, this)};
     std::map<AsyncRequest*, std::unique_ptr<OnlineFileRequest>> tasks;
@@ -319,6 +386,10 @@ public:
         thread->actor().invoke(&OnlineFileSourceThread::request, req.get(), std::move(res), req->actor());
         return req;
     }
+
+    void setPriority(AsyncRequest& req, Resource::Priority priority) {
+        thread->actor().invoke(&OnlineFileSourceThread::setPriority, &req, priority);
+    }
  
     void pause() { thread->pause(); }
 
@@ -362,6 +433,26 @@ public:
         return cachedMaximumConcurrentRequests;
     }
 
+    void setMaximumConcurrentRevalidations(const mapbox::base::Value& value) {
+        if (auto* maximumConcurrentRevalidations = value.getUint()) {
+            assert(*maximumConcurrentRevalidations < std::numeric_limits<uint32_t>::max());
+            const auto maxConcurrentRevalidations = static_cast<uint32_t>(*maximumConcurrentRevalidations);
+            thread->actor().invoke(&OnlineFileSourceThread::setMaximumConcurrentRevalidations,
+                                   maxConcurrentRevalidations);
+            {
+                std::lock_guard<std::mutex> lock(maximumConcurrentRequestsMutex);
+                cachedMaximumConcurrentRevalidations = std::max(1u, maxConcurrentRevalidations);
+            }
+        } else {
+            Log::Error(Event::General, "Invalid max-concurrent-revalidations property value type.");
+        }
+    }
+
+    uint32_t getMaximumConcurrentRevalidations() const {
+        std::lock_guard<std::mutex> lock(maximumConcurrentRequestsMutex);
+        return cachedMaximumConcurrentRevalidations;
+    }
+
     void setApiKey(const mapbox::base::Value& value) {
         if (auto* apiKey = value.getString()) {
             thread->actor().invoke(&OnlineFileSourceThread::setApiKey, *apiKey);
@@ -402,6 +493,7 @@ private:
 
     mutable std::mutex maximumConcurrentRequestsMutex;
     uint32_t cachedMaximumConcurrentRequests = util::DEFAULT_MAXIMUM_CONCURRENT_REQUESTS;
+    uint32_t cachedMaximumConcurrentRevalidations = util::DEFAULT_MAXIMUM_CONCURRENT_REVALIDATIONS;
     const std::unique_ptr<util::Thread<OnlineFileSourceThread>> thread;
 };
 
@@ -454,6 +546,7 @@ void OnlineFileRequest::activate() {
     Duration timeout = Duration::zero();
     if (resource.priorExpires) {
         timeout = getUpdateInterval(resource.priorExpires);
+        timeout += getRevalidationJitter(timeout);
     }
     schedule(timeout);
 }
@@ -491,6 +584,25 @@ Duration OnlineFileRequest::getUpdateInterval(optional<Timestamp> expires) const
     return std::min(errorRetryTimeout, expirationTimeout);
 }
 
+bool OnlineFileRequest::isRevalidation() const {
+    // The requester already has data for this resource unless it is waiting for the prior data
+    // to be confirmed by the server, e.g. for a cached resource that must be revalidated.
+    return !resource.priorData && (resource.priorExpires || resource.priorModified || resource.priorEtag);
+}
+
+Duration OnlineFileRequest::getRevalidationJitter(Duration timeout) {
+    // Spread out revalidations of resources that expired together, e.g. all the tiles on screen
+    // after the application comes back from the background, instead of issuing them in a burst.
+    // Retries after errors keep their own backoff schedule.
+    if (!isRevalidation() || failedRequests > 0 || timeout == Duration::max()) {
+        return Duration::zero();
+    }
+
+    const Duration window = http::revalidationJitterWindow(timeout);
+    std::uniform_int_distribution<Duration::rep> distribution(0, window.count());
+    return Duration(distribution(impl.random));
+}
+
 namespace {
 
 inline std::string sanitizeURL(std::string& url) {
@@ -550,7 +662,9 @@ void OnlineFileRequest::completed(Response response) {
         failedRequestReason = Response::Error::Reason::Success;
     }
 
-    schedule(getUpdateInterval(response.expires));
+    Duration timeout = getUpdateInterval(response.expires);
+    timeout += getRevalidationJitter(timeout);
+    schedule(timeout);
 
     // Calling the callback may result in `this` being deleted. It needs to be done last,
     // and needs to make a local copy of the callback to ensure that it remains valid for
@@ -634,6 +748,10 @@ bool OnlineFileSource::canRequest(const Resource& resource) const {
            resource.url.rfind(mbgl::util::FILE_PROTOCOL, 0) == std::string::npos;
 }
 
+void OnlineFileSource::setPriority(AsyncRequest& req, Resource::Priority priority) {
+    impl->setPriority(req, priority);
+}
+
 void OnlineFileSource::pause() {
     impl->pause();
 }
@@ -649,6 +767,8 @@ void OnlineFileSource::setProperty(const std::string& key, const mapbox::base::V
         impl->setAPIBaseURL(value);
     } else if (key == MAX_CONCURRENT_REQUESTS_KEY) {
         impl->setMaximumConcurrentRequests(value);
+    } else if (key == MAX_CONCURRENT_REVALIDATIONS_KEY) {
+        impl->setMaximumConcurrentRevalidations(value);
     } else if (key == ONLINE_STATUS_KEY) {
         // For testing only
         if (auto* boolValue = value.getBool()) {
@@ -667,6 +787,8 @@ mapbox::base::Value OnlineFileSource::getProperty(const std::string& key) const
         return impl->getAPIBaseURL();
     } else if (key == MAX_CONCURRENT_REQUESTS_KEY) {
         return impl->getMaximumConcurrentRequests();
+    } else if (key == MAX_CONCURRENT_REVALIDATIONS_KEY) {
+        return impl->getMaximumConcurrentRevalidations();
     }
     std::string message = "Resource provider does not support property " + key;
     Log::Error(Event::General, message.c_str());
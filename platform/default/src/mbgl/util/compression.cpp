@@ -6,8 +6,14 @@
 #include <zlib.h>
 #endif
 
+#ifdef MBGL_USE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
 #include <cstdio>
 #include <cstring>
+#include <mutex>
 #include <stdexcept>
 
 // Check zlib library version.
@@ -100,5 +106,178 @@ std::string decompress(const std::string &raw) {
 
     return result;
 }
+
+namespace {
+
+class ZlibCodec final : public Codec {
+public:
+    CompressionCodec type() const override { return CompressionCodec::Zlib; }
+    std::string compress(const std::string& raw) const override { return util::compress(raw); }
+    std::string decompress(const std::string& compressed) const override { return util::decompress(compressed); }
+};
+
+#ifdef MBGL_USE_ZSTD
+
+// Favors decompression speed and a good ratio over compression speed; payloads are typically
+// written once and read many times.
+constexpr int zstdCompressionLevel = 6;
+
+class ZstdCodec final : public Codec {
+public:
+    explicit ZstdCodec(const std::string& dictionary) {
+        if (!dictionary.empty()) {
+            cdict.reset(ZSTD_createCDict(dictionary.data(), dictionary.size(), zstdCompressionLevel));
+            ddict.reset(ZSTD_createDDict(dictionary.data(), dictionary.size()));
+            if (!cdict || !ddict) {
+                throw std::runtime_error("failed to load zstd dictionary");
+            }
+        }
+        if (!cctx) {
+            throw std::runtime_error("failed to initialize zstd compression");
+        }
+        if (!dctx) {
+            throw std::runtime_error("failed to initialize zstd decompression");
+        }
+    }
+
+    CompressionCodec type() const override { return CompressionCodec::Zstd; }
+
+    std::string compress(const std::string& raw) const override {
+        std::string result(ZSTD_compressBound(raw.size()), '\0');
+        std::size_t size;
+        {
+            std::lock_guard<std::mutex> lock(cctxMutex);
+            size = cdict ? ZSTD_compress_usingCDict(
+                               cctx.get(), &result[0], result.size(), raw.data(), raw.size(), cdict.get())
+                         : ZSTD_compressCCtx(
+                               cctx.get(), &result[0], result.size(), raw.data(), raw.size(), zstdCompressionLevel);
+        }
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(ZSTD_getErrorName(size));
+        }
+
+        result.resize(size);
+        return result;
+    }
+
+    std::string decompress(const std::string& compressed) const override {
+        // Single-shot compression always records the content size in the frame.
+        const unsigned long long contentSize = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+        if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+            throw std::runtime_error("invalid zstd frame");
+        }
+
+        std::string result(contentSize, '\0');
+        std::size_t size;
+        {
+            std::lock_guard<std::mutex> lock(dctxMutex);
+            size = ddict ? ZSTD_decompress_usingDDict(
+                               dctx.get(), &result[0], result.size(), compressed.data(), compressed.size(), ddict.get())
+                         : ZSTD_decompressDCtx(
+                               dctx.get(), &result[0], result.size(), compressed.data(), compressed.size());
+        }
+        if (ZSTD_isError(size)) {
+            throw std::runtime_error(ZSTD_getErrorName(size));
+        }
+
+        result.resize(size);
+        return result;
+    }
+
+private:
+    std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)> cdict{nullptr, ZSTD_freeCDict};
+    std::unique_ptr<ZSTD_DDict, decltype(&ZSTD_freeDDict)> ddict{nullptr, ZSTD_freeDDict};
+
+    // Contexts are expensive to create, so they are reused for every payload. Single-shot calls
+    // reset them, and the mutexes allow a codec to be shared between threads.
+    mutable std::mutex cctxMutex;
+    const std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx{ZSTD_createCCtx(), ZSTD_freeCCtx};
+    mutable std::mutex dctxMutex;
+    const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx{ZSTD_createDCtx(), ZSTD_freeDCtx};
+};
+
+#endif // MBGL_USE_ZSTD
+
+} // namespace
+
+bool isCodecAvailable(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::Zlib:
+            return true;
+        case CompressionCodec::Zstd:
+#ifdef MBGL_USE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case CompressionCodec::None:
+            break;
+    }
+    return false;
+}
+
+std::unique_ptr<Codec> makeCodec(CompressionCodec codec, const std::string& dictionary) {
+    switch (codec) {
+        case CompressionCodec::Zlib:
+            if (!dictionary.empty()) {
+                throw std::runtime_error("zlib doesn't support dictionaries");
+            }
+            return std::make_unique<ZlibCodec>();
+        case CompressionCodec::Zstd:
+#ifdef MBGL_USE_ZSTD
+            return std::make_unique<ZstdCodec>(dictionary);
+#else
+            throw std::runtime_error("zstd isn't available in this build");
+#endif
+        case CompressionCodec::None:
+            break;
+    }
+    throw std::runtime_error("unknown compression codec");
+}
+
+std::string trainDictionary(const std::vector<std::string>& samples, std::size_t maxSize) {
+#ifdef MBGL_USE_ZSTD
+    std::string buffer;
+    std::vector<std::size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        buffer += sample;
+        sizes.push_back(sample.size());
+    }
+
+    std::string dictionary(maxSize, '\0');
+    const std::size_t size = ZDICT_trainFromBuffer(
+        &dictionary[0], dictionary.size(), buffer.data(), sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        throw std::runtime_error(ZDICT_getErrorName(size));
+    }
+
+    dictionary.resize(size);
+    return dictionary;
+#else
+    (void)samples;
+    (void)maxSize;
+    throw std::runtime_error("zstd isn't available in this build");
+#endif
+}
+
+uint32_t getDictionaryID(const std::string& dictionary) {
+#ifdef MBGL_USE_ZSTD
+    return ZDICT_getDictID(dictionary.data(), dictionary.size());
+#else
+    (void)dictionary;
+    return 0;
+#endif
+}
+
+uint32_t getPayloadDictionaryID(const std::string& compressed) {
+#ifdef MBGL_USE_ZSTD
+    return ZSTD_getDictID_fromFrame(compressed.data(), compressed.size());
+#else
+    (void)compressed;
+    return 0;
+#endif
+}
+
 } // namespace util
 } // namespace mbgl
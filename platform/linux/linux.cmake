@@ -8,6 +8,7 @@ find_package(PkgConfig REQUIRED)
 find_package(X11 REQUIRED)
 
 pkg_search_module(LIBUV libuv REQUIRED)
+pkg_search_module(ZSTD libzstd)
 
 target_sources(
     mbgl-core
@@ -62,6 +63,7 @@ target_include_directories(
         ${JPEG_INCLUDE_DIRS}
         ${LIBUV_INCLUDE_DIRS}
         ${X11_INCLUDE_DIRS}
+        ${ZSTD_INCLUDE_DIRS}
 )
 
 include(${PROJECT_SOURCE_DIR}/vendor/nunicode.cmake)
@@ -81,6 +83,17 @@ if(NOT ${ICU_FOUND} OR "${ICU_VERSION}" VERSION_LESS 62.0)
     )
 endif()
 
+if(ZSTD_FOUND)
+    set_source_files_properties(
+        ${PROJECT_SOURCE_DIR}/platform/default/src/mbgl/util/compression.cpp
+        PROPERTIES
+        COMPILE_DEFINITIONS
+        MBGL_USE_ZSTD
+    )
+else()
+    message("-- zstd not found, the offline database will only compress with zlib.")
+endif()
+
 target_link_libraries(
     mbgl-core
     PRIVATE
@@ -88,6 +101,7 @@ target_link_libraries(
         ${JPEG_LIBRARIES}
         ${LIBUV_LIBRARIES}
         ${X11_LIBRARIES}
+        ${ZSTD_LIBRARIES}
         $<$<NOT:$<BOOL:${MBGL_USE_BUILTIN_ICU}>>:ICU::i18n>
         $<$<NOT:$<BOOL:${MBGL_USE_BUILTIN_ICU}>>:ICU::uc>
         $<$<BOOL:${MBGL_USE_BUILTIN_ICU}>:mbgl-vendor-icu>
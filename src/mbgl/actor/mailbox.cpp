@@ -24,9 +24,9 @@ void Mailbox::open(Scheduler& scheduler_) {
         return;
     }
     
+    std::lock_guard<std::mutex> queueLock(queueMutex);
     if (!queue.empty()) {
-        auto guard = weakScheduler.lock();
-        if (weakScheduler) weakScheduler->schedule(makeClosure(shared_from_this()));
+        schedule();
     }
 }
 
@@ -46,6 +46,20 @@ bool Mailbox::isOpen() const {
     return bool(weakScheduler);
 }
 
+void Mailbox::setPriority(TaskPriority priority_) {
+    std::lock_guard<std::mutex> pushingLock(pushingMutex);
+
+    if (priority.exchange(priority_) == priority_ || closed) {
+        return;
+    }
+
+    // Move the processing of the queued messages to the new lane.
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    if (!queue.empty()) {
+        schedule();
+    }
+}
+
 void Mailbox::push(std::unique_ptr<Message> message) {
     std::lock_guard<std::mutex> pushingLock(pushingMutex);
 
@@ -56,9 +70,8 @@ void Mailbox::push(std::unique_ptr<Message> message) {
     std::lock_guard<std::mutex> queueLock(queueMutex);
     bool wasEmpty = queue.empty();
     queue.push(std::move(message));
-    auto guard = weakScheduler.lock();
-    if (wasEmpty && weakScheduler) {
-        weakScheduler->schedule(makeClosure(shared_from_this()));
+    if (wasEmpty) {
+        schedule();
     }
 }
 
@@ -86,20 +99,38 @@ void Mailbox::receive() {
     (*message)();
 
     if (!wasEmpty) {
-        weakScheduler->schedule(makeClosure(shared_from_this()));
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        schedule();
+    }
+}
+
+void Mailbox::schedule() {
+    auto guard = weakScheduler.lock();
+    if (weakScheduler) {
+        weakScheduler->scheduleWithPriority(priority, makeClosure(shared_from_this(), ++generation));
     }
 }
 
 // static
-void Mailbox::maybeReceive(const std::weak_ptr<Mailbox>& mailbox) {
+void Mailbox::maybeReceive(const std::weak_ptr<Mailbox>& mailbox, uint64_t generation) {
     if (auto locked = mailbox.lock()) {
+        // Holding the receiving mutex keeps other closures from taking messages before this one
+        // receives, so the queue can't run empty after the check.
+        std::lock_guard<std::recursive_mutex> receivingLock(locked->receivingMutex);
+        {
+            std::lock_guard<std::mutex> queueLock(locked->queueMutex);
+            // Superseded by a closure scheduled later, or the messages were received already.
+            if (generation != locked->generation || locked->queue.empty()) {
+                return;
+            }
+        }
         locked->receive();
     }
 }
 
 // static
-std::function<void()> Mailbox::makeClosure(std::weak_ptr<Mailbox> mailbox) {
-    return [mailbox = std::move(mailbox)]() { maybeReceive(mailbox); };
+std::function<void()> Mailbox::makeClosure(std::weak_ptr<Mailbox> mailbox, uint64_t generation) {
+    return [mailbox = std::move(mailbox), generation]() { maybeReceive(mailbox, generation); };
 }
 
 } // namespace mbgl
@@ -210,6 +210,23 @@ void FeatureIndex::setBucketLayerIDs(const std::string& bucketLeaderID, const st
     bucketLayerIDs[bucketLeaderID] = layerIDs;
 }
 
+std::size_t FeatureIndex::getMemoryUsage() const {
+    return grid.getMemoryUsage();
+}
+
+void FeatureIndex::append(FeatureIndex&& other) {
+    const auto offset = sortIndex;
+    other.grid.forEach([&](IndexedSubfeature& feature, const GridIndex<IndexedSubfeature>::BBox& box) {
+        feature.sortIndex += offset;
+        grid.insert(std::move(feature), box);
+    });
+    sortIndex += other.sortIndex;
+
+    for (auto& pair : other.bucketLayerIDs) {
+        bucketLayerIDs[pair.first] = std::move(pair.second);
+    }
+}
+
 DynamicFeatureIndex::~DynamicFeatureIndex() = default;
 
 void DynamicFeatureIndex::query(std::unordered_map<std::string, std::vector<Feature>>& result,
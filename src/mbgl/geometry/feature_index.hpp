@@ -100,6 +100,13 @@ public:
 
     void setBucketLayerIDs(const std::string& bucketLeaderID, const std::vector<std::string>& layerIDs);
 
+    // Adds the features indexed by `other` as if they were inserted into this
+    // index after the ones it already contains. The tile data of `other` is ignored.
+    void append(FeatureIndex&& other);
+
+    // Returns an estimate of the bytes retained by the index, excluding the tile data.
+    std::size_t getMemoryUsage() const;
+
     std::unordered_map<std::string, std::vector<Feature>> lookupSymbolFeatures(
         const std::vector<IndexedSubfeature>& symbolFeatures,
         const RenderedQueryOptions& options,
@@ -47,6 +47,10 @@ public:
 
     virtual bool hasData() const = 0;
 
+    // Returns an estimate of the bytes retained by this bucket, i.e. the vertex and index data
+    // and any images it holds.
+    virtual std::size_t getMemoryUsage() const { return 0; }
+
     virtual float getQueryRadius(const RenderLayer&) const {
         return 0;
     };
@@ -23,6 +23,7 @@ public:
     ~CircleBucket() override;
 
     bool hasData() const override;
+    std::size_t getMemoryUsage() const override;
 
     void upload(gfx::UploadPass&) override;
 
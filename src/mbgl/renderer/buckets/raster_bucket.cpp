@@ -108,5 +108,9 @@ bool RasterBucket::hasData() const {
     return !!image;
 }
 
+std::size_t RasterBucket::getMemoryUsage() const {
+    return vertices.bytes() + indices.bytes() + (image ? image->bytes() : 0);
+}
+
 
 } // namespace mbgl
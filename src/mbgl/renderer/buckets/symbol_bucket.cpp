@@ -178,6 +178,24 @@ bool SymbolBucket::hasData() const {
            hasTextCollisionBoxData() || hasIconCollisionCircleData() || hasTextCollisionCircleData();
 }
 
+std::size_t SymbolBucket::getMemoryUsage() const {
+    auto bufferBytes = [](const Buffer& buffer) {
+        return buffer.vertices.bytes() + buffer.dynamicVertices.bytes() + buffer.opacityVertices.bytes() +
+               buffer.triangles.bytes() + buffer.placedSymbols.size() * sizeof(PlacedSymbol);
+    };
+    auto collisionBytes = [](const CollisionBuffer* buffer) -> std::size_t {
+        return buffer ? buffer->vertices.bytes() + buffer->dynamicVertices.bytes() : 0;
+    };
+
+    std::size_t bytes = symbolInstances.size() * sizeof(SymbolInstance);
+    bytes += bufferBytes(text) + bufferBytes(icon) + bufferBytes(sdfIcon);
+    bytes += collisionBytes(iconCollisionBox.get()) + (iconCollisionBox ? iconCollisionBox->lines.bytes() : 0);
+    bytes += collisionBytes(textCollisionBox.get()) + (textCollisionBox ? textCollisionBox->lines.bytes() : 0);
+    bytes += collisionBytes(iconCollisionCircle.get()) + (iconCollisionCircle ? iconCollisionCircle->triangles.bytes() : 0);
+    bytes += collisionBytes(textCollisionCircle.get()) + (textCollisionCircle ? textCollisionCircle->triangles.bytes() : 0);
+    return bytes;
+}
+
 bool SymbolBucket::hasTextData() const {
     return !text.segments.empty();
 }
@@ -1,32 +1,43 @@
 #include <mbgl/renderer/group_by_layout.hpp>
-#include <mbgl/style/conversion/stringify.hpp>
-#include <mbgl/util/rapidjson.hpp>
-
-#include <rapidjson/writer.h>
-#include <rapidjson/stringbuffer.h>
 
 #include <unordered_map>
 
 namespace mbgl {
 
-std::string layoutKey(const style::Layer::Impl& impl) {
-    using namespace style::conversion;
+const std::string& layoutKey(const style::Layer::Impl& impl) {
+    return impl.getLayoutKey();
+}
+
+namespace {
+
+struct LayoutKeyHash {
+    std::size_t operator()(const style::Layer::Impl* impl) const { return impl->getLayoutKeyHash(); }
+};
+
+struct LayoutKeyEqual {
+    bool operator()(const style::Layer::Impl* lhs, const style::Layer::Impl* rhs) const {
+        return lhs == rhs ||
+               (lhs->getLayoutKeyHash() == rhs->getLayoutKeyHash() && lhs->getLayoutKey() == rhs->getLayoutKey());
+    }
+};
+
+} // namespace
 
-    rapidjson::StringBuffer s;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+std::vector<std::vector<Immutable<style::LayerProperties>>> groupByLayout(
+    const std::vector<Immutable<style::LayerProperties>>& layers) {
+    std::unordered_map<const style::Layer::Impl*, std::size_t, LayoutKeyHash, LayoutKeyEqual> groupIndices;
+    groupIndices.reserve(layers.size());
 
-    writer.StartArray();
-    writer.Uint64(reinterpret_cast<uint64_t>(impl.getTypeInfo()));
-    writer.String(impl.source);
-    writer.String(impl.sourceLayer);
-    writer.Double(impl.minZoom);
-    writer.Double(impl.maxZoom);
-    writer.Uint(static_cast<uint32_t>(impl.visibility));
-    stringify(writer, impl.filter);
-    impl.stringifyLayout(writer);
-    writer.EndArray();
+    std::vector<std::vector<Immutable<style::LayerProperties>>> groups;
+    for (const auto& layer : layers) {
+        auto inserted = groupIndices.emplace(layer->baseImpl.get(), groups.size());
+        if (inserted.second) {
+            groups.emplace_back();
+        }
+        groups[inserted.first->second].push_back(layer);
+    }
 
-    return s.GetString();
+    return groups;
 }
 
 } // namespace mbgl
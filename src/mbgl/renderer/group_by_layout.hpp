@@ -1,12 +1,18 @@
 #pragma once
 
 #include <mbgl/style/layer_impl.hpp>
+#include <mbgl/style/layer_properties.hpp>
 
 #include <vector>
 #include <memory>
 
 namespace mbgl {
 
-std::string layoutKey(const style::Layer::Impl& impl);
+const std::string& layoutKey(const style::Layer::Impl& impl);
+
+// Groups the given layers by their layout key, keeping the relative order of the layers.
+// Uses the keys cached on the layer impls, so no key strings are built.
+std::vector<std::vector<Immutable<style::LayerProperties>>> groupByLayout(
+    const std::vector<Immutable<style::LayerProperties>>&);
 
 } // namespace mbgl
@@ -2,6 +2,7 @@
 
 #include <mbgl/annotation/annotation_manager.hpp>
 #include <mbgl/layermanager/layer_manager.hpp>
+#include <mbgl/platform/settings.hpp>
 #include <mbgl/renderer/renderer_observer.hpp>
 #include <mbgl/renderer/render_source.hpp>
 #include <mbgl/renderer/render_layer.hpp>
@@ -116,6 +117,14 @@ RenderOrchestrator::RenderOrchestrator(bool backgroundLayerAsColor_, const optio
       backgroundLayerAsColor(backgroundLayerAsColor_) {
     glyphManager->setObserver(this);
     imageManager->setObserver(this);
+
+    auto value = platform::Settings::getInstance().get(platform::EXPERIMENTAL_PLACEMENT_TIME_BUDGET);
+    if (auto* milliseconds = value.getDouble()) {
+        placementTimeBudget =
+            std::chrono::duration_cast<Duration>(std::chrono::duration<double, std::milli>(*milliseconds));
+    } else if (auto* integerMilliseconds = value.getUint()) {
+        placementTimeBudget = Milliseconds(*integerMilliseconds);
+    }
 }
 
 RenderOrchestrator::~RenderOrchestrator() {
@@ -280,6 +289,9 @@ std::unique_ptr<RenderTree> RenderOrchestrator::createRenderTree(
         renderSource->setObserver(this);
         renderSources.emplace(entry.first, std::move(renderSource));
     }
+    if (!sourceDiff.added.empty() || !sourceDiff.removed.empty()) {
+        updateTileCacheMemoryBudgets();
+    }
     transformState = updateParameters->transformState;
     const bool tiltedView = transformState.getPitch() != 0.0f;
 
@@ -406,13 +418,28 @@ std::unique_ptr<RenderTree> RenderOrchestrator::createRenderTree(
             placementUpdatePeriodOverride = optional<Duration>(Milliseconds(30));
         }
 
-        renderTreeParameters->placementChanged = !placementController.placementIsRecent(
-            updateParameters->timePoint, updateParameters->transformState.getZoom(), placementUpdatePeriodOverride);
+        if (!pendingPlacement && !placementController.placementIsRecent(updateParameters->timePoint,
+                                                                        updateParameters->transformState.getZoom(),
+                                                                        placementUpdatePeriodOverride)) {
+            pendingPlacement = Placement::create(updateParameters, placementController.getPlacement());
+        }
+
+        // With a time budget, the placement is spread over several frames, which keep rendering
+        // with the previous placement until the new one is committed.
+        renderTreeParameters->placementChanged = false;
+        if (pendingPlacement) {
+            if (placementTimeBudget > Duration::zero()) {
+                renderTreeParameters->placementChanged = (*pendingPlacement)->placeLayersIncrementally(
+                    layersNeedPlacement, updateParameters->timePoint, placementTimeBudget);
+            } else {
+                (*pendingPlacement)->placeLayers(layersNeedPlacement);
+                renderTreeParameters->placementChanged = true;
+            }
+        }
         symbolBucketsChanged |= renderTreeParameters->placementChanged;
         if (renderTreeParameters->placementChanged) {
-            Mutable<Placement> placement = Placement::create(updateParameters, placementController.getPlacement());
-            placement->placeLayers(layersNeedPlacement);
-            placementController.setPlacement(std::move(placement));
+            placementController.setPlacement(std::move(*pendingPlacement));
+            pendingPlacement = nullopt;
             crossTileSymbolIndex.pruneUnusedLayers(usedSymbolLayers);
             for (const auto& entry : renderSources) {
                 entry.second->updateFadingTiles();
@@ -431,6 +458,7 @@ std::unique_ptr<RenderTree> RenderOrchestrator::createRenderTree(
             placement->placeLayers(layersNeedPlacement);
             placementController.setPlacement(std::move(placement));
         }
+        pendingPlacement = nullopt;
         crossTileSymbolIndex.reset();
         renderTreeParameters->symbolFadeChange = 1.0f;
         renderTreeParameters->needsRepaint = false;
@@ -636,6 +664,30 @@ void RenderOrchestrator::reduceMemoryUse() {
     observer->onInvalidate();
 }
 
+void RenderOrchestrator::setTileCacheMemoryBudget(std::size_t bytes) {
+    tileCacheMemoryBudget = bytes;
+    updateTileCacheMemoryBudgets();
+}
+
+void RenderOrchestrator::updateTileCacheMemoryBudgets() {
+    // Every source gets an equal share, so that their caches together stay within the budget.
+    std::size_t bytes = tileCacheMemoryBudget;
+    if (bytes != std::numeric_limits<std::size_t>::max() && !renderSources.empty()) {
+        bytes /= renderSources.size();
+    }
+    for (const auto& entry : renderSources) {
+        entry.second->setTileCacheMemoryBudget(bytes);
+    }
+}
+
+std::size_t RenderOrchestrator::getTileCacheMemoryUsage() const {
+    std::size_t bytes = 0;
+    for (const auto& entry : renderSources) {
+        bytes += entry.second->getTileCacheMemoryUsage();
+    }
+    return bytes;
+}
+
 void RenderOrchestrator::dumpDebugLogs() {
     for (const auto& entry : renderSources) {
         entry.second->dumpDebugLogs();
@@ -710,6 +762,7 @@ void RenderOrchestrator::clearData() {
     renderLayers.clear();
 
     crossTileSymbolIndex.reset();
+    pendingPlacement = nullopt;
 
     if (!lineAtlas->isEmpty()) lineAtlas = std::make_unique<LineAtlas>();
     if (!patternAtlas->isEmpty()) patternAtlas = std::make_unique<PatternAtlas>();
@@ -13,6 +13,7 @@
 #include <mbgl/renderer/image_manager_observer.hpp>
 #include <mbgl/text/placement.hpp>
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -71,6 +72,8 @@ public:
                             const optional<std::string>& featureID, const optional<std::string>& stateKey);
 
     void reduceMemoryUse();
+    void setTileCacheMemoryBudget(std::size_t);
+    std::size_t getTileCacheMemoryUsage() const;
     void dumpDebugLogs();
     void collectPlacedSymbolData(bool);
     const std::vector<PlacedSymbolData>& getPlacedSymbolsData() const;
@@ -81,6 +84,7 @@ private:
     bool hasTransitions(TimePoint) const;
 
     RenderSource* getRenderSource(const std::string& id) const;
+    void updateTileCacheMemoryBudgets();
 
           RenderLayer* getRenderLayer(const std::string& id);
     const RenderLayer* getRenderLayer(const std::string& id) const;
@@ -123,10 +127,14 @@ private:
 
     CrossTileSymbolIndex crossTileSymbolIndex;
     PlacementController placementController;
+    // Placement that is being computed over several frames, see EXPERIMENTAL_PLACEMENT_TIME_BUDGET.
+    optional<Mutable<Placement>> pendingPlacement;
+    Duration placementTimeBudget = Duration::zero();
 
     const bool backgroundLayerAsColor;
     bool contextLost = false;
     bool placedSymbolDataCollected = false;
+    std::size_t tileCacheMemoryBudget = std::numeric_limits<std::size_t>::max();
 
     // Vectors with reserved capacity of layerImpls->size() to avoid reallocation
     // on each frame.
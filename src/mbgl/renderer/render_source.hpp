@@ -102,6 +102,10 @@ public:
 
     virtual void reduceMemoryUse() = 0;
 
+    // Limits the bytes retained by tiles that are cached but not currently rendered.
+    virtual void setTileCacheMemoryBudget(std::size_t) {}
+    virtual std::size_t getTileCacheMemoryUsage() const { return 0; }
+
     virtual void dumpDebugLogs() const = 0;
 
     virtual uint8_t getMaxZoom() const;
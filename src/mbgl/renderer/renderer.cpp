@@ -143,4 +143,12 @@ void Renderer::clearData() {
     impl->orchestrator.clearData();
 }
 
+void Renderer::setTileCacheMemoryBudget(std::size_t bytes) {
+    impl->orchestrator.setTileCacheMemoryBudget(bytes);
+}
+
+std::size_t Renderer::getTileCacheMemoryUsage() const {
+    return impl->orchestrator.getTileCacheMemoryUsage();
+}
+
 } // namespace mbgl
@@ -154,6 +154,14 @@ void RenderTileSource::reduceMemoryUse() {
     tilePyramid.reduceMemoryUse();
 }
 
+void RenderTileSource::setTileCacheMemoryBudget(std::size_t bytes) {
+    tilePyramid.setCacheMemoryBudget(bytes);
+}
+
+std::size_t RenderTileSource::getTileCacheMemoryUsage() const {
+    return tilePyramid.getCacheMemoryUsage();
+}
+
 void RenderTileSource::dumpDebugLogs() const {
     tilePyramid.dumpDebugLogs();
 }
@@ -43,6 +43,8 @@ public:
                             const optional<std::string>&) override;
 
     void reduceMemoryUse() override;
+    void setTileCacheMemoryBudget(std::size_t) override;
+    std::size_t getTileCacheMemoryUsage() const override;
     void dumpDebugLogs() const override;
 
 protected:
@@ -72,6 +72,7 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
                 // for them and thus suppress network requests on
                 // tiles expiration (see `OnlineFileRequest`).
                 entry.second->setNecessity(TileNecessity::Optional);
+                entry.second->setPriority(TaskPriority::Low);
                 cache.add(entry.first, std::move(entry.second));
             }
         }
@@ -149,6 +150,19 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
             tile.setLayers(layers);
         }
     };
+
+    // Tiles covering the viewport are parsed first, followed by the parent and child
+    // tiles shown in their place while they're loading, and then the prefetched tiles.
+    // The priority is set first so that it also applies to the network request a newly
+    // required tile makes.
+    auto retainIdealTileFn = [&](Tile& tile, TileNecessity necessity) -> void {
+        tile.setPriority(tile.id.overscaledZ == tileZoom ? TaskPriority::High : TaskPriority::Normal);
+        retainTileFn(tile, necessity);
+    };
+    auto retainPanTileFn = [&](Tile& tile, TileNecessity necessity) -> void {
+        tile.setPriority(TaskPriority::Low);
+        retainTileFn(tile, necessity);
+    };
     auto getTileFn = [&](const OverscaledTileID& tileID) -> Tile* {
         auto it = tiles.find(tileID);
         return it == tiles.end() ? nullptr : it->second.get();
@@ -191,7 +205,7 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
         algorithm::updateRenderables(
             getTileFn,
             createTileFn,
-            retainTileFn,
+            retainPanTileFn,
             [](const UnwrappedTileID&, Tile&) {},
             panTiles,
             zoomRange,
@@ -199,7 +213,7 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
     }
 
     algorithm::updateRenderables(
-        getTileFn, createTileFn, retainTileFn, renderTileFn, idealTiles, zoomRange, maxParentTileOverscaleFactor);
+        getTileFn, createTileFn, retainIdealTileFn, renderTileFn, idealTiles, zoomRange, maxParentTileOverscaleFactor);
 
     for (auto previouslyRenderedTile : previouslyRenderedTiles) {
         Tile& tile = previouslyRenderedTile.second;
@@ -208,6 +222,7 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
             // Since it was rendered in the last frame, we know we have it
             // Don't mark the tile "Required" to avoid triggering a new network request
             retainTileFn(tile, TileNecessity::Optional);
+            tile.setPriority(TaskPriority::Low);
             addRenderTile(previouslyRenderedTile.first, tile);
         }
     }
@@ -229,6 +244,7 @@ void TilePyramid::update(const std::vector<Immutable<style::LayerProperties>>& l
             if (retainIt == retain.end() || tilesIt->first < *retainIt) {
                 if (!needsRelayout) {
                     tilesIt->second->setNecessity(TileNecessity::Optional);
+                    tilesIt->second->setPriority(TaskPriority::Low);
                     cache.add(tilesIt->first, std::move(tilesIt->second));
                 }
                 tiles.erase(tilesIt++);
@@ -374,6 +390,14 @@ void TilePyramid::setCacheSize(size_t size) {
     cache.setSize(size);
 }
 
+void TilePyramid::setCacheMemoryBudget(size_t bytes) {
+    cache.setMemoryBudget(bytes);
+}
+
+size_t TilePyramid::getCacheMemoryUsage() const {
+    return cache.getMemoryUsage();
+}
+
 void TilePyramid::reduceMemoryUse() {
     cache.clear();
 }
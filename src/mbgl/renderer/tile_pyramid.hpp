@@ -58,6 +58,8 @@ public:
     std::vector<Feature> querySourceFeatures(const SourceQueryOptions&) const;
 
     void setCacheSize(size_t);
+    void setCacheMemoryBudget(size_t);
+    size_t getCacheMemoryUsage() const;
     void reduceMemoryUse();
 
     void setObserver(TileObserver*);
@@ -16,6 +16,7 @@ public:
     bool supportsCacheOnlyRequests() const override;
     std::unique_ptr<AsyncRequest> request(const Resource&, Callback) override;
     bool canRequest(const Resource&) const override;
+    void setPriority(AsyncRequest&, Resource::Priority) override;
     void pause() override;
     void resume() override;
 
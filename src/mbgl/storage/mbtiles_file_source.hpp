@@ -7,6 +7,9 @@
 #define MBGL_MAPTILER_FILE_SOURCE_H
 
 namespace mbgl {
+
+class ThreadPool;
+
 // File source for supporting .mbtiles maps.
 // can only load resource URLS that are absolute paths to local files
 class MaptilerFileSource : public FileSource {
@@ -24,7 +27,10 @@ public:
 
 private:
     class Impl;
+    class TileReaderPool;
     std::unique_ptr <util::Thread<Impl>> thread; //impl
+    std::shared_ptr<TileReaderPool> tileReaders;
+    std::unique_ptr<ThreadPool> tileScheduler;
 };
 
 } // namespace mbgl
@@ -62,22 +62,24 @@ Resource Resource::image(const std::string& url) {
 
 Resource Resource::spriteImage(const std::string& base, float pixelRatio) {
     util::URL url(base);
-    return Resource{ Resource::Kind::SpriteImage,
-                     base.substr(0, url.path.first + url.path.second) +
-                         (pixelRatio > 1 ? "@2x" : "") + ".png" +
-                         base.substr(url.query.first, url.query.second)};
+    Resource resource{Resource::Kind::SpriteImage,
+                      base.substr(0, url.path.first + url.path.second) + (pixelRatio > 1 ? "@2x" : "") + ".png" +
+                          base.substr(url.query.first, url.query.second)};
+    resource.setPriority(Priority::High);
+    return resource;
 }
 
 Resource Resource::spriteJSON(const std::string& base, float pixelRatio) {
     util::URL url(base);
-    return Resource{ Resource::Kind::SpriteJSON,
-                     base.substr(0, url.path.first + url.path.second) +
-                         (pixelRatio > 1 ? "@2x" : "") + ".json" +
-                         base.substr(url.query.first, url.query.second)};
+    Resource resource{Resource::Kind::SpriteJSON,
+                      base.substr(0, url.path.first + url.path.second) + (pixelRatio > 1 ? "@2x" : "") + ".json" +
+                          base.substr(url.query.first, url.query.second)};
+    resource.setPriority(Priority::High);
+    return resource;
 }
 
 Resource Resource::glyphs(const std::string& urlTemplate, const FontStack& fontStack, const std::pair<uint16_t, uint16_t>& glyphRange) {
-    return Resource {
+    Resource resource {
         Resource::Kind::Glyphs,
         util::replaceTokens(urlTemplate, [&](const std::string& token) -> optional<std::string> {
             if (token == "fontstack") {
@@ -89,6 +91,8 @@ Resource Resource::glyphs(const std::string& urlTemplate, const FontStack& fontS
             }
         })
     };
+    resource.setPriority(Priority::High);
+    return resource;
 }
 
 Resource Resource::tile(const std::string& urlTemplate,
@@ -1,4 +1,7 @@
 #include <mbgl/style/layer_impl.hpp>
+#include <mbgl/style/conversion/stringify.hpp>
+
+#include <functional>
 
 namespace mbgl {
 namespace style {
@@ -10,5 +13,37 @@ Layer::Impl::Impl(std::string layerID, std::string sourceID)
 
 void Layer::Impl::populateFontStack(std::set<FontStack>&) const {}
 
+const std::string& Layer::Impl::getLayoutKey() const {
+    return layoutKeyCache().key;
+}
+
+std::size_t Layer::Impl::getLayoutKeyHash() const {
+    return layoutKeyCache().hash;
+}
+
+const Layer::Impl::LayoutKeyCache& Layer::Impl::layoutKeyCache() const {
+    std::call_once(layoutKeyData.once, [this] {
+        using namespace conversion;
+
+        rapidjson::StringBuffer s;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+        writer.StartArray();
+        writer.Uint64(reinterpret_cast<uint64_t>(getTypeInfo()));
+        writer.String(source);
+        writer.String(sourceLayer);
+        writer.Double(minZoom);
+        writer.Double(maxZoom);
+        writer.Uint(static_cast<uint32_t>(visibility));
+        stringify(writer, filter);
+        stringifyLayout(writer);
+        writer.EndArray();
+
+        layoutKeyData.key = s.GetString();
+        layoutKeyData.hash = std::hash<std::string>()(layoutKeyData.key);
+    });
+    return layoutKeyData;
+}
+
 } // namespace style
 } // namespace mbgl
@@ -7,8 +7,9 @@
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 
-#include <string>
 #include <limits>
+#include <mutex>
+#include <string>
 
 namespace mbgl {
 
@@ -39,6 +40,12 @@ public:
     // Utility function for automatic layer grouping.
     virtual void stringifyLayout(rapidjson::Writer<rapidjson::StringBuffer>&) const = 0;
 
+    // Returns a key describing all of the properties affecting the layout of this layer;
+    // layers with equal keys can share buckets. The key and its hash are computed on
+    // first use and cached, as the impl is not modified once it is shared.
+    const std::string& getLayoutKey() const;
+    std::size_t getLayoutKeyHash() const;
+
     // Returns pointer to the statically allocated layer type info structure.
     virtual const LayerTypeInfo* getTypeInfo() const noexcept = 0;
 
@@ -55,6 +62,21 @@ public:
 
 protected:
     Impl(const Impl&) = default;
+
+private:
+    // Copies start out empty, as they are made in order to be modified.
+    struct LayoutKeyCache {
+        LayoutKeyCache() = default;
+        LayoutKeyCache(const LayoutKeyCache&) {}
+
+        std::once_flag once;
+        std::string key;
+        std::size_t hash = 0;
+    };
+
+    const LayoutKeyCache& layoutKeyCache() const;
+
+    mutable LayoutKeyCache layoutKeyData;
 };
 
 // To be used in the inherited classes.
@@ -14,6 +14,11 @@
 
 #include <cmath>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MBGL_COLLISION_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace mbgl {
 
 namespace {
@@ -32,6 +37,44 @@ inline float findViewportPadding(const TransformState& transformState, MapMode m
     return (transformState.getPitch() != 0.0f) ? viewportPaddingDefault * 2 : viewportPaddingDefault;
 }
 
+// Projects points with z = 0 to the viewport. Only the columns of the position matrix that apply
+// to such points are kept, in single precision so that four points fit into a vector register.
+struct AnchorProjection {
+    AnchorProjection(const mat4& m, const TransformState& transformState, float viewportPadding)
+        : m0(m[0]), m1(m[1]), m3(m[3]), m4(m[4]), m5(m[5]), m7(m[7]), m12(m[12]), m13(m[13]), m15(m[15]),
+          halfWidth(transformState.getSize().width / 2.0f),
+          negativeHalfHeight(-(transformState.getSize().height / 2.0f)),
+          offsetX(halfWidth + viewportPadding),
+          offsetY(transformState.getSize().height / 2.0f + viewportPadding),
+          halfCameraToCenterDistance(transformState.getCameraToCenterDistance() / 2.0f) {}
+
+    // See perspective ratio comment in symbol_sdf.vertex
+    // We're doing collision detection in viewport space so we need
+    // to scale down boxes in the distance
+    ProjectedAnchor project(const Point<float>& point) const {
+        const float w = m3 * point.x + m7 * point.y + m15;
+        return {{(m0 * point.x + m4 * point.y + m12) / w * halfWidth + offsetX,
+                 (m1 * point.x + m5 * point.y + m13) / w * negativeHalfHeight + offsetY},
+                w,
+                0.5f + halfCameraToCenterDistance / w};
+    }
+
+    const float m0, m1, m3, m4, m5, m7, m12, m13, m15;
+    const float halfWidth;
+    const float negativeHalfHeight;
+    const float offsetX;
+    const float offsetY;
+    const float halfCameraToCenterDistance;
+};
+
+// Only calls the predicate when there is one; without collision groups, every intersecting feature collides.
+template <typename Geometry, typename Predicate>
+inline bool hitTest(const CollisionIndex::CollisionGrid& grid,
+                    const Geometry& geometry,
+                    const optional<Predicate>& predicate) {
+    return predicate ? grid.hitTest(geometry, *predicate) : grid.hitTest(geometry);
+}
+
 } // namespace
 
 CollisionIndex::CollisionIndex(const TransformState& transformState_, MapMode mapMode)
@@ -49,6 +92,72 @@ CollisionIndex::CollisionIndex(const TransformState& transformState_, MapMode ma
       gridBottomBoundary(transformState.getSize().height + 2 * viewportPadding),
       pitchFactor(std::cos(transformState.getPitch()) * transformState.getCameraToCenterDistance()) {}
 
+void CollisionIndex::reserve(const CollisionIndex& other) {
+    collisionGrid.reserve(other.collisionGrid);
+    ignoredGrid.reserve(other.ignoredGrid);
+}
+
+void CollisionIndex::projectAnchors(const mat4& posMatrix,
+                                    const std::vector<Point<float>>& anchors,
+                                    ProjectedAnchors& projected) const {
+    const AnchorProjection projection(posMatrix, transformState, viewportPadding);
+    const std::size_t count = anchors.size();
+    projected.x.resize(count);
+    projected.y.resize(count);
+    projected.cameraDistance.resize(count);
+    projected.perspectiveRatio.resize(count);
+
+    std::size_t i = 0;
+#if defined(MBGL_COLLISION_INDEX_SSE2)
+    static_assert(sizeof(Point<float>) == 2 * sizeof(float), "Points must be packed pairs of floats");
+    const auto* points = reinterpret_cast<const float*>(anchors.data());
+    const __m128 m0 = _mm_set1_ps(projection.m0);
+    const __m128 m1 = _mm_set1_ps(projection.m1);
+    const __m128 m3 = _mm_set1_ps(projection.m3);
+    const __m128 m4 = _mm_set1_ps(projection.m4);
+    const __m128 m5 = _mm_set1_ps(projection.m5);
+    const __m128 m7 = _mm_set1_ps(projection.m7);
+    const __m128 m12 = _mm_set1_ps(projection.m12);
+    const __m128 m13 = _mm_set1_ps(projection.m13);
+    const __m128 m15 = _mm_set1_ps(projection.m15);
+    const __m128 halfWidth = _mm_set1_ps(projection.halfWidth);
+    const __m128 negativeHalfHeight = _mm_set1_ps(projection.negativeHalfHeight);
+    const __m128 offsetX = _mm_set1_ps(projection.offsetX);
+    const __m128 offsetY = _mm_set1_ps(projection.offsetY);
+    const __m128 halfCameraToCenterDistance = _mm_set1_ps(projection.halfCameraToCenterDistance);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= count; i += 4) {
+        // Deinterleave four points into their x and y coordinates.
+        const __m128 xy01 = _mm_loadu_ps(points + 2 * i);
+        const __m128 xy23 = _mm_loadu_ps(points + 2 * i + 4);
+        const __m128 x = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 y = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1));
+
+        const __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m7, y)), m15);
+        const __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), m12);
+        const __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), m13);
+
+        _mm_storeu_ps(projected.x.data() + i, _mm_add_ps(_mm_mul_ps(_mm_div_ps(px, w), halfWidth), offsetX));
+        _mm_storeu_ps(projected.y.data() + i,
+                      _mm_add_ps(_mm_mul_ps(_mm_div_ps(py, w), negativeHalfHeight), offsetY));
+        _mm_storeu_ps(projected.cameraDistance.data() + i, w);
+        _mm_storeu_ps(projected.perspectiveRatio.data() + i,
+                      _mm_add_ps(half, _mm_div_ps(halfCameraToCenterDistance, w)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const ProjectedAnchor anchor = projection.project(anchors[i]);
+        projected.x[i] = anchor.point.x;
+        projected.y[i] = anchor.point.y;
+        projected.cameraDistance[i] = anchor.cameraDistance;
+        projected.perspectiveRatio[i] = anchor.perspectiveRatio;
+    }
+}
+
+ProjectedAnchor CollisionIndex::projectAnchor(const mat4& posMatrix, const Point<float>& anchor) const {
+    return AnchorProjection(posMatrix, transformState, viewportPadding).project(anchor);
+}
+
 float CollisionIndex::approximateTileDistance(const TileDistance& tileDistance,
                                               const float lastSegmentAngle,
                                               const float pixelsToTileUnits,
@@ -145,6 +254,7 @@ IntersectStatus CollisionIndex::intersectsTileEdges(const CollisionBox& box,
 std::pair<bool, bool> CollisionIndex::placeFeature(
     const CollisionFeature& feature,
     Point<float> shift,
+    const ProjectedAnchor& anchor,
     const mat4& posMatrix,
     const mat4& labelPlaneMatrix,
     const float textPixelRatio,
@@ -160,22 +270,23 @@ std::pair<bool, bool> CollisionIndex::placeFeature(
     assert(projectedBoxes.empty());
     if (!feature.alongLine) {
         const CollisionBox& box = feature.boxes.front();
-        auto collisionBoundaries = getProjectedCollisionBoundaries(posMatrix, shift, textPixelRatio, box);
+        auto collisionBoundaries = getProjectedCollisionBoundaries(anchor, shift, textPixelRatio, box);
         projectedBoxes.emplace_back(
             collisionBoundaries[0], collisionBoundaries[1], collisionBoundaries[2], collisionBoundaries[3]);
         if ((avoidEdges && !isInsideTile(collisionBoundaries, *avoidEdges)) || !isInsideGrid(collisionBoundaries) ||
-            (!allowOverlap && collisionGrid.hitTest(projectedBoxes.back().box(), collisionGroupPredicate))) {
+            (!allowOverlap && hitTest(collisionGrid, projectedBoxes.back().box(), collisionGroupPredicate))) {
             return { false, false };
         }
 
         return {true, isOffscreen(collisionBoundaries)};
     } else {
-        return placeLineFeature(feature, posMatrix, labelPlaneMatrix, textPixelRatio, symbol, scale, fontSize, allowOverlap, pitchWithMap, collisionDebug, avoidEdges, collisionGroupPredicate, projectedBoxes);
+        return placeLineFeature(feature, anchor, posMatrix, labelPlaneMatrix, textPixelRatio, symbol, scale, fontSize, allowOverlap, pitchWithMap, collisionDebug, avoidEdges, collisionGroupPredicate, projectedBoxes);
     }
 }
 
 std::pair<bool, bool> CollisionIndex::placeLineFeature(
     const CollisionFeature& feature,
+    const ProjectedAnchor& anchor,
     const mat4& posMatrix,
     const mat4& labelPlaneMatrix,
     const float textPixelRatio,
@@ -191,7 +302,6 @@ std::pair<bool, bool> CollisionIndex::placeLineFeature(
     assert(feature.alongLine);
     assert(projectedBoxes.empty());
     const auto tileUnitAnchorPoint = symbol.anchorPoint;
-    const auto projectedAnchor = projectAnchor(posMatrix, tileUnitAnchorPoint);
 
     const float fontScale = fontSize / 24;
     const float lineOffsetX = symbol.lineOffset[0] * fontSize;
@@ -214,7 +324,7 @@ std::pair<bool, bool> CollisionIndex::placeLineFeature(
     bool inGrid = false;
     bool entirelyOffscreen = true;
 
-    const auto tileToViewport = projectedAnchor.first * textPixelRatio;
+    const auto tileToViewport = anchor.perspectiveRatio * textPixelRatio;
     // pixelsToTileUnits is used for translating line geometry to tile units
     // ... so we care about 'scale' but not 'perspectiveRatio'
     // equivalent to pixel_to_tile_units
@@ -223,8 +333,8 @@ std::pair<bool, bool> CollisionIndex::placeLineFeature(
     float firstTileDistance = 0.f;
     float lastTileDistance = 0.f;
     if (firstAndLastGlyph) {
-        firstTileDistance = approximateTileDistance(*(firstAndLastGlyph->first.tileDistance), firstAndLastGlyph->first.angle, pixelsToTileUnits, projectedAnchor.second, pitchWithMap);
-        lastTileDistance = approximateTileDistance(*(firstAndLastGlyph->second.tileDistance), firstAndLastGlyph->second.angle, pixelsToTileUnits, projectedAnchor.second, pitchWithMap);
+        firstTileDistance = approximateTileDistance(*(firstAndLastGlyph->first.tileDistance), firstAndLastGlyph->first.angle, pixelsToTileUnits, anchor.cameraDistance, pitchWithMap);
+        lastTileDistance = approximateTileDistance(*(firstAndLastGlyph->second.tileDistance), firstAndLastGlyph->second.angle, pixelsToTileUnits, anchor.cameraDistance, pitchWithMap);
     }
 
     bool previousCirclePlaced = false;
@@ -289,7 +399,7 @@ std::pair<bool, bool> CollisionIndex::placeLineFeature(
         inGrid |= isInsideGrid(collisionBoundaries);
 
         if ((avoidEdges && !isInsideTile(collisionBoundaries, *avoidEdges)) ||
-            (!allowOverlap && collisionGrid.hitTest(projectedBoxes[i].circle(), collisionGroupPredicate))) {
+            (!allowOverlap && hitTest(collisionGrid, projectedBoxes[i].circle(), collisionGroupPredicate))) {
             if (!collisionDebug) {
                 return {false, false};
             } else {
@@ -400,15 +510,6 @@ std::unordered_map<uint32_t, std::vector<IndexedSubfeature>> CollisionIndex::que
 
 }
 
-std::pair<float,float> CollisionIndex::projectAnchor(const mat4& posMatrix, const Point<float>& point) const {
-    vec4 p = {{ point.x, point.y, 0, 1 }};
-    matrix::transformMat4(p, p, posMatrix);
-    return std::make_pair(
-        0.5 + 0.5 * (transformState.getCameraToCenterDistance() / p[3]),
-        p[3]
-    );
-}
-
 std::pair<Point<float>,float> CollisionIndex::projectAndGetPerspectiveRatio(const mat4& posMatrix, const Point<float>& point) const {
     vec4 p = {{ point.x, point.y, 0, 1 }};
     matrix::transformMat4(p, p, posMatrix);
@@ -448,4 +549,17 @@ CollisionBoundaries CollisionIndex::getProjectedCollisionBoundaries(const mat4&
     }};
 }
 
+CollisionBoundaries CollisionIndex::getProjectedCollisionBoundaries(const ProjectedAnchor& anchor,
+                                                                    Point<float> shift,
+                                                                    float textPixelRatio,
+                                                                    const CollisionBox& box) const {
+    const float tileToViewport = textPixelRatio * anchor.perspectiveRatio;
+    return CollisionBoundaries{{
+        (box.x1 + shift.x) * tileToViewport + anchor.point.x,
+        (box.y1 + shift.y) * tileToViewport + anchor.point.y,
+        (box.x2 + shift.x) * tileToViewport + anchor.point.x,
+        (box.y2 + shift.y) * tileToViewport + anchor.point.y,
+    }};
+}
+
 } // namespace mbgl
@@ -21,19 +21,56 @@ struct IntersectStatus {
     // Assuming tile border divides box in two sections
     int minSectionLength = 0;
 };
+// The viewport position of a tile point, along with its distance from the camera and the
+// perspective ratio by which labels at that point get scaled.
+struct ProjectedAnchor {
+    Point<float> point;
+    float cameraDistance;
+    float perspectiveRatio;
+};
+
+// A batch of projected tile points, kept in separate arrays so that they can be projected
+// with vector instructions.
+class ProjectedAnchors {
+public:
+    std::size_t size() const { return x.size(); }
+    ProjectedAnchor operator[](std::size_t i) const {
+        return {{x[i], y[i]}, cameraDistance[i], perspectiveRatio[i]};
+    }
+
+private:
+    friend class CollisionIndex;
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> cameraDistance;
+    std::vector<float> perspectiveRatio;
+};
+
 class CollisionIndex {
 public:
     using CollisionGrid = GridIndex<IndexedSubfeature>;
 
     explicit CollisionIndex(const TransformState&, MapMode);
+
+    // Reserves room for as many features as `other` has placed, which is usually
+    // close to what the next placement will place.
+    void reserve(const CollisionIndex& other);
+
     IntersectStatus intersectsTileEdges(const CollisionBox&,
                                         Point<float> shift,
                                         const mat4& posMatrix,
                                         float textPixelRatio,
                                         const CollisionBoundaries& tileEdges) const;
+    // Projects the anchors of a whole bucket at once, ahead of placing its symbols.
+    void projectAnchors(const mat4& posMatrix, const std::vector<Point<float>>& anchors, ProjectedAnchors&) const;
+    ProjectedAnchor projectAnchor(const mat4& posMatrix, const Point<float>& anchor) const;
+
+    // `anchor` is the projection of the feature's anchor with `posMatrix`.
     std::pair<bool, bool> placeFeature(
         const CollisionFeature& feature,
         Point<float> shift,
+        const ProjectedAnchor& anchor,
         const mat4& posMatrix,
         const mat4& labelPlaneMatrix,
         float textPixelRatio,
@@ -65,6 +102,7 @@ private:
 
     std::pair<bool, bool> placeLineFeature(
         const CollisionFeature& feature,
+        const ProjectedAnchor& anchor,
         const mat4& posMatrix,
         const mat4& labelPlaneMatrix,
         float textPixelRatio,
@@ -84,13 +122,16 @@ private:
                                   float cameraToAnchorDistance,
                                   bool pitchWithMap);
 
-    std::pair<float,float> projectAnchor(const mat4& posMatrix, const Point<float>& point) const;
     std::pair<Point<float>,float> projectAndGetPerspectiveRatio(const mat4& posMatrix, const Point<float>& point) const;
     Point<float> projectPoint(const mat4& posMatrix, const Point<float>& point) const;
     CollisionBoundaries getProjectedCollisionBoundaries(const mat4& posMatrix,
                                                         Point<float> shift,
                                                         float textPixelRatio,
                                                         const CollisionBox& box) const;
+    CollisionBoundaries getProjectedCollisionBoundaries(const ProjectedAnchor& anchor,
+                                                        Point<float> shift,
+                                                        float textPixelRatio,
+                                                        const CollisionBox& box) const;
 
     const TransformState transformState;
 
@@ -3,21 +3,56 @@
 #include <mbgl/renderer/buckets/symbol_bucket.hpp>
 #include <mbgl/renderer/render_tile.hpp>
 #include <mbgl/tile/tile.hpp>
+#include <mbgl/util/hash.hpp>
+
+#include <algorithm>
 
 namespace mbgl {
 
+namespace {
+
+// Cells of the grid that symbols are bucketed by, in units of scaled coordinates (1/256 of a tile).
+constexpr int64_t cellSize = 32;
+
+int64_t toCell(int64_t coord) {
+    // Rounds towards negative infinity, as symbols in the tile buffer have negative coordinates.
+    return (coord >= 0 ? coord : coord - (cellSize - 1)) / cellSize;
+}
+
+} // namespace
+
 TileLayerIndex::TileLayerIndex(OverscaledTileID coord_,
                                std::vector<SymbolInstance>& symbolInstances,
                                uint32_t bucketInstanceId_,
                                std::string bucketLeaderId_)
     : coord(coord_), bucketInstanceId(bucketInstanceId_), bucketLeaderId(std::move(bucketLeaderId_)) {
+    indexedSymbolInstances.reserve(symbolInstances.size());
+    buckets.reserve(symbolInstances.size());
     for (SymbolInstance& symbolInstance : symbolInstances) {
         if (symbolInstance.crossTileID == SymbolInstance::invalidCrossTileID()) continue;
-        indexedSymbolInstances[symbolInstance.key].emplace_back(symbolInstance.crossTileID,
-                                                                getScaledCoordinates(symbolInstance, coord));
+        const auto keyHash = std::hash<std::u16string>()(symbolInstance.key);
+        const auto scaledCoord = getScaledCoordinates(symbolInstance, coord);
+        indexedSymbolInstances.emplace_back(symbolInstance.crossTileID,
+                                            scaledCoord,
+                                            keyHash,
+                                            static_cast<uint32_t>(keys.size()),
+                                            static_cast<uint32_t>(symbolInstance.key.size()));
+        keys += symbolInstance.key;
+
+        // Symbols are prepended to their bucket; findMatch() looks for the lowest index anyway.
+        const auto index = static_cast<uint32_t>(indexedSymbolInstances.size() - 1);
+        auto bucket = buckets.emplace(bucketHash(keyHash, toCell(scaledCoord.x), toCell(scaledCoord.y)), index);
+        if (!bucket.second) {
+            indexedSymbolInstances.back().next = bucket.first->second;
+            bucket.first->second = index;
+        }
     }
 }
 
+std::size_t TileLayerIndex::bucketHash(std::size_t keyHash, int64_t cellX, int64_t cellY) {
+    return util::hash(keyHash, cellX, cellY);
+}
+
 Point<int64_t> TileLayerIndex::getScaledCoordinates(SymbolInstance& symbolInstance,
                                                     const OverscaledTileID& childTileCoord) const {
     // Round anchor positions to roughly 4 pixel grid
@@ -29,11 +64,66 @@ Point<int64_t> TileLayerIndex::getScaledCoordinates(SymbolInstance& symbolInstan
     };
 }
 
+bool TileLayerIndex::isMatch(const IndexedSymbolInstance& thisTileSymbol,
+                             const std::u16string& key,
+                             std::size_t keyHash,
+                             Point<int64_t> scaledCoord,
+                             int64_t tolerance,
+                             const std::unordered_set<uint32_t>& usedCrossTileIDs) const {
+    // Any symbol with the same keys whose coordinates are within 1
+    // grid unit matches. (with a 4px grid, this covers a 12px by 12px area)
+    return std::abs(thisTileSymbol.coord.x - scaledCoord.x) <= tolerance &&
+           std::abs(thisTileSymbol.coord.y - scaledCoord.y) <= tolerance && thisTileSymbol.keyHash == keyHash &&
+           keys.compare(thisTileSymbol.keyOffset, thisTileSymbol.keyLength, key) == 0 &&
+           usedCrossTileIDs.find(thisTileSymbol.crossTileID) == usedCrossTileIDs.end();
+}
+
+optional<uint32_t> TileLayerIndex::findMatch(const std::u16string& key,
+                                             std::size_t keyHash,
+                                             Point<int64_t> scaledCoord,
+                                             int64_t tolerance,
+                                             const std::unordered_set<uint32_t>& usedCrossTileIDs) const {
+    const int64_t cellX1 = toCell(scaledCoord.x - tolerance);
+    const int64_t cellY1 = toCell(scaledCoord.y - tolerance);
+    const int64_t cellX2 = toCell(scaledCoord.x + tolerance);
+    const int64_t cellY2 = toCell(scaledCoord.y + tolerance);
+
+    // Symbols of much lower zoom levels can be far enough off to span more cells than it
+    // takes to look at every symbol.
+    const auto cellCount = static_cast<std::size_t>((cellX2 - cellX1 + 1) * (cellY2 - cellY1 + 1));
+    if (cellCount > indexedSymbolInstances.size()) {
+        for (uint32_t i = 0; i < indexedSymbolInstances.size(); ++i) {
+            if (isMatch(indexedSymbolInstances[i], key, keyHash, scaledCoord, tolerance, usedCrossTileIDs)) {
+                return i;
+            }
+        }
+        return nullopt;
+    }
+
+    // Symbols are matched in the order of the bucket, as if all the symbols with this key were scanned.
+    optional<uint32_t> match;
+    for (int64_t cellX = cellX1; cellX <= cellX2; ++cellX) {
+        for (int64_t cellY = cellY1; cellY <= cellY2; ++cellY) {
+            auto bucket = buckets.find(bucketHash(keyHash, cellX, cellY));
+            if (bucket == buckets.end()) continue;
+            for (uint32_t i = bucket->second; i != std::numeric_limits<uint32_t>::max();
+                 i = indexedSymbolInstances[i].next) {
+                if ((!match || i < *match) &&
+                    isMatch(indexedSymbolInstances[i], key, keyHash, scaledCoord, tolerance, usedCrossTileIDs)) {
+                    match = i;
+                }
+            }
+        }
+    }
+    return match;
+}
+
 void TileLayerIndex::findMatches(SymbolBucket& bucket,
                                  const OverscaledTileID& newCoord,
-                                 std::set<uint32_t>& zoomCrossTileIDs) const {
+                                 std::unordered_set<uint32_t>& zoomCrossTileIDs) const {
     auto& symbolInstances = bucket.symbolInstances;
-    float tolerance = coord.canonical.z < newCoord.canonical.z ? 1 : std::pow(2, coord.canonical.z - newCoord.canonical.z);
+    const auto tolerance = static_cast<int64_t>(
+        coord.canonical.z < newCoord.canonical.z ? 1 : std::pow(2, coord.canonical.z - newCoord.canonical.z));
 
     if (bucket.bucketLeaderID != bucketLeaderId) return;
 
@@ -43,27 +133,16 @@ void TileLayerIndex::findMatches(SymbolBucket& bucket,
             continue;
         }
 
-        auto it = indexedSymbolInstances.find(symbolInstance.key);
-        if (it == indexedSymbolInstances.end()) {
-            // No symbol with this key in this bucket
-            continue;
-        }
-
-        auto scaledSymbolCoord = getScaledCoordinates(symbolInstance, newCoord);
-
-        for (const IndexedSymbolInstance& thisTileSymbol : it->second) {
-            // Return any symbol with the same keys whose coordinates are within 1
-            // grid unit. (with a 4px grid, this covers a 12px by 12px area)
-            if (std::abs(thisTileSymbol.coord.x - scaledSymbolCoord.x) <= tolerance &&
-                std::abs(thisTileSymbol.coord.y - scaledSymbolCoord.y) <= tolerance &&
-                zoomCrossTileIDs.find(thisTileSymbol.crossTileID) == zoomCrossTileIDs.end()) {
-                // Once we've marked ourselves duplicate against this parent symbol,
-                // don't let any other symbols at the same zoom level duplicate against
-                // the same parent (see issue #10844)
-                zoomCrossTileIDs.insert(thisTileSymbol.crossTileID);
-                symbolInstance.crossTileID = thisTileSymbol.crossTileID;
-                break;
-            }
+        const auto keyHash = std::hash<std::u16string>()(symbolInstance.key);
+        const auto match = findMatch(
+            symbolInstance.key, keyHash, getScaledCoordinates(symbolInstance, newCoord), tolerance, zoomCrossTileIDs);
+        if (match) {
+            const uint32_t crossTileID = indexedSymbolInstances[*match].crossTileID;
+            // Once we've marked ourselves duplicate against this parent symbol,
+            // don't let any other symbols at the same zoom level duplicate against
+            // the same parent (see issue #10844)
+            zoomCrossTileIDs.insert(crossTileID);
+            symbolInstance.crossTileID = crossTileID;
         }
     }
 }
@@ -73,28 +152,19 @@ CrossTileSymbolLayerIndex::CrossTileSymbolLayerIndex(uint32_t& maxCrossTileID_)
 /*
  * Sometimes when a user pans across the antimeridian the longitude value gets wrapped.
  * To prevent labels from flashing out and in we adjust the tileID values in the indexes
- * so that they match the new wrapped version of the map.
+ * so that they match the new wrapped version of the map. Rather than rekeying every index,
+ * this shifts the wrap that incoming tile IDs get converted by.
  */
 void CrossTileSymbolLayerIndex::handleWrapJump(float newLng) {
     const int wrapDelta = std::round((newLng - lng) / 360);
-    if (wrapDelta != 0) {
-        std::map<uint8_t, std::map<OverscaledTileID,TileLayerIndex>> newIndexes;
-        for (auto& zoomIndex : indexes) {
-            std::map<OverscaledTileID,TileLayerIndex> newZoomIndex;
-            for (auto& index : zoomIndex.second) {
-                // change the tileID's wrap and move its index
-                index.second.coord = index.second.coord.unwrapTo(index.second.coord.wrap + wrapDelta);
-                newZoomIndex.emplace(index.second.coord, std::move(index.second));
-            }
-            newIndexes.emplace(zoomIndex.first, std::move(newZoomIndex));
-        }
-
-        indexes = std::move(newIndexes);
-    }
-
+    wrapOffset = static_cast<int16_t>(wrapOffset + wrapDelta);
     lng = newLng;
 }
 
+OverscaledTileID CrossTileSymbolLayerIndex::toIndexID(const OverscaledTileID& tileID) const {
+    return tileID.unwrapTo(static_cast<int16_t>(tileID.wrap - wrapOffset));
+}
+
 namespace {
 
 bool isInVewport(const mat4& posMatrix, const Point<float>& point) {
@@ -114,8 +184,9 @@ bool isInVewport(const mat4& posMatrix, const Point<float>& point) {
 bool CrossTileSymbolLayerIndex::addBucket(const OverscaledTileID& tileID,
                                           const mat4& tileMatrix,
                                           SymbolBucket& bucket) {
+    const OverscaledTileID indexID = toIndexID(tileID);
     auto& thisZoomIndexes = indexes[tileID.overscaledZ];
-    auto previousIndex = thisZoomIndexes.find(tileID);
+    auto previousIndex = thisZoomIndexes.find(indexID);
     if (previousIndex != thisZoomIndexes.end()) {
         if (previousIndex->second.bucketInstanceId == bucket.bucketInstanceId && !bucket.hasUninitializedSymbols) {
             return false;
@@ -149,18 +220,26 @@ bool CrossTileSymbolLayerIndex::addBucket(const OverscaledTileID& tileID,
 
     auto& thisZoomUsedCrossTileIDs = usedCrossTileIDs[tileID.overscaledZ];
 
+    std::vector<const TileLayerIndex*> childIndexes;
     for (auto& it : indexes) {
         auto zoom = it.first;
         const auto& zoomIndexes = it.second;
         if (zoom > tileID.overscaledZ) {
+            childIndexes.clear();
             for (auto& childIndex : zoomIndexes) {
-                if (childIndex.second.coord.isChildOf(tileID)) {
-                    childIndex.second.findMatches(bucket, tileID, thisZoomUsedCrossTileIDs);
+                if (childIndex.first.isChildOf(indexID)) {
+                    childIndexes.push_back(&childIndex.second);
                 }
             }
+            // Match in tile order, so that the IDs that symbols get don't depend on how the tiles are hashed.
+            std::sort(childIndexes.begin(), childIndexes.end(), [](const TileLayerIndex* a, const TileLayerIndex* b) {
+                return a->coord < b->coord;
+            });
+            for (const TileLayerIndex* childIndex : childIndexes) {
+                childIndex->findMatches(bucket, tileID, thisZoomUsedCrossTileIDs);
+            }
         } else {
-            auto parentTileID = tileID.scaledTo(zoom);
-            auto parentIndex = zoomIndexes.find(parentTileID);
+            auto parentIndex = zoomIndexes.find(indexID.scaledTo(zoom));
             if (parentIndex != zoomIndexes.end()) {
                 parentIndex->second.findMatches(bucket, tileID, thisZoomUsedCrossTileIDs);
             }
@@ -175,19 +254,18 @@ bool CrossTileSymbolLayerIndex::addBucket(const OverscaledTileID& tileID,
         }
     }
 
-    thisZoomIndexes.erase(tileID);
+    thisZoomIndexes.erase(indexID);
     thisZoomIndexes.emplace(
         std::piecewise_construct,
-        std::forward_as_tuple(tileID),
-        std::forward_as_tuple(tileID, bucket.symbolInstances, bucket.bucketInstanceId, bucket.bucketLeaderID));
+        std::forward_as_tuple(indexID),
+        std::forward_as_tuple(indexID, bucket.symbolInstances, bucket.bucketInstanceId, bucket.bucketLeaderID));
     return true;
 }
 
 void CrossTileSymbolLayerIndex::removeBucketCrossTileIDs(uint8_t zoom, const TileLayerIndex& removedBucket) {
-    for (const auto& key : removedBucket.indexedSymbolInstances) {
-        for (auto indexedSymbolInstance : key.second) {
-            usedCrossTileIDs[zoom].erase(indexedSymbolInstance.crossTileID);
-        }
+    auto& zoomCrossTileIDs = usedCrossTileIDs[zoom];
+    for (const auto& indexedSymbolInstance : removedBucket.indexedSymbolInstances) {
+        zoomCrossTileIDs.erase(indexedSymbolInstance.crossTileID);
     }
 }
 
@@ -7,11 +7,13 @@
 #include <mbgl/util/mat4.hpp>
 #include <mbgl/util/optional.hpp>
 
+#include <limits>
 #include <map>
 #include <set>
 #include <vector>
 #include <string>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace mbgl {
@@ -22,14 +24,30 @@ class SymbolBucket;
 
 class IndexedSymbolInstance {
 public:
-    IndexedSymbolInstance(uint32_t crossTileID_, Point<int64_t> coord_)
-        : crossTileID(crossTileID_), coord(coord_)
+    IndexedSymbolInstance(uint32_t crossTileID_, Point<int64_t> coord_, std::size_t keyHash_, uint32_t keyOffset_, uint32_t keyLength_)
+        : crossTileID(crossTileID_), coord(coord_), keyHash(keyHash_), keyOffset(keyOffset_), keyLength(keyLength_)
     {}
 
     uint32_t crossTileID;
     Point<int64_t> coord;
+
+    // The symbol's key, as a range of TileLayerIndex::keys.
+    std::size_t keyHash;
+    uint32_t keyOffset;
+    uint32_t keyLength;
+
+    // Next symbol in the same bucket of TileLayerIndex::buckets.
+    uint32_t next = std::numeric_limits<uint32_t>::max();
 };
 
+/*
+ TileLayerIndex keeps the symbols of a tile, so that the symbols of
+ tiles of other zoom levels can be matched against them. Symbols are
+ bucketed by their key and by the cell of a coarse grid that their
+ coordinates fall into, so that a match only has to look at the symbols
+ in the cells around the symbol's position rather than at all the
+ symbols with the same key.
+*/
 class TileLayerIndex {
 public:
     TileLayerIndex(OverscaledTileID coord,
@@ -38,12 +56,34 @@ public:
                    std::string bucketLeaderId);
 
     Point<int64_t> getScaledCoordinates(SymbolInstance&, const OverscaledTileID&) const;
-    void findMatches(SymbolBucket&, const OverscaledTileID&, std::set<uint32_t>&) const;
+    void findMatches(SymbolBucket&, const OverscaledTileID&, std::unordered_set<uint32_t>&) const;
 
     OverscaledTileID coord;
     uint32_t bucketInstanceId;
     std::string bucketLeaderId;
-    std::map<std::u16string,std::vector<IndexedSymbolInstance>> indexedSymbolInstances;
+    // In the order of the bucket's symbol instances.
+    std::vector<IndexedSymbolInstance> indexedSymbolInstances;
+
+private:
+    // Returns the index of the first symbol with the given key within `tolerance` of `scaledCoord`
+    // whose cross tile ID isn't used yet, if any.
+    optional<uint32_t> findMatch(const std::u16string& key,
+                                 std::size_t keyHash,
+                                 Point<int64_t> scaledCoord,
+                                 int64_t tolerance,
+                                 const std::unordered_set<uint32_t>& usedCrossTileIDs) const;
+    bool isMatch(const IndexedSymbolInstance&,
+                 const std::u16string& key,
+                 std::size_t keyHash,
+                 Point<int64_t> scaledCoord,
+                 int64_t tolerance,
+                 const std::unordered_set<uint32_t>& usedCrossTileIDs) const;
+    static std::size_t bucketHash(std::size_t keyHash, int64_t cellX, int64_t cellY);
+
+    // The keys of all the symbols, concatenated.
+    std::u16string keys;
+    // The first symbol of every bucket, by the hash of the bucket's key and cell.
+    std::unordered_map<std::size_t, uint32_t> buckets;
 };
 
 class CrossTileSymbolLayerIndex {
@@ -55,9 +95,15 @@ public:
 private:
     void removeBucketCrossTileIDs(uint8_t zoom, const TileLayerIndex& removedBucket);
 
-    std::map<uint8_t, std::map<OverscaledTileID,TileLayerIndex>> indexes;
-    std::map<uint8_t, std::set<uint32_t>> usedCrossTileIDs;
+    // Converts a tile ID to the wrap that the indexes are keyed with.
+    OverscaledTileID toIndexID(const OverscaledTileID&) const;
+
+    // Tile indexes of every zoom level, keyed by their tile ID shifted by `-wrapOffset`, so that
+    // wrap jumps don't need to rekey them.
+    std::map<uint8_t, std::unordered_map<OverscaledTileID, TileLayerIndex>> indexes;
+    std::map<uint8_t, std::unordered_set<uint32_t>> usedCrossTileIDs;
     float lng = 0;
+    int16_t wrapOffset = 0;
     uint32_t& maxCrossTileID;
 };
 
@@ -8,6 +8,7 @@
 #include <mbgl/text/placement.hpp>
 #include <mbgl/tile/geometry_tile.hpp>
 #include <mbgl/util/math.hpp>
+#include <algorithm>
 #include <utility>
 
 namespace mbgl {
@@ -72,8 +73,7 @@ public:
                      const RenderTile& renderTile_,
                      const TransformState& state_,
                      float placementZoom,
-                     CollisionGroups::CollisionGroup collisionGroup_,
-                     optional<CollisionBoundaries> avoidEdges_ = nullopt)
+                     CollisionGroups::CollisionGroup collisionGroup_)
         : bucket(bucket_),
           renderTile(renderTile_),
           state(state_),
@@ -82,8 +82,16 @@ public:
           pixelRatio(util::tileSize * getOverscaledID().overscaleFactor() / util::EXTENT),
           collisionGroup(std::move(collisionGroup_)),
           partiallyEvaluatedTextSize(bucket_.textSizeBinder->evaluateForZoom(placementZoom)),
-          partiallyEvaluatedIconSize(bucket_.iconSizeBinder->evaluateForZoom(placementZoom)),
-          avoidEdges(std::move(avoidEdges_)) {}
+          partiallyEvaluatedIconSize(bucket_.iconSizeBinder->evaluateForZoom(placementZoom)) {}
+
+    static mat4 getPosMatrix(const RenderTile& renderTile, const TransformState& state) {
+        // Computed from the placement's transform state rather than taken from the render tile,
+        // so that all the buckets of an incremental placement are placed for the same camera.
+        mat4 matrix;
+        state.matrixFor(matrix, renderTile.id);
+        matrix::multiply(matrix, state.getProjectionMatrix(), matrix);
+        return matrix;
+    }
 
     const SymbolBucket& getBucket() const { return bucket.get(); }
     const style::SymbolLayoutProperties::PossiblyEvaluated& getLayout() const { return *getBucket().layout; }
@@ -97,6 +105,7 @@ public:
         return getLayout().get<style::TextVariableAnchor>();
     }
 
+    mat4 posMatrix = getPosMatrix(getRenderTile(), getTransformState());
     float pixelsToTileUnits;
     float scale;
     float pixelRatio;
@@ -108,12 +117,11 @@ public:
     SymbolPlacementType placementType = getLayout().get<SymbolPlacement>();
 
     mat4 textLabelPlaneMatrix =
-        getLabelPlaneMatrix(renderTile.get().matrix, pitchTextWithMap, rotateTextWithMap, state, pixelsToTileUnits);
+        getLabelPlaneMatrix(posMatrix, pitchTextWithMap, rotateTextWithMap, state, pixelsToTileUnits);
     mat4 iconLabelPlaneMatrix =
         (rotateTextWithMap == rotateIconWithMap && pitchTextWithMap == pitchIconWithMap)
             ? textLabelPlaneMatrix
-            : getLabelPlaneMatrix(
-                  renderTile.get().matrix, pitchIconWithMap, rotateIconWithMap, state, pixelsToTileUnits);
+            : getLabelPlaneMatrix(posMatrix, pitchIconWithMap, rotateIconWithMap, state, pixelsToTileUnits);
 
     CollisionGroups::CollisionGroup collisionGroup;
     ZoomEvaluatedSize partiallyEvaluatedTextSize;
@@ -185,6 +193,7 @@ Placement::Placement(std::shared_ptr<const UpdateParameters> updateParameters_,
       showCollisionBoxes(updateParameters->debugOptions & MapDebugOptions::Collision) {
     if (prevPlacement) {
         prevPlacement->get()->prevPlacement = nullopt; // Only hold on to one placement back
+        collisionIndex.reserve(prevPlacement->get()->collisionIndex);
     }
 }
 
@@ -200,6 +209,49 @@ void Placement::placeLayers(const RenderLayerReferences& layers) {
     commit();
 }
 
+bool Placement::placeLayersIncrementally(const RenderLayerReferences& layers, TimePoint now, Duration timeBudget) {
+    const TimePoint deadline = Clock::now() + timeBudget;
+    bool placedAny = false;
+
+    for (auto it = layers.crbegin(); it != layers.crend(); ++it) {
+        const RenderLayer& layer = *it;
+        if (placedLayerIDs.count(layer.getID()) != 0u) continue;
+
+        if (layer.getID() != currentLayerID) {
+            currentLayerID = layer.getID();
+            currentLayerPlacedBuckets.clear();
+            currentLayerSeenCrossTileIDs.clear();
+        }
+
+        // The placement data is rebuilt on every frame, and tiles may come and go in between, so
+        // skip the buckets that were already placed rather than resuming at a list position.
+        // Their symbols are in the seen set.
+        for (const BucketPlacementData& data : layer.getPlacementData()) {
+            const auto& bucket = static_cast<const SymbolBucket&>(data.bucket.get());
+            const std::pair<uint32_t, std::size_t> placedBucket{bucket.bucketInstanceId,
+                                                                data.sortKeyRange ? data.sortKeyRange->start : 0u};
+            if (currentLayerPlacedBuckets.count(placedBucket) != 0u) continue;
+
+            // Always place at least one bucket, so that the placement makes progress.
+            if (placedAny && Clock::now() >= deadline) {
+                return false;
+            }
+            data.bucket.get().place(*this, data, currentLayerSeenCrossTileIDs);
+            currentLayerPlacedBuckets.insert(placedBucket);
+            placedAny = true;
+        }
+
+        placedLayerIDs.insert(currentLayerID);
+        currentLayerID.clear();
+        currentLayerPlacedBuckets.clear();
+        currentLayerSeenCrossTileIDs.clear();
+    }
+
+    commitTime = now;
+    commit();
+    return true;
+}
+
 void Placement::placeLayer(const RenderLayer& layer, std::set<uint32_t>& seenCrossTileIDs) {
     for (const BucketPlacementData& data : layer.getPlacementData()) {
         Bucket& bucket = data.bucket;
@@ -231,16 +283,26 @@ Point<float> calculateVariableLayoutOffset(style::SymbolAnchorType anchor,
 void Placement::placeSymbolBucket(const BucketPlacementData& params, std::set<uint32_t>& seenCrossTileIDs) {
     assert(updateParameters);
     const auto& symbolBucket = static_cast<const SymbolBucket&>(params.bucket.get());
-    const RenderTile& renderTile = params.tile;
     PlacementContext ctx{symbolBucket,
                          params.tile,
                          collisionIndex.getTransformState(),
                          placementZoom,
-                         collisionGroups.get(params.sourceId),
-                         getAvoidEdges(symbolBucket, renderTile.matrix)};
-    for (const SymbolInstance& symbol : getSortedSymbols(params, ctx.pixelRatio)) {
+                         collisionGroups.get(params.sourceId)};
+    // Projected with the same matrix as the symbols they are checked against.
+    ctx.avoidEdges = getAvoidEdges(symbolBucket, ctx.posMatrix);
+    const SymbolInstanceReferences symbols = getSortedSymbols(params, ctx.pixelRatio);
+
+    // Project the anchors of all the symbols in one pass, instead of once for every collision feature.
+    anchorPoints.clear();
+    for (const SymbolInstance& symbol : symbols) {
+        anchorPoints.push_back(symbol.anchor.point);
+    }
+    collisionIndex.projectAnchors(ctx.posMatrix, anchorPoints, projectedAnchors);
+
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        const SymbolInstance& symbol = symbols[i];
         if (seenCrossTileIDs.count(symbol.crossTileID) != 0u) continue;
-        placeSymbol(symbol, ctx);
+        placeSymbol(symbol, ctx, projectedAnchors[i]);
 
         // Prevent a flickering issue while zooming out.
         if (symbol.crossTileID != SymbolInstance::invalidCrossTileID() && !ctx.getRenderTile().holdForFade()) {
@@ -260,6 +322,12 @@ void Placement::placeSymbolBucket(const BucketPlacementData& params, std::set<ui
 }
 
 JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, const PlacementContext& ctx) {
+    return placeSymbol(symbolInstance, ctx, collisionIndex.projectAnchor(ctx.posMatrix, symbolInstance.anchor.point));
+}
+
+JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance,
+                                      const PlacementContext& ctx,
+                                      const ProjectedAnchor& projectedAnchor) {
     static const JointPlacement kUnplaced(false, false, false);
     if (symbolInstance.crossTileID == SymbolInstance::invalidCrossTileID()) return kUnplaced;
 
@@ -269,7 +337,7 @@ JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, cons
         return kUnplaced;
     }
     const SymbolBucket& bucket = ctx.getBucket();
-    const mat4& posMatrix = ctx.getRenderTile().matrix;
+    const mat4& posMatrix = ctx.posMatrix;
     const auto& collisionGroup = ctx.collisionGroup;
     auto variableTextAnchors = ctx.getVariableTextAnchors();
     textBoxes.clear();
@@ -322,6 +390,7 @@ JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, cons
                 textBoxes.clear();
                 auto placedFeature = collisionIndex.placeFeature(collisionFeature,
                                                                  {},
+                                                                 projectedAnchor,
                                                                  posMatrix,
                                                                  ctx.textLabelPlaneMatrix,
                                                                  ctx.pixelRatio,
@@ -412,6 +481,7 @@ JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, cons
 
                     placedFeature = collisionIndex.placeFeature(textCollisionFeature,
                                                                 shift,
+                                                                projectedAnchor,
                                                                 posMatrix,
                                                                 mat4(),
                                                                 ctx.pixelRatio,
@@ -429,6 +499,7 @@ JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, cons
                         auto placedIconFeature =
                             collisionIndex.placeFeature(iconCollisionFeature,
                                                         shift,
+                                                        projectedAnchor,
                                                         posMatrix,
                                                         ctx.iconLabelPlaneMatrix,
                                                         ctx.pixelRatio,
@@ -522,6 +593,7 @@ JointPlacement Placement::placeSymbol(const SymbolInstance& symbolInstance, cons
         const auto& placeIconFeature = [&](const CollisionFeature& collisionFeature) {
             return collisionIndex.placeFeature(collisionFeature,
                                                shift,
+                                               projectedAnchor,
                                                posMatrix,
                                                ctx.iconLabelPlaneMatrix,
                                                ctx.pixelRatio,
@@ -1368,8 +1440,8 @@ void TilePlacement::placeSymbolBucket(const BucketPlacementData& params, std::se
                          params.tile,
                          collisionIndex.getTransformState(),
                          placementZoom,
-                         collisionGroups.get(params.sourceId),
-                         getAvoidEdges(bucket, renderTile.matrix)};
+                         collisionGroups.get(params.sourceId)};
+    ctx.avoidEdges = getAvoidEdges(bucket, ctx.posMatrix);
 
     const auto& variableTextAnchors = ctx.getVariableTextAnchors();
     // In this case we first try to place symbols, which intersects the tile borders, so that
@@ -1407,7 +1479,7 @@ void TilePlacement::placeSymbolBucket(const BucketPlacementData& params, std::se
     auto collisionBoxIntersectsTileEdges = [&](const CollisionBox& collisionBox,
                                                Point<float> shift) noexcept->IntersectStatus {
         IntersectStatus intersects =
-            collisionIndex.intersectsTileEdges(collisionBox, shift, renderTile.matrix, ctx.pixelRatio, *tileBorders);
+            collisionIndex.intersectsTileEdges(collisionBox, shift, ctx.posMatrix, ctx.pixelRatio, *tileBorders);
         // Check if this symbol intersects the neighbor tile borders. If so, it also shall be placed with priority.
         for (const auto& neighbor : neighbours) {
             if (intersects.flags != IntersectStatus::None) break;
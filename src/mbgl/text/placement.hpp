@@ -8,6 +8,7 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 namespace mbgl {
 
@@ -119,6 +120,14 @@ public:
 
     virtual ~Placement();
     virtual void placeLayers(const RenderLayerReferences&);
+    /**
+     * @brief places the given layers until `timeBudget` is exhausted, at bucket granularity.
+     *
+     * Returns `true` once all the layers are placed and the placement is committed at `now`.
+     * Otherwise returns `false`, and the placement must be resumed on a later frame with the
+     * layers that need placement in that frame; layers that were already placed are skipped.
+     */
+    bool placeLayersIncrementally(const RenderLayerReferences&, TimePoint now, Duration timeBudget);
     void updateLayerBuckets(const RenderLayer&, const TransformState&, bool updateOpacities) const;
     virtual float symbolFadeChange(TimePoint now) const;
     virtual bool hasTransitions(TimePoint now) const;
@@ -143,6 +152,9 @@ protected:
     friend SymbolBucket;
     virtual void placeSymbolBucket(const BucketPlacementData&, std::set<uint32_t>& seenCrossTileIDs);
     JointPlacement placeSymbol(const SymbolInstance& symbolInstance, const PlacementContext&);
+    JointPlacement placeSymbol(const SymbolInstance& symbolInstance,
+                               const PlacementContext&,
+                               const ProjectedAnchor& projectedAnchor);
     void placeLayer(const RenderLayer&, std::set<uint32_t>&);
     virtual void commit();
     virtual void newSymbolPlaced(const SymbolInstance&,
@@ -196,9 +208,19 @@ protected:
     mutable optional<Immutable<Placement>> prevPlacement;
     bool showCollisionBoxes = false;
 
+    // Progress of placeLayersIncrementally().
+    std::unordered_set<std::string> placedLayerIDs;
+    std::string currentLayerID;
+    // Placed buckets of the current layer, by bucket instance and first symbol of the sort key range.
+    std::set<std::pair<uint32_t, std::size_t>> currentLayerPlacedBuckets;
+    std::set<uint32_t> currentLayerSeenCrossTileIDs;
+
     // Cache being used by placeSymbol()
     std::vector<ProjectedCollisionBox> textBoxes;
     std::vector<ProjectedCollisionBox> iconBoxes;
+    // Cache being used by placeSymbolBucket()
+    std::vector<Point<float>> anchorPoints;
+    ProjectedAnchors projectedAnchors;
     // Used for debug purposes.
     std::unordered_map<const CollisionFeature*, std::vector<ProjectedCollisionBox>> collisionCircles;
 };
@@ -543,6 +543,41 @@ Shaping getShaping(const TaggedString& formattedString,
                    float layoutTextSize,
                    float layoutTextSizeAtBucketZoomLevel,
                    bool allowVerticalPlacement) {
+    bool complete = false;
+    return getShaping(formattedString,
+                      maxWidth,
+                      lineHeight,
+                      textAnchor,
+                      textJustify,
+                      spacing,
+                      translate,
+                      writingMode,
+                      bidi,
+                      glyphMap,
+                      glyphPositions,
+                      imagePositions,
+                      layoutTextSize,
+                      layoutTextSizeAtBucketZoomLevel,
+                      allowVerticalPlacement,
+                      complete);
+}
+
+Shaping getShaping(const TaggedString& formattedString,
+                   const float maxWidth,
+                   const float lineHeight,
+                   const style::SymbolAnchorType textAnchor,
+                   const style::TextJustifyType textJustify,
+                   const float spacing,
+                   const std::array<float, 2>& translate,
+                   const WritingModeType writingMode,
+                   BiDi& bidi,
+                   const GlyphMap& glyphMap,
+                   const GlyphPositions& glyphPositions,
+                   const ImagePositions& imagePositions,
+                   float layoutTextSize,
+                   float layoutTextSizeAtBucketZoomLevel,
+                   bool allowVerticalPlacement,
+                   bool& complete) {
     assert(layoutTextSize);
     std::vector<TaggedString> reorderedLines;
     if (formattedString.sectionCount() == 1) {
@@ -574,6 +609,17 @@ Shaping getShaping(const TaggedString& formattedString,
                layoutTextSizeAtBucketZoomLevel,
                allowVerticalPlacement);
 
+    // shapeLines() trims the lines in place, and skips the characters it has no glyph or image for.
+    std::size_t characterCount = 0;
+    for (const auto& line : reorderedLines) {
+        characterCount += line.length();
+    }
+    std::size_t glyphCount = 0;
+    for (const auto& line : shaping.positionedLines) {
+        glyphCount += line.positionedGlyphs.size();
+    }
+    complete = characterCount == glyphCount;
+
     return shaping;
 }
 
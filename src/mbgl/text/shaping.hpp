@@ -97,4 +97,23 @@ Shaping getShaping(const TaggedString& string,
                    float layoutTextSizeAtBucketZoomLevel,
                    bool allowVerticalPlacement);
 
+// Same as above, but also reports whether every character of the string was given a glyph or an
+// image, in which case the result only depends on the arguments and on the glyph metrics.
+Shaping getShaping(const TaggedString& string,
+                   float maxWidth,
+                   float lineHeight,
+                   style::SymbolAnchorType textAnchor,
+                   style::TextJustifyType textJustify,
+                   float spacing,
+                   const std::array<float, 2>& translate,
+                   WritingModeType,
+                   BiDi& bidi,
+                   const GlyphMap& glyphMap,
+                   const GlyphPositions& glyphPositions,
+                   const ImagePositions& imagePositions,
+                   float layoutTextSize,
+                   float layoutTextSizeAtBucketZoomLevel,
+                   bool allowVerticalPlacement,
+                   bool& complete);
+
 } // namespace mbgl
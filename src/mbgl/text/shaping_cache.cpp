@@ -0,0 +1,202 @@
+#include <mbgl/text/shaping_cache.hpp>
+#include <mbgl/util/hash.hpp>
+
+#include <algorithm>
+
+namespace mbgl {
+
+// static
+ShapingCache& ShapingCache::get() {
+    static ShapingCache cache;
+    return cache;
+}
+
+bool ShapingCache::Key::operator==(const Key& other) const {
+    return text == other.text && sectionIndices == other.sectionIndices && sections == other.sections &&
+           maxWidth == other.maxWidth && lineHeight == other.lineHeight && spacing == other.spacing &&
+           translate == other.translate && textAnchor == other.textAnchor && textJustify == other.textJustify && writingMode == other.writingMode &&
+           allowVerticalPlacement == other.allowVerticalPlacement;
+}
+
+std::size_t ShapingCache::KeyHasher::operator()(const Key& key) const {
+    std::size_t seed = util::hash(key.text,
+                                  key.maxWidth,
+                                  key.lineHeight,
+                                  key.spacing,
+                                  key.translate[0],
+                                  key.translate[1],
+                                  static_cast<uint8_t>(key.textAnchor),
+                                  static_cast<uint8_t>(key.textJustify),
+                                  static_cast<uint8_t>(key.writingMode),
+                                  key.allowVerticalPlacement);
+    for (const auto& section : key.sections) {
+        util::hash_combine(seed, section.first);
+        util::hash_combine(seed, section.second);
+    }
+    for (uint8_t sectionIndex : key.sectionIndices) {
+        util::hash_combine(seed, sectionIndex);
+    }
+    return seed;
+}
+
+Shaping ShapingCache::getShaping(const TaggedString& string,
+                                 const float maxWidth,
+                                 const float lineHeight,
+                                 const style::SymbolAnchorType textAnchor,
+                                 const style::TextJustifyType textJustify,
+                                 const float spacing,
+                                 const std::array<float, 2>& translate,
+                                 const WritingModeType writingMode,
+                                 BiDi& bidi,
+                                 const GlyphMap& glyphMap,
+                                 const GlyphPositions& glyphPositions,
+                                 const ImagePositions& imagePositions,
+                                 float layoutTextSize,
+                                 float layoutTextSizeAtBucketZoomLevel,
+                                 bool allowVerticalPlacement) {
+    const auto& sections = string.getSections();
+    const bool hasImages = std::any_of(
+        sections.begin(), sections.end(), [](const SectionOptions& section) { return bool(section.imageID); });
+    if (!size || hasImages) {
+        return mbgl::getShaping(string,
+                                maxWidth,
+                                lineHeight,
+                                textAnchor,
+                                textJustify,
+                                spacing,
+                                translate,
+                                writingMode,
+                                bidi,
+                                glyphMap,
+                                glyphPositions,
+                                imagePositions,
+                                layoutTextSize,
+                                layoutTextSizeAtBucketZoomLevel,
+                                allowVerticalPlacement);
+    }
+
+    // The text sizes only affect the layout of images, so the shaping is shared across zoom levels.
+    Key key{string.rawText(),
+            sections.size() > 1 ? string.getStyledText().second : std::vector<uint8_t>(),
+            {},
+            maxWidth,
+            lineHeight,
+            spacing,
+            translate,
+            textAnchor,
+            textJustify,
+            writingMode,
+            allowVerticalPlacement};
+    key.sections.reserve(sections.size());
+    for (const auto& section : sections) {
+        key.sections.emplace_back(section.fontStackHash, section.scale);
+    }
+
+    std::shared_ptr<const Shaping> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.end(), entries, it->second);
+            cached = it->second->shaping;
+        }
+    }
+
+    if (cached) {
+        Shaping shaping = *cached;
+        if (rebind(shaping, glyphMap, glyphPositions)) {
+            return shaping;
+        }
+    }
+
+    bool complete = false;
+    Shaping shaping = mbgl::getShaping(string,
+                                       maxWidth,
+                                       lineHeight,
+                                       textAnchor,
+                                       textJustify,
+                                       spacing,
+                                       translate,
+                                       writingMode,
+                                       bidi,
+                                       glyphMap,
+                                       glyphPositions,
+                                       imagePositions,
+                                       layoutTextSize,
+                                       layoutTextSizeAtBucketZoomLevel,
+                                       allowVerticalPlacement,
+                                       complete);
+    // A shaping that misses glyphs must not be reused on tiles that have them.
+    if (complete) {
+        add(std::move(key), std::make_shared<const Shaping>(shaping));
+    }
+    return shaping;
+}
+
+// static
+bool ShapingCache::rebind(Shaping& shaping, const GlyphMap& glyphMap, const GlyphPositions& glyphPositions) {
+    for (auto& line : shaping.positionedLines) {
+        for (auto& positionedGlyph : line.positionedGlyphs) {
+            auto glyphPositionMap = glyphPositions.find(positionedGlyph.font);
+            if (glyphPositionMap == glyphPositions.end()) {
+                return false;
+            }
+
+            auto glyphPosition = glyphPositionMap->second.find(positionedGlyph.glyph);
+            if (glyphPosition != glyphPositionMap->second.end()) {
+                if (!(glyphPosition->second.metrics == positionedGlyph.metrics)) {
+                    return false;
+                }
+                positionedGlyph.rect = glyphPosition->second.rect;
+                continue;
+            }
+
+            // Like shapeLines(), fall back to the glyph metrics with an empty atlas position.
+            auto glyphs = glyphMap.find(positionedGlyph.font);
+            if (glyphs == glyphMap.end()) {
+                return false;
+            }
+            auto glyph = glyphs->second.find(positionedGlyph.glyph);
+            if (glyph == glyphs->second.end() || !glyph->second ||
+                !((*glyph->second)->metrics == positionedGlyph.metrics)) {
+                return false;
+            }
+            positionedGlyph.rect = {};
+        }
+    }
+    return true;
+}
+
+void ShapingCache::add(Key key, std::shared_ptr<const Shaping> shaping) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // Another worker may have shaped the same text in the meantime, or the glyph metrics have
+        // changed since the entry was added.
+        it->second->shaping = std::move(shaping);
+        entries.splice(entries.end(), entries, it->second);
+        return;
+    }
+
+    entries.push_back({key, std::move(shaping)});
+    index.emplace(std::move(key), std::prev(entries.end()));
+
+    while (entries.size() > size) {
+        index.erase(entries.front().key);
+        entries.pop_front();
+    }
+}
+
+std::size_t ShapingCache::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void ShapingCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    entries.clear();
+}
+
+} // namespace mbgl
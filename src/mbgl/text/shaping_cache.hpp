@@ -0,0 +1,94 @@
+#pragma once
+
+#include <mbgl/text/shaping.hpp>
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mbgl {
+
+// Least recently used cache of text shapings, shared by the layout workers, so that labels that
+// repeat on neighbouring tiles and zoom levels are only shaped once. Shapings are keyed by the
+// text, its sections and the layout parameters that affect shaping. The glyph atlas positions
+// differ from tile to tile, so a cached shaping is rebound to the glyph positions of the tile
+// that asks for it, and only reused if all of its glyphs are available there with the same
+// metrics. Texts with images are not cached. All operations are thread-safe.
+class ShapingCache {
+public:
+    static constexpr std::size_t DefaultSize = 4096;
+
+    explicit ShapingCache(std::size_t size_ = DefaultSize) : size(size_) {}
+
+    // The cache shared by all of the symbol layouts of the process.
+    static ShapingCache& get();
+
+    // Takes the same arguments as mbgl::getShaping(), and returns the same shaping.
+    Shaping getShaping(const TaggedString& string,
+                       float maxWidth,
+                       float lineHeight,
+                       style::SymbolAnchorType textAnchor,
+                       style::TextJustifyType textJustify,
+                       float spacing,
+                       const std::array<float, 2>& translate,
+                       WritingModeType,
+                       BiDi& bidi,
+                       const GlyphMap& glyphMap,
+                       const GlyphPositions& glyphPositions,
+                       const ImagePositions& imagePositions,
+                       float layoutTextSize,
+                       float layoutTextSizeAtBucketZoomLevel,
+                       bool allowVerticalPlacement);
+
+    std::size_t getSize() const;
+    void clear();
+
+private:
+    struct Key {
+        std::u16string text;
+        // Section of each character, only when there is more than one section.
+        std::vector<uint8_t> sectionIndices;
+        std::vector<std::pair<FontStackHash, double>> sections;
+        float maxWidth;
+        float lineHeight;
+        float spacing;
+        std::array<float, 2> translate;
+        style::SymbolAnchorType textAnchor;
+        style::TextJustifyType textJustify;
+        WritingModeType writingMode;
+        bool allowVerticalPlacement;
+
+        bool operator==(const Key&) const;
+    };
+
+    struct KeyHasher {
+        std::size_t operator()(const Key&) const;
+    };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const Shaping> shaping;
+    };
+    using Entries = std::list<Entry>;
+
+    // Replaces the glyph atlas positions of the shaping with the ones of the given tile, and
+    // returns whether all of its glyphs are there with the same metrics.
+    static bool rebind(Shaping&, const GlyphMap&, const GlyphPositions&);
+
+    void add(Key, std::shared_ptr<const Shaping>);
+
+    const std::size_t size;
+
+    mutable std::mutex mutex;
+    // Ordered from the least to the most recently used.
+    Entries entries;
+    std::unordered_map<Key, Entries::iterator, KeyHasher> index;
+};
+
+} // namespace mbgl
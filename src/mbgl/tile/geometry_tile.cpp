@@ -22,6 +22,7 @@
 #include <mbgl/util/logging.hpp>
 
 #include <mbgl/gfx/upload_pass.hpp>
+#include <unordered_set>
 #include <utility>
 
 namespace mbgl {
@@ -238,6 +239,10 @@ void GeometryTile::setShowCollisionBoxes(const bool showCollisionBoxes_) {
     }
 }
 
+void GeometryTile::setPriority(TaskPriority priority) {
+    worker.setPriority(priority);
+}
+
 void GeometryTile::onLayout(std::shared_ptr<LayoutResult> result, const uint64_t resultCorrelationID) {
     loaded = true;
     renderable = true;
@@ -319,6 +324,30 @@ float GeometryTile::getQueryPadding(const std::unordered_map<std::string, const
     return queryPadding;
 }
 
+std::size_t GeometryTile::getMemoryUsage() const {
+    if (!layoutResult) {
+        return 0;
+    }
+
+    std::size_t bytes = 0;
+    // Layers of one layout group share their bucket.
+    std::unordered_set<const Bucket*> buckets;
+    for (const auto& pair : layoutResult->layerRenderData) {
+        const Bucket* bucket = pair.second.bucket.get();
+        if (bucket && buckets.insert(bucket).second) {
+            bytes += bucket->getMemoryUsage();
+        }
+    }
+    if (layoutResult->featureIndex) {
+        bytes += layoutResult->featureIndex->getMemoryUsage();
+    }
+    if (layoutResult->glyphAtlasImage) {
+        bytes += layoutResult->glyphAtlasImage->bytes();
+    }
+    bytes += layoutResult->iconAtlas.image.bytes();
+    return bytes;
+}
+
 void GeometryTile::queryRenderedFeatures(std::unordered_map<std::string, std::vector<Feature>>& result,
                                          const GeometryCoordinates& queryGeometry, const TransformState& transformState,
                                          const std::unordered_map<std::string, const RenderLayer*>& layers,
@@ -42,6 +42,7 @@ public:
     std::unique_ptr<TileRenderData> createRenderData() override;
     void setLayers(const std::vector<Immutable<style::LayerProperties>>&) override;
     void setShowCollisionBoxes(bool showCollisionBoxes) override;
+    void setPriority(TaskPriority) override;
 
     void onGlyphsAvailable(GlyphMap) override;
     void onImagesAvailable(ImageMap, ImageMap, ImageVersionMap versionMap, uint64_t imageCorrelationID) override;
@@ -62,6 +63,7 @@ public:
         const SourceQueryOptions&) override;
 
     float getQueryPadding(const std::unordered_map<std::string, const RenderLayer*>&) override;
+    std::size_t getMemoryUsage() const override;
 
     void cancel() override;
 
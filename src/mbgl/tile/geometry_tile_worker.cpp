@@ -5,6 +5,7 @@
 #include <mbgl/layout/layout.hpp>
 #include <mbgl/layout/symbol_layout.hpp>
 #include <mbgl/layout/pattern_layout.hpp>
+#include <mbgl/platform/settings.hpp>
 #include <mbgl/renderer/bucket_parameters.hpp>
 #include <mbgl/renderer/group_by_layout.hpp>
 #include <mbgl/style/filter.hpp>
@@ -18,8 +19,12 @@
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/exception.hpp>
+#include <mbgl/util/parallel_for.hpp>
 #include <mbgl/util/stopwatch.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 
@@ -42,7 +47,12 @@ GeometryTileWorker::GeometryTileWorker(ActorRef<GeometryTileWorker> self_,
       obsolete(obsolete_),
       mode(mode_),
       pixelRatio(pixelRatio_),
-      showCollisionBoxes(showCollisionBoxes_) {}
+      showCollisionBoxes(showCollisionBoxes_) {
+    auto value = platform::Settings::getInstance().get(platform::EXPERIMENTAL_PARALLEL_TILE_PARSING);
+    if (auto* parallel = value.getBool()) {
+        if (*parallel) parallelScheduler = Scheduler::GetBackground();
+    }
+}
 
 GeometryTileWorker::~GeometryTileWorker() = default;
 
@@ -333,6 +343,19 @@ void GeometryTileWorker::requestNewImages(const ImageDependencies& imageDependen
     }
 }
 
+namespace {
+
+// Results of parsing a single layer group in parallel with the others.
+struct LayerGroupResult {
+    std::unique_ptr<FeatureIndex> featureIndex = std::make_unique<FeatureIndex>(nullptr);
+    std::unordered_map<std::string, LayerRenderData> renderData;
+    std::vector<std::unique_ptr<Layout>> layouts;
+    GlyphDependencies glyphDependencies;
+    ImageDependencies imageDependencies;
+};
+
+} // namespace
+
 void GeometryTileWorker::parse() {
     if (!data || !layers) {
         return;
@@ -340,8 +363,6 @@ void GeometryTileWorker::parse() {
 
     MBGL_TIMING_START(watch)
 
-    std::unordered_map<std::string, std::unique_ptr<SymbolLayout>> symbolLayoutMap;
-
     renderData.clear();
     layouts.clear();
 
@@ -351,72 +372,73 @@ void GeometryTileWorker::parse() {
     ImageDependencies imageDependencies;
 
     // Create render layers and group by layout
-    std::unordered_map<std::string, std::vector<Immutable<style::LayerProperties>>> groupMap;
-    for (auto layer : *layers) {
-        groupMap[layoutKey(*layer->baseImpl)].push_back(std::move(layer));
+    const auto groupList = groupByLayout(*layers);
+
+    // Source layers are looked up front, as GeometryTileData is not thread-safe.
+    std::vector<std::pair<const std::vector<Immutable<style::LayerProperties>>*, std::unique_ptr<GeometryTileLayer>>>
+        groups;
+    if (*data) {
+        groups.reserve(groupList.size());
+        for (const auto& group : groupList) {
+            if (auto geometryLayer = (*data)->getLayer(group.at(0)->baseImpl->sourceLayer)) {
+                groups.emplace_back(&group, std::move(geometryLayer));
+            }
+        }
     }
 
-    for (auto& pair : groupMap) {
-        const auto& group = pair.second;
+    if (parallelScheduler && groups.size() > 1) {
+        std::vector<LayerGroupResult> results(groups.size());
+        // The helper tasks inherit the priority of this tile, so that the groups of a
+        // visible tile don't wait behind the ones of prefetched tiles.
+        util::parallelFor(
+            *parallelScheduler,
+            groups.size(),
+            std::thread::hardware_concurrency(),
+            self.getPriority(),
+            [&](std::size_t i) {
+                if (obsolete) {
+                    return;
+                }
+                auto& result = results[i];
+                parseGroup(*groups[i].first,
+                           std::move(groups[i].second),
+                           result.featureIndex,
+                           result.renderData,
+                           result.layouts,
+                           result.glyphDependencies,
+                           result.imageDependencies);
+            });
+
         if (obsolete) {
             return;
         }
 
-        if (!*data) {
-            continue; // Tile has no data.
-        }
-
-        const style::Layer::Impl& leaderImpl = *(group.at(0)->baseImpl);
-        BucketParameters parameters { id, mode, pixelRatio, leaderImpl.getTypeInfo() };
-
-        auto geometryLayer = (*data)->getLayer(leaderImpl.sourceLayer);
-        if (!geometryLayer) {
-            continue;
-        }
-
-        std::vector<std::string> layerIDs(group.size());
-        for (const auto& layer : group) {
-            layerIDs.push_back(layer->baseImpl->id);
-        }
-
-        featureIndex->setBucketLayerIDs(leaderImpl.id, layerIDs);
-
-        // Symbol layers and layers that support pattern properties have an extra step at layout time to figure out what images/glyphs
-        // are needed to render the layer. They use the intermediate Layout data structure to accomplish this,
-        // and either immediately create a bucket if no images/glyphs are used, or the Layout is stored until
-        // the images/glyphs are available to add the features to the buckets.
-        if (leaderImpl.getTypeInfo()->layout == LayerTypeInfo::Layout::Required) {
-            std::unique_ptr<Layout> layout = LayerManager::get()->createLayout(
-                {parameters, glyphDependencies, imageDependencies, availableImages}, std::move(geometryLayer), group);
-            if (layout->hasDependencies()) {
-                layouts.push_back(std::move(layout));
-            } else {
-                layout->createBucket({}, featureIndex, renderData, firstLoad, showCollisionBoxes, id.canonical);
+        // Merge in the group order, so the result is the same as when parsing sequentially.
+        for (auto& result : results) {
+            featureIndex->append(std::move(*result.featureIndex));
+            for (auto& pair : result.renderData) {
+                renderData.emplace(pair.first, std::move(pair.second));
             }
-        } else {
-            const Filter& filter = leaderImpl.filter;
-            const std::string& sourceLayerID = leaderImpl.sourceLayer;
-            std::shared_ptr<Bucket> bucket = LayerManager::get()->createBucket(parameters, group);
-
-            for (std::size_t i = 0; !obsolete && i < geometryLayer->featureCount(); i++) {
-                std::unique_ptr<GeometryTileFeature> feature = geometryLayer->getFeature(i);
-
-                if (!filter(expression::EvaluationContext(static_cast<float>(this->id.overscaledZ), feature.get())
-                                .withCanonicalTileID(&id.canonical)))
-                    continue;
-
-                const GeometryCollection& geometries = feature->getGeometries();
-                bucket->addFeature(*feature, geometries, {}, PatternLayerMap(), i, id.canonical);
-                featureIndex->insert(geometries, i, sourceLayerID, leaderImpl.id);
+            std::move(result.layouts.begin(), result.layouts.end(), std::back_inserter(layouts));
+            for (auto& fontDependencies : result.glyphDependencies) {
+                glyphDependencies[fontDependencies.first].insert(fontDependencies.second.begin(),
+                                                                 fontDependencies.second.end());
             }
-
-            if (!bucket->hasData()) {
-                continue;
+            imageDependencies.insert(result.imageDependencies.begin(), result.imageDependencies.end());
+        }
+    } else {
+        for (auto& group : groups) {
+            if (obsolete) {
+                return;
             }
 
-            for (const auto& layer : group) {
-                renderData.emplace(layer->baseImpl->id, LayerRenderData{bucket, layer});
-            }
+            parseGroup(*group.first,
+                       std::move(group.second),
+                       featureIndex,
+                       renderData,
+                       layouts,
+                       glyphDependencies,
+                       imageDependencies);
         }
     }
 
@@ -431,6 +453,62 @@ void GeometryTileWorker::parse() {
     finalizeLayout();
 }
 
+void GeometryTileWorker::parseGroup(const std::vector<Immutable<style::LayerProperties>>& group,
+                                    std::unique_ptr<GeometryTileLayer> geometryLayer,
+                                    std::unique_ptr<FeatureIndex>& featureIndex_,
+                                    std::unordered_map<std::string, LayerRenderData>& renderData_,
+                                    std::vector<std::unique_ptr<Layout>>& layouts_,
+                                    GlyphDependencies& glyphDependencies,
+                                    ImageDependencies& imageDependencies) {
+    const style::Layer::Impl& leaderImpl = *(group.at(0)->baseImpl);
+    BucketParameters parameters { id, mode, pixelRatio, leaderImpl.getTypeInfo() };
+
+    std::vector<std::string> layerIDs(group.size());
+    for (const auto& layer : group) {
+        layerIDs.push_back(layer->baseImpl->id);
+    }
+
+    featureIndex_->setBucketLayerIDs(leaderImpl.id, layerIDs);
+
+    // Symbol layers and layers that support pattern properties have an extra step at layout time to figure out what images/glyphs
+    // are needed to render the layer. They use the intermediate Layout data structure to accomplish this,
+    // and either immediately create a bucket if no images/glyphs are used, or the Layout is stored until
+    // the images/glyphs are available to add the features to the buckets.
+    if (leaderImpl.getTypeInfo()->layout == LayerTypeInfo::Layout::Required) {
+        std::unique_ptr<Layout> layout = LayerManager::get()->createLayout(
+            {parameters, glyphDependencies, imageDependencies, availableImages}, std::move(geometryLayer), group);
+        if (layout->hasDependencies()) {
+            layouts_.push_back(std::move(layout));
+        } else {
+            layout->createBucket({}, featureIndex_, renderData_, firstLoad, showCollisionBoxes, id.canonical);
+        }
+    } else {
+        const Filter& filter = leaderImpl.filter;
+        const std::string& sourceLayerID = leaderImpl.sourceLayer;
+        std::shared_ptr<Bucket> bucket = LayerManager::get()->createBucket(parameters, group);
+
+        for (std::size_t i = 0; !obsolete && i < geometryLayer->featureCount(); i++) {
+            std::unique_ptr<GeometryTileFeature> feature = geometryLayer->getFeature(i);
+
+            if (!filter(expression::EvaluationContext(static_cast<float>(this->id.overscaledZ), feature.get())
+                            .withCanonicalTileID(&id.canonical)))
+                continue;
+
+            const GeometryCollection& geometries = feature->getGeometries();
+            bucket->addFeature(*feature, geometries, {}, PatternLayerMap(), i, id.canonical);
+            featureIndex_->insert(geometries, i, sourceLayerID, leaderImpl.id);
+        }
+
+        if (!bucket->hasData()) {
+            return;
+        }
+
+        for (const auto& layer : group) {
+            renderData_.emplace(layer->baseImpl->id, LayerRenderData{bucket, layer});
+        }
+    }
+}
+
 bool GeometryTileWorker::hasPendingDependencies() const {
     for (auto& glyphDependency : pendingGlyphDependencies) {
         if (!glyphDependency.second.empty()) {
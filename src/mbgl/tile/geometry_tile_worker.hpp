@@ -20,7 +20,9 @@ namespace mbgl {
 
 class GeometryTile;
 class GeometryTileData;
+class GeometryTileLayer;
 class Layout;
+class Scheduler;
 
 namespace style {
 class Layer;
@@ -69,6 +71,14 @@ private:
 
     void checkPatternLayout(std::unique_ptr<Layout> layout);
 
+    void parseGroup(const std::vector<Immutable<style::LayerProperties>>& group,
+                    std::unique_ptr<GeometryTileLayer> geometryLayer,
+                    std::unique_ptr<FeatureIndex>& featureIndex_,
+                    std::unordered_map<std::string, LayerRenderData>& renderData_,
+                    std::vector<std::unique_ptr<Layout>>& layouts_,
+                    GlyphDependencies& glyphDependencies,
+                    ImageDependencies& imageDependencies);
+
     ActorRef<GeometryTileWorker> self;
     ActorRef<GeometryTile> parent;
 
@@ -108,6 +118,9 @@ private:
 
     bool showCollisionBoxes;
     bool firstLoad = true;
+
+    // Set if the layer groups are parsed in parallel.
+    std::shared_ptr<Scheduler> parallelScheduler;
 };
 
 } // namespace mbgl
@@ -79,6 +79,10 @@ bool RasterDEMTile::layerPropertiesUpdated(const Immutable<style::LayerPropertie
     return bool(bucket);
 }
 
+std::size_t RasterDEMTile::getMemoryUsage() const {
+    return bucket ? bucket->getMemoryUsage() : 0;
+}
+
 HillshadeBucket* RasterDEMTile::getBucket() const {
     return bucket.get();
 }
@@ -126,4 +130,9 @@ void RasterDEMTile::setUpdateParameters(const TileUpdateParameters& params) {
     loader.setUpdateParameters(params);
 }
 
+void RasterDEMTile::setPriority(TaskPriority priority) {
+    worker.setPriority(priority);
+    loader.setPriority(priority == TaskPriority::Low ? Resource::Priority::Prefetch : Resource::Priority::Regular);
+}
+
 } // namespace mbgl
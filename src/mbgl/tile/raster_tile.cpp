@@ -68,6 +68,10 @@ bool RasterTile::layerPropertiesUpdated(const Immutable<style::LayerProperties>&
     return bool(bucket);
 }
 
+std::size_t RasterTile::getMemoryUsage() const {
+    return bucket ? bucket->getMemoryUsage() : 0;
+}
+
 void RasterTile::setMask(TileMask&& mask) {
     if (bucket) {
         bucket->setMask(std::move(mask));
@@ -82,4 +86,9 @@ void RasterTile::setUpdateParameters(const TileUpdateParameters& params) {
     loader.setUpdateParameters(params);
 }
 
+void RasterTile::setPriority(TaskPriority priority) {
+    worker.setPriority(priority);
+    loader.setPriority(priority == TaskPriority::Low ? Resource::Priority::Prefetch : Resource::Priority::Regular);
+}
+
 } // namespace mbgl
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mbgl/actor/scheduler.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/chrono.hpp>
 #include <mbgl/util/optional.hpp>
@@ -67,6 +68,9 @@ public:
 
     virtual void setUpdateParameters(const TileUpdateParameters&) {}
 
+    // Sets the priority of the background work (e.g. parsing) done for this tile.
+    virtual void setPriority(TaskPriority) {}
+
     // Mark this tile as no longer needed and cancel any pending work.
     virtual void cancel();
 
@@ -94,6 +98,10 @@ public:
 
     virtual float getQueryPadding(const std::unordered_map<std::string, const RenderLayer*>&);
 
+    // Returns an estimate of the bytes retained by this tile, e.g. by its buckets, feature index and
+    // atlases.
+    virtual std::size_t getMemoryUsage() const { return 0; }
+
     void setTriedCache();
 
     // Returns true when the tile source has received a first response, regardless of whether a load
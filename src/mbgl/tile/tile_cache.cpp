@@ -5,14 +5,14 @@ namespace mbgl {
 
 void TileCache::setSize(size_t size_) {
     size = size_;
+    purge();
+    assert(entries.size() <= size);
+}
 
-    while (orderedKeys.size() > size) {
-        auto key = orderedKeys.front();
-        orderedKeys.remove(key);
-        tiles.erase(key);
-    }
-
-    assert(orderedKeys.size() <= size);
+void TileCache::setMemoryBudget(size_t memoryBudget_) {
+    memoryBudget = memoryBudget_;
+    purge();
+    assert(memoryUsage <= memoryBudget);
 }
 
 void TileCache::add(const OverscaledTileID& key, std::unique_ptr<Tile> tile) {
@@ -20,27 +20,28 @@ void TileCache::add(const OverscaledTileID& key, std::unique_ptr<Tile> tile) {
         return;
     }
 
-    // insert new or query existing tile
-    if (!tiles.emplace(key, std::move(tile)).second) {
-        // remove existing tile key
-        orderedKeys.remove(key);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // keep the existing tile, but mark it as the newest
+        entries.splice(entries.end(), entries, it->second);
+    } else {
+        const size_t tileMemoryUsage = tile->getMemoryUsage();
+        entries.push_back({ key, std::move(tile), tileMemoryUsage });
+        index.emplace(key, std::prev(entries.end()));
+        memoryUsage += tileMemoryUsage;
     }
 
-    // (re-)insert tile key as newest
-    orderedKeys.push_back(key);
-
-    // purge oldest key/tile if necessary
-    if (orderedKeys.size() > size) {
-        pop(orderedKeys.front());
-    }
+    // purge oldest tiles if necessary
+    purge();
 
-    assert(orderedKeys.size() <= size);
+    assert(entries.size() <= size);
+    assert(memoryUsage <= memoryBudget);
 }
 
 Tile* TileCache::get(const OverscaledTileID& key) {
-    auto it = tiles.find(key);
-    if (it != tiles.end()) {
-        return it->second.get();
+    auto it = index.find(key);
+    if (it != index.end()) {
+        return it->second->tile.get();
     } else {
         return nullptr;
     }
@@ -50,11 +51,10 @@ std::unique_ptr<Tile> TileCache::pop(const OverscaledTileID& key) {
 
     std::unique_ptr<Tile> tile;
 
-    auto it = tiles.find(key);
-    if (it != tiles.end()) {
-        tile = std::move(it->second);
-        tiles.erase(it);
-        orderedKeys.remove(key);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        tile = std::move(it->second->tile);
+        erase(it->second);
         assert(tile->isRenderable());
     }
 
@@ -62,12 +62,26 @@ std::unique_ptr<Tile> TileCache::pop(const OverscaledTileID& key) {
 }
 
 bool TileCache::has(const OverscaledTileID& key) {
-    return tiles.find(key) != tiles.end();
+    return index.find(key) != index.end();
 }
 
 void TileCache::clear() {
-    orderedKeys.clear();
-    tiles.clear();
+    index.clear();
+    entries.clear();
+    memoryUsage = 0;
+}
+
+void TileCache::erase(Entries::iterator it) {
+    assert(memoryUsage >= it->memoryUsage);
+    memoryUsage -= it->memoryUsage;
+    index.erase(it->key);
+    entries.erase(it);
+}
+
+void TileCache::purge() {
+    while (!entries.empty() && (entries.size() > size || memoryUsage > memoryBudget)) {
+        erase(entries.begin());
+    }
 }
 
 } // namespace mbgl
@@ -3,19 +3,25 @@
 #include <mbgl/tile/tile_id.hpp>
 #include <mbgl/tile/tile.hpp>
 
-
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
-#include <map>
+#include <unordered_map>
 
 namespace mbgl {
 
+// Least recently used cache of tiles, limited both by the number of tiles and by the bytes they
+// retain as reported by Tile::getMemoryUsage(). All operations are O(1).
 class TileCache {
 public:
     TileCache(size_t size_ = 0) : size(size_) {}
 
     void setSize(size_t);
     size_t getSize() const { return size; };
+    void setMemoryBudget(size_t);
+    size_t getMemoryBudget() const { return memoryBudget; }
+    size_t getMemoryUsage() const { return memoryUsage; }
     void add(const OverscaledTileID& key, std::unique_ptr<Tile> tile);
     std::unique_ptr<Tile> pop(const OverscaledTileID& key);
     Tile* get(const OverscaledTileID& key);
@@ -23,10 +29,24 @@ public:
     void clear();
 
 private:
-    std::map<OverscaledTileID, std::unique_ptr<Tile>> tiles;
-    std::list<OverscaledTileID> orderedKeys;
+    struct Entry {
+        OverscaledTileID key;
+        std::unique_ptr<Tile> tile;
+        // The usage is sampled when the tile is added, so that the total stays consistent.
+        size_t memoryUsage;
+    };
+    using Entries = std::list<Entry>;
+
+    void erase(Entries::iterator);
+    void purge();
+
+    // Ordered from the least to the most recently added.
+    Entries entries;
+    std::unordered_map<OverscaledTileID, Entries::iterator> index;
 
     size_t size;
+    size_t memoryBudget = std::numeric_limits<size_t>::max();
+    size_t memoryUsage = 0;
 };
 
 } // namespace mbgl
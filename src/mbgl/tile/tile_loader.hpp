@@ -24,6 +24,8 @@ public:
 
     void setNecessity(TileNecessity newNecessity);
     void setUpdateParameters(const TileUpdateParameters&);
+    // Applies to the pending request as well as to the ones made from now on.
+    void setPriority(Resource::Priority);
 
 private:
     // called when the tile is one of the ideal tiles that we want to show definitely. the tile source
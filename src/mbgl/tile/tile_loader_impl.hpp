@@ -80,6 +80,16 @@ void TileLoader<T>::setUpdateParameters(const TileUpdateParameters& params) {
     }
 }
 
+template <typename T>
+void TileLoader<T>::setPriority(Resource::Priority priority) {
+    if (resource.priority != priority) {
+        resource.setPriority(priority);
+        if (request) {
+            fileSource->setPriority(*request, priority);
+        }
+    }
+}
+
 template <typename T>
 void TileLoader<T>::loadFromCache() {
     assert(!request);
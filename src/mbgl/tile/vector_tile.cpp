@@ -20,6 +20,11 @@ void VectorTile::setUpdateParameters(const TileUpdateParameters& params) {
     loader.setUpdateParameters(params);
 }
 
+void VectorTile::setPriority(TaskPriority priority) {
+    GeometryTile::setPriority(priority);
+    loader.setPriority(priority == TaskPriority::Low ? Resource::Priority::Prefetch : Resource::Priority::Regular);
+}
+
 void VectorTile::setMetadata(optional<Timestamp> modified_, optional<Timestamp> expires_) {
     modified = std::move(modified_);
     expires = std::move(expires_);
@@ -1,20 +1,240 @@
 #include <mbgl/tile/vector_tile_data.hpp>
+#include <mbgl/tile/vector_tile_geometry.hpp>
 #include <mbgl/util/constants.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
 namespace mbgl {
 
-VectorTileFeature::VectorTileFeature(const mapbox::vector_tile::layer& layer,
+namespace {
+
+// Geometry types as encoded in the vector tile specification.
+enum : uint32_t {
+    GeomTypeUnknown = 0,
+    GeomTypePoint = 1,
+    GeomTypeLineString = 2,
+    GeomTypePolygon = 3
+};
+
+// Geometry commands as encoded in the vector tile specification.
+enum : uint32_t {
+    CommandMoveTo = 1,
+    CommandLineTo = 2,
+    CommandClosePath = 7
+};
+
+Value parseValue(const protozero::data_view& view) {
+    protozero::pbf_reader value(view);
+    while (value.next()) {
+        switch (value.tag()) {
+        case 1: // string_value
+            return value.get_string();
+        case 2: // float_value
+            return static_cast<double>(value.get_float());
+        case 3: // double_value
+            return value.get_double();
+        case 4: // int_value
+            return value.get_int64();
+        case 5: // uint_value
+            return value.get_uint64();
+        case 6: // sint_value
+            return value.get_sint64();
+        case 7: // bool_value
+            return value.get_bool();
+        default:
+            value.skip();
+            break;
+        }
+    }
+    return NullValue();
+}
+
+} // namespace
+
+// The parsed contents of a vector tile layer, shared by every VectorTileLayer that a
+// VectorTileData hands out for it.
+class VectorTileLayerData {
+public:
+    VectorTileLayerData(std::shared_ptr<const std::string> data, const protozero::data_view&);
+
+    optional<std::size_t> getKeyIndex(const std::string& key) const;
+
+    // Geometries are only cached while more than one VectorTileLayer reads this layer. An entry is
+    // freed once every consumer has destroyed its feature for that index, which keeps the cache
+    // bounded to the features that are still in flight.
+    std::shared_ptr<const GeometryCollection> getCachedGeometries(std::size_t index);
+    void cacheGeometries(std::size_t index, const std::shared_ptr<const GeometryCollection>&);
+    void release(std::size_t index);
+    // Called when a VectorTileLayer reading this layer is destroyed.
+    void removeConsumer();
+
+    const std::shared_ptr<const std::string> data;
+    std::string name;
+    uint32_t version = 1;
+    uint32_t extent = 4096;
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, std::size_t> keyIndices;
+    std::vector<protozero::data_view> values;
+    std::vector<protozero::data_view> features;
+
+    std::atomic<std::size_t> consumers { 0 };
+
+private:
+    struct CachedGeometries {
+        std::shared_ptr<const GeometryCollection> geometries;
+        std::size_t released = 0;
+    };
+
+    std::mutex mutex;
+    std::vector<CachedGeometries> cache;
+};
+
+VectorTileLayerData::VectorTileLayerData(std::shared_ptr<const std::string> data_,
+                                         const protozero::data_view& view)
+    : data(std::move(data_)) {
+    protozero::pbf_reader layer(view);
+    while (layer.next()) {
+        switch (layer.tag()) {
+        case 1: // name
+            name = layer.get_string();
+            break;
+        case 2: // features
+            features.push_back(layer.get_view());
+            break;
+        case 3: // keys
+            keys.push_back(layer.get_string());
+            break;
+        case 4: // values
+            values.push_back(layer.get_view());
+            break;
+        case 5: // extent
+            extent = layer.get_uint32();
+            break;
+        case 15: // version
+            version = layer.get_uint32();
+            break;
+        default:
+            layer.skip();
+            break;
+        }
+    }
+
+    keyIndices.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keyIndices.emplace(keys[i], i);
+    }
+}
+
+optional<std::size_t> VectorTileLayerData::getKeyIndex(const std::string& key) const {
+    auto it = keyIndices.find(key);
+    if (it != keyIndices.end()) {
+        return it->second;
+    }
+    return nullopt;
+}
+
+std::shared_ptr<const GeometryCollection> VectorTileLayerData::getCachedGeometries(std::size_t index) {
+    if (consumers <= 1) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < cache.size() ? cache[index].geometries : nullptr;
+}
+
+void VectorTileLayerData::cacheGeometries(std::size_t index,
+                                          const std::shared_ptr<const GeometryCollection>& geometries) {
+    if (consumers <= 1) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    // The other consumers may have gone away since the check above, and a single consumer must
+    // not refill the cache that removeConsumer() dropped.
+    if (consumers <= 1) {
+        return;
+    }
+    if (cache.empty()) {
+        cache.resize(features.size());
+    }
+    auto& entry = cache[index];
+    // Only keep the geometries if another consumer still has to read this feature.
+    if (entry.released + 1 < consumers) {
+        entry.geometries = geometries;
+    }
+}
+
+void VectorTileLayerData::release(std::size_t index) {
+    if (consumers <= 1) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (consumers <= 1) {
+        return;
+    }
+    if (cache.empty()) {
+        cache.resize(features.size());
+    }
+    auto& entry = cache[index];
+    if (++entry.released >= consumers) {
+        entry.geometries.reset();
+    }
+}
+
+void VectorTileLayerData::removeConsumer() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--consumers <= 1) {
+        // A single consumer never reads from the cache.
+        std::vector<CachedGeometries>().swap(cache);
+        return;
+    }
+    // The consumer that went away won't release the features it hasn't reached. Entries
+    // that it did release may be freed a bit early now, which only costs another decode.
+    for (auto& entry : cache) {
+        if (entry.released >= consumers) {
+            entry.geometries.reset();
+        }
+    }
+}
+
+VectorTileFeature::VectorTileFeature(std::shared_ptr<VectorTileLayerData> layer_,
+                                     std::size_t index_,
                                      const protozero::data_view& view)
-    : feature(view, layer) {
+    : layer(std::move(layer_)), index(index_) {
+    protozero::pbf_reader feature(view);
+    while (feature.next()) {
+        switch (feature.tag()) {
+        case 1: // id
+            id = feature.get_uint64();
+            break;
+        case 2: // tags
+            tags = feature.get_packed_uint32();
+            break;
+        case 3: // type
+            type = static_cast<uint32_t>(feature.get_enum());
+            break;
+        case 4: // geometry
+            geometry = feature.get_view();
+            break;
+        default:
+            feature.skip();
+            break;
+        }
+    }
+}
+
+VectorTileFeature::~VectorTileFeature() {
+    layer->release(index);
 }
 
 FeatureType VectorTileFeature::getType() const {
-    switch (feature.getType()) {
-    case mapbox::vector_tile::GeomType::POINT:
+    switch (type) {
+    case GeomTypePoint:
         return FeatureType::Point;
-    case mapbox::vector_tile::GeomType::LINESTRING:
+    case GeomTypeLineString:
         return FeatureType::LineString;
-    case mapbox::vector_tile::GeomType::POLYGON:
+    case GeomTypePolygon:
         return FeatureType::Polygon;
     default:
         return FeatureType::Unknown;
@@ -22,47 +242,149 @@ FeatureType VectorTileFeature::getType() const {
 }
 
 optional<Value> VectorTileFeature::getValue(const std::string& key) const {
-    const optional<Value> value(feature.getValue(key));
-    return value->is<NullValue>() ? nullopt : value;
+    if (auto keyIndex = layer->getKeyIndex(key)) {
+        return getValueByKeyIndex(*keyIndex);
+    }
+    return nullopt;
+}
+
+optional<Value> VectorTileFeature::getValueByKeyIndex(std::size_t keyIndex) const {
+    for (auto it = tags.begin(); it != tags.end();) {
+        const uint32_t tagKey = *it++;
+        if (it == tags.end()) {
+            throw std::runtime_error("uneven number of feature tag ids");
+        }
+        const uint32_t tagValue = *it++;
+        if (tagKey == keyIndex) {
+            if (tagValue >= layer->values.size()) {
+                throw std::runtime_error("feature referenced out of range value");
+            }
+            optional<Value> value(parseValue(layer->values[tagValue]));
+            return value->is<NullValue>() ? nullopt : value;
+        }
+    }
+    return nullopt;
 }
 
 const PropertyMap& VectorTileFeature::getProperties() const {
     if (!properties) {
-        properties = feature.getProperties();
+        properties = PropertyMap();
+        for (auto it = tags.begin(); it != tags.end();) {
+            const uint32_t tagKey = *it++;
+            if (it == tags.end()) {
+                throw std::runtime_error("uneven number of feature tag ids");
+            }
+            const uint32_t tagValue = *it++;
+            if (tagKey >= layer->keys.size() || tagValue >= layer->values.size()) {
+                throw std::runtime_error("feature referenced out of range key or value");
+            }
+            properties->emplace(layer->keys[tagKey], parseValue(layer->values[tagValue]));
+        }
     }
     return *properties;
 }
 
 FeatureIdentifier VectorTileFeature::getID() const {
-    return feature.getID();
+    if (id) {
+        return *id;
+    }
+    return NullValue();
 }
 
 const GeometryCollection& VectorTileFeature::getGeometries() const {
     if (!lines) {
-        const float scale = float(util::EXTENT) / feature.getExtent();
-        lines = feature.getGeometries<GeometryCollection>(scale);
-        if (feature.getVersion() < 2 && feature.getType() == mapbox::vector_tile::GeomType::POLYGON) {
-            lines = fixupPolygons(*lines);
+        lines = layer->getCachedGeometries(index);
+        if (!lines) {
+            lines = std::make_shared<const GeometryCollection>(decodeGeometries());
+            layer->cacheGeometries(index, lines);
         }
     }
     return *lines;
 }
 
+GeometryCollection VectorTileFeature::decodeGeometries() const {
+    const float scale = float(util::EXTENT) / layer->extent;
+
+    GeometryCollection paths;
+    paths.emplace_back();
+
+    // Parameters of a LineTo command are decoded in chunks, so that runs of vertices can be
+    // converted with SIMD instructions.
+    constexpr std::size_t chunkSize = 128;
+    uint32_t parameters[2 * chunkSize];
+    Point<int32_t> cursor { 0, 0 };
+
+    const char* it = geometry.data();
+    const char* const end = it + geometry.size();
+
+    while (it != end) {
+        const auto commandInteger = static_cast<uint32_t>(protozero::decode_varint(&it, end));
+        const uint32_t command = commandInteger & 0x7;
+        uint32_t length = commandInteger >> 3;
+
+        if (command == CommandMoveTo) {
+            for (; length > 0; --length) {
+                if (!paths.back().empty()) {
+                    paths.emplace_back();
+                }
+                decodeGeometryVarints(it, end, parameters, 2);
+                appendGeometryDeltasScalar(parameters, 1, cursor, scale, paths.back());
+            }
+        } else if (command == CommandLineTo) {
+            auto& path = paths.back();
+            path.reserve(path.size() + length + (type == GeomTypePolygon ? 1 : 0));
+            while (length > 0) {
+                const std::size_t count = std::min<std::size_t>(length, chunkSize);
+                decodeGeometryVarints(it, end, parameters, 2 * count);
+                appendGeometryDeltas(parameters, count, cursor, scale, path);
+                length -= count;
+            }
+        } else if (command == CommandClosePath) {
+            if (length != 1) {
+                throw std::runtime_error("ClosePath command count is not 1");
+            }
+            if (!paths.back().empty()) {
+                paths.back().push_back(paths.back()[0]);
+            }
+        } else {
+            throw std::runtime_error("unknown command");
+        }
+    }
+
+    if (layer->version < 2 && type == GeomTypePolygon) {
+        return fixupPolygons(paths);
+    }
+    return paths;
+}
+
 VectorTileLayer::VectorTileLayer(std::shared_ptr<const std::string> data_,
                                  const protozero::data_view& view)
-    : data(std::move(data_)), layer(view) {
+    : VectorTileLayer(std::make_shared<VectorTileLayerData>(std::move(data_), view)) {
+}
+
+VectorTileLayer::VectorTileLayer(std::shared_ptr<VectorTileLayerData> layerData_)
+    : layerData(std::move(layerData_)) {
+    ++layerData->consumers;
+}
+
+VectorTileLayer::~VectorTileLayer() {
+    layerData->removeConsumer();
 }
 
 std::size_t VectorTileLayer::featureCount() const {
-    return layer.featureCount();
+    return layerData->features.size();
 }
 
 std::unique_ptr<GeometryTileFeature> VectorTileLayer::getFeature(std::size_t i) const {
-    return std::make_unique<VectorTileFeature>(layer, layer.getFeature(i));
+    return std::make_unique<VectorTileFeature>(layerData, i, layerData->features.at(i));
 }
 
 std::string VectorTileLayer::getName() const {
-    return layer.getName();
+    return layerData->name;
+}
+
+optional<std::size_t> VectorTileLayer::getKeyIndex(const std::string& key) const {
+    return layerData->getKeyIndex(key);
 }
 
 VectorTileData::VectorTileData(std::shared_ptr<const std::string> data_) : data(std::move(data_)) {
@@ -81,10 +403,17 @@ std::unique_ptr<GeometryTileLayer> VectorTileData::getLayer(const std::string& n
     }
 
     auto it = layers.find(name);
-    if (it != layers.end()) {
-        return std::make_unique<VectorTileLayer>(data, it->second);
+    if (it == layers.end()) {
+        return nullptr;
+    }
+
+    std::weak_ptr<VectorTileLayerData>& weak = layerData[name];
+    std::shared_ptr<VectorTileLayerData> shared = weak.lock();
+    if (!shared) {
+        shared = std::make_shared<VectorTileLayerData>(data, it->second);
+        weak = shared;
     }
-    return nullptr;
+    return std::make_unique<VectorTileLayer>(std::move(shared));
 }
 
 std::vector<std::string> VectorTileData::layerNames() const {
@@ -9,9 +9,12 @@
 
 namespace mbgl {
 
+class VectorTileLayerData;
+
 class VectorTileFeature : public GeometryTileFeature {
 public:
-    VectorTileFeature(const mapbox::vector_tile::layer&, const protozero::data_view&);
+    VectorTileFeature(std::shared_ptr<VectorTileLayerData>, std::size_t index, const protozero::data_view&);
+    ~VectorTileFeature() override;
 
     FeatureType getType() const override;
     optional<Value> getValue(const std::string& key) const override;
@@ -19,23 +22,44 @@ public:
     FeatureIdentifier getID() const override;
     const GeometryCollection& getGeometries() const override;
 
+    // Returns the value for the key at the given position in the layer's key table. Use
+    // VectorTileLayer::getKeyIndex() to resolve a key once for all features of a layer.
+    optional<Value> getValueByKeyIndex(std::size_t keyIndex) const;
+
 private:
-    mapbox::vector_tile::feature feature;
-    mutable optional<GeometryCollection> lines;
+    using PackedIterator = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
+
+    GeometryCollection decodeGeometries() const;
+
+    // Features may outlive the layer they were read from.
+    const std::shared_ptr<VectorTileLayerData> layer;
+    const std::size_t index;
+    optional<uint64_t> id;
+    uint32_t type = 0;
+    PackedIterator tags;
+    protozero::data_view geometry;
+
+    mutable std::shared_ptr<const GeometryCollection> lines;
     mutable optional<PropertyMap> properties;
 };
 
 class VectorTileLayer : public GeometryTileLayer {
 public:
     VectorTileLayer(std::shared_ptr<const std::string> data, const protozero::data_view&);
+    VectorTileLayer(std::shared_ptr<VectorTileLayerData>);
+    VectorTileLayer(const VectorTileLayer&) = delete;
+    ~VectorTileLayer() override;
 
     std::size_t featureCount() const override;
     std::unique_ptr<GeometryTileFeature> getFeature(std::size_t i) const override;
     std::string getName() const override;
 
+    // Resolves a property key to its position in this layer's key table. The table is built
+    // once when the layer is parsed, so features only compare integer ids against their tags.
+    optional<std::size_t> getKeyIndex(const std::string& key) const;
+
 private:
-    std::shared_ptr<const std::string> data;
-    mapbox::vector_tile::layer layer;
+    std::shared_ptr<VectorTileLayerData> layerData;
 };
 
 class VectorTileData : public GeometryTileData {
@@ -51,6 +75,10 @@ private:
     std::shared_ptr<const std::string> data;
     mutable bool parsed = false;
     mutable std::map<std::string, const protozero::data_view> layers;
+
+    // Layers that are still in use. Layer groups reading the same source layer share the
+    // parsed layer and the geometries decoded from it.
+    mutable std::map<std::string, std::weak_ptr<VectorTileLayerData>> layerData;
 };
 
 } // namespace mbgl
@@ -0,0 +1,163 @@
+#include <mbgl/tile/vector_tile_geometry.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MBGL_VECTOR_TILE_GEOMETRY_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace mbgl {
+
+namespace {
+
+constexpr float minCoordinate = std::numeric_limits<GeometryCoordinate::coordinate_type>::min();
+constexpr float maxCoordinate = std::numeric_limits<GeometryCoordinate::coordinate_type>::max();
+
+inline int32_t decodeZigzag(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline int32_t wrappingAdd(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+[[noreturn]] void throwOutOfRange() {
+    throw std::runtime_error("paths outside valid range of coordinate_type");
+}
+
+[[noreturn]] void throwMissingParameter() {
+    throw std::runtime_error("geometry is missing a parameter");
+}
+
+} // namespace
+
+void decodeGeometryVarints(const char*& data, const char* end, uint32_t* out, std::size_t count) {
+    std::size_t decoded = 0;
+
+#if defined(MBGL_VECTOR_TILE_GEOMETRY_SSE2)
+    // Most geometry parameters are small deltas that fit into a single byte. Check 16 bytes at a
+    // time for continuation bits and widen runs of single byte varints without branching per value.
+    const __m128i zero = _mm_setzero_si128();
+    while (count - decoded >= 16 && end - data >= 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const int continuation = _mm_movemask_epi8(bytes);
+        if (continuation == 0) {
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            uint32_t* target = out + decoded;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 12), _mm_unpackhi_epi16(high, zero));
+            data += 16;
+            decoded += 16;
+            continue;
+        }
+
+        // Copy the single byte varints in front of the first multi byte one, then decode that.
+        int singles = 0;
+        while ((continuation & (1 << singles)) == 0) {
+            out[decoded++] = static_cast<uint8_t>(*data++);
+            ++singles;
+        }
+        out[decoded++] = static_cast<uint32_t>(protozero::decode_varint(&data, end));
+    }
+#endif
+
+    for (; decoded < count; ++decoded) {
+        if (data == end) {
+            throwMissingParameter();
+        }
+        out[decoded] = static_cast<uint32_t>(protozero::decode_varint(&data, end));
+    }
+}
+
+void appendGeometryDeltasScalar(const uint32_t* parameters,
+                                std::size_t count,
+                                Point<int32_t>& cursor,
+                                float scale,
+                                GeometryCoordinates& coordinates) {
+    for (std::size_t i = 0; i < count; ++i) {
+        cursor.x = wrappingAdd(cursor.x, decodeZigzag(parameters[2 * i]));
+        cursor.y = wrappingAdd(cursor.y, decodeZigzag(parameters[2 * i + 1]));
+
+        const float x = std::round(cursor.x * scale);
+        const float y = std::round(cursor.y * scale);
+        if (x > maxCoordinate || x < minCoordinate || y > maxCoordinate || y < minCoordinate) {
+            throwOutOfRange();
+        }
+        coordinates.emplace_back(static_cast<int16_t>(x), static_cast<int16_t>(y));
+    }
+}
+
+void appendGeometryDeltas(const uint32_t* parameters,
+                          std::size_t count,
+                          Point<int32_t>& cursor,
+                          float scale,
+                          GeometryCoordinates& coordinates) {
+#if defined(MBGL_VECTOR_TILE_GEOMETRY_SSE2)
+    static_assert(sizeof(GeometryCoordinate) == 2 * sizeof(int16_t), "GeometryCoordinate must be packed");
+
+    // Each iteration handles two points stored as interleaved (x, y) pairs in one register.
+    const std::size_t vectorCount = count & ~std::size_t(1);
+    if (vectorCount) {
+        const std::size_t offset = coordinates.size();
+        coordinates.resize(offset + vectorCount);
+        auto* target = reinterpret_cast<char*>(coordinates.data() + offset);
+
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128 scale4 = _mm_set1_ps(scale);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 unit = _mm_set1_ps(1.0f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 minimum = _mm_set1_ps(minCoordinate);
+        const __m128 maximum = _mm_set1_ps(maxCoordinate);
+        __m128i carry = _mm_set_epi32(cursor.y, cursor.x, cursor.y, cursor.x);
+
+        for (std::size_t i = 0; i < vectorCount; i += 2) {
+            const __m128i encoded = _mm_loadu_si128(reinterpret_cast<const __m128i*>(parameters + 2 * i));
+            const __m128i delta = _mm_xor_si128(_mm_srli_epi32(encoded, 1),
+                                                _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(encoded, one)));
+
+            // Prefix sum over the two points, then add the position of the previous point.
+            const __m128i position = _mm_add_epi32(_mm_add_epi32(delta, _mm_slli_si128(delta, 8)), carry);
+            carry = _mm_shuffle_epi32(position, _MM_SHUFFLE(3, 2, 3, 2));
+
+            // Round half away from zero like std::round: truncate, then step away from zero if the
+            // remainder is at least one half.
+            const __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(position), scale4);
+            const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(scaled));
+            const __m128 remainder = _mm_andnot_ps(signMask, _mm_sub_ps(scaled, truncated));
+            const __m128 step = _mm_or_ps(_mm_and_ps(scaled, signMask), unit);
+            const __m128 rounded = _mm_add_ps(truncated, _mm_and_ps(_mm_cmpge_ps(remainder, half), step));
+
+            const __m128 outside = _mm_or_ps(_mm_cmplt_ps(rounded, minimum), _mm_cmpgt_ps(rounded, maximum));
+            if (_mm_movemask_ps(outside)) {
+                coordinates.resize(offset + i);
+                throwOutOfRange();
+            }
+
+            const __m128i packed = _mm_cvttps_epi32(rounded);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(target + i * sizeof(GeometryCoordinate)),
+                             _mm_packs_epi32(packed, packed));
+        }
+
+        int32_t last[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(last), carry);
+        cursor.x = last[0];
+        cursor.y = last[1];
+    }
+
+    appendGeometryDeltasScalar(parameters + 2 * vectorCount, count - vectorCount, cursor, scale, coordinates);
+#else
+    appendGeometryDeltasScalar(parameters, count, cursor, scale, coordinates);
+#endif
+}
+
+} // namespace mbgl
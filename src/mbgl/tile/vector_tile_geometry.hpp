@@ -0,0 +1,34 @@
+#pragma once
+
+#include <mbgl/tile/geometry_tile_data.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mbgl {
+
+// Helpers for decoding the command stream of a vector tile feature geometry. Where the target
+// supports it, runs of values are decoded with SIMD instructions; otherwise, and for the tails of
+// runs, the scalar implementation is used.
+
+// Decodes `count` varints from the packed buffer at `data` into `out`, advancing `data` past them.
+// Values are truncated to 32 bits. Throws if the buffer ends before `count` values are read.
+void decodeGeometryVarints(const char*& data, const char* end, uint32_t* out, std::size_t count);
+
+// Zigzag-decodes `count` (dx, dy) parameter pairs, adds each one to `cursor`, and appends the
+// cursor multiplied by `scale` and rounded to `coordinates`. Throws if a resulting coordinate does
+// not fit into GeometryCoordinate.
+void appendGeometryDeltas(const uint32_t* parameters,
+                          std::size_t count,
+                          Point<int32_t>& cursor,
+                          float scale,
+                          GeometryCoordinates& coordinates);
+
+// Scalar implementation of appendGeometryDeltas(), used as the reference for the SIMD path.
+void appendGeometryDeltasScalar(const uint32_t* parameters,
+                                std::size_t count,
+                                Point<int32_t>& cursor,
+                                float scale,
+                                GeometryCoordinates& coordinates);
+
+} // namespace mbgl
@@ -2,7 +2,7 @@
 #include <mbgl/geometry/feature_index.hpp>
 #include <mbgl/math/minmax.hpp>
 
-#include <unordered_set>
+#include <cassert>
 #include <cmath>
 
 namespace mbgl {
@@ -25,52 +25,62 @@ GridIndex<T>::GridIndex(const float width_, const float height_, const uint32_t
 
 template <class T>
 void GridIndex<T>::insert(T&& t, const BBox& bbox) {
-    size_t uid = boxElements.size();
+    auto uid = static_cast<uint32_t>(boxItems.size());
 
-    auto cx1 = convertToXCellCoord(bbox.min.x);
-    auto cy1 = convertToYCellCoord(bbox.min.y);
-    auto cx2 = convertToXCellCoord(bbox.max.x);
-    auto cy2 = convertToYCellCoord(bbox.max.y);
+    const CellRange range = convertToCellRange(bbox);
+    insertIntoCells(boxCells, range, uid);
 
-    std::size_t x;
-    std::size_t y;
-    std::size_t cellIndex;
-    for (x = cx1; x <= cx2; ++x) {
-        for (y = cy1; y <= cy2; ++y) {
-            cellIndex = xCellCount * y + x;
-            boxCells[cellIndex].push_back(uid);
-        }
-    }
-
-    boxElements.emplace_back(t, bbox);
+    boxItems.push_back(std::move(t));
+    boxes.push_back(packBox(bbox));
+    boxFirstCells.push_back({static_cast<uint32_t>(range.x1), static_cast<uint32_t>(range.y1)});
 }
 
 template <class T>
 void GridIndex<T>::insert(T&& t, const BCircle& bcircle) {
-    size_t uid = circleElements.size();
+    auto uid = static_cast<uint32_t>(circleItems.size());
 
-    auto cx1 = convertToXCellCoord(bcircle.center.x - bcircle.radius);
-    auto cy1 = convertToYCellCoord(bcircle.center.y - bcircle.radius);
-    auto cx2 = convertToXCellCoord(bcircle.center.x + bcircle.radius);
-    auto cy2 = convertToYCellCoord(bcircle.center.y + bcircle.radius);
+    const CellRange range = convertToCellRange(convertToBox(bcircle));
+    insertIntoCells(circleCells, range, uid);
 
-    std::size_t x;
-    std::size_t y;
-    std::size_t cellIndex;
-    for (x = cx1; x <= cx2; ++x) {
-        for (y = cy1; y <= cy2; ++y) {
-            cellIndex = xCellCount * y + x;
-            circleCells[cellIndex].push_back(uid);
+    circleItems.push_back(std::move(t));
+    circles.push_back(bcircle);
+    circleFirstCells.push_back({static_cast<uint32_t>(range.x1), static_cast<uint32_t>(range.y1)});
+}
+
+template <class T>
+void GridIndex<T>::insertIntoCells(std::vector<Cell>& cells, const CellRange& range, const uint32_t item) {
+    for (std::size_t x = range.x1; x <= range.x2; ++x) {
+        for (std::size_t y = range.y1; y <= range.y2; ++y) {
+            // Entries are appended to the end of the cell's list, so that queries see the items of
+            // a cell in insertion order.
+            Cell& cell = cells[xCellCount * y + x];
+            const auto entry = static_cast<uint32_t>(cellEntries.size());
+            cellEntries.push_back({item, kNone});
+            if (cell.last == kNone) {
+                cell.first = entry;
+            } else {
+                cellEntries[cell.last].next = entry;
+            }
+            cell.last = entry;
         }
     }
+}
 
-    circleElements.emplace_back(t, bcircle);
+template <class T>
+void GridIndex<T>::reserve(const GridIndex& other) {
+    boxItems.reserve(other.boxItems.size());
+    boxes.reserve(other.boxes.size());
+    boxFirstCells.reserve(other.boxFirstCells.size());
+    circleItems.reserve(other.circleItems.size());
+    circles.reserve(other.circles.size());
+    circleFirstCells.reserve(other.circleFirstCells.size());
+    cellEntries.reserve(other.cellEntries.size());
 }
 
 template <class T>
 std::vector<T> GridIndex<T>::query(const BBox& queryBBox) const {
     std::vector<T> result;
-    query(queryBBox, [&](const T& t, const BBox&) -> bool {
+    query(queryBBox, [&](const T& t, const auto&) -> bool {
         result.push_back(t);
         return false;
     });
@@ -80,41 +90,13 @@ std::vector<T> GridIndex<T>::query(const BBox& queryBBox) const {
 template <class T>
 std::vector<std::pair<T, typename GridIndex<T>::BBox>> GridIndex<T>::queryWithBoxes(const BBox& queryBBox) const {
     std::vector<std::pair<T, BBox>> result;
-    query(queryBBox, [&](const T& t, const BBox& bbox) -> bool {
-        result.push_back(std::make_pair(t, bbox));
+    query(queryBBox, [&](const T& t, const auto& getBBox) -> bool {
+        result.push_back(std::make_pair(t, getBBox()));
         return false;
     });
     return result;
 }
 
-template <class T>
-bool GridIndex<T>::hitTest(const BBox& queryBBox, optional<std::function<bool(const T&)>> predicate) const {
-    bool hit = false;
-    query(queryBBox, [&](const T& t, const BBox&) -> bool {
-        if (!predicate || (*predicate)(t)) {
-            hit = true;
-            return true;
-        } else {
-            return false;
-        }
-    });
-    return hit;
-}
-
-template <class T>
-bool GridIndex<T>::hitTest(const BCircle& queryBCircle, optional<std::function<bool(const T&)>> predicate) const {
-    bool hit = false;
-    query(queryBCircle, [&](const T& t, const BBox&) -> bool {
-        if (!predicate || (*predicate)(t)) {
-            hit = true;
-            return true;
-        } else {
-            return false;
-        }
-    });
-    return hit;
-}
-
 template <class T>
 bool GridIndex<T>::noIntersection(const BBox& queryBBox) const {
     return queryBBox.max.x < 0 || queryBBox.min.x >= width || queryBBox.max.y < 0 || queryBBox.min.y >= height;
@@ -132,133 +114,11 @@ typename GridIndex<T>::BBox GridIndex<T>::convertToBox(const BCircle& circle) co
 }
 
 template <class T>
-void GridIndex<T>::query(const BBox& queryBBox, std::function<bool (const T&, const BBox&)> resultFn) const {
-    std::unordered_set<size_t> seenBoxes;
-    std::unordered_set<size_t> seenCircles;
-    
-    if (noIntersection(queryBBox)) {
-        return;
-    } else if (completeIntersection(queryBBox)) {
-        for (auto& element : boxElements) {
-            if (resultFn(element.first, element.second)) {
-                return;
-            }
-        }
-        for (auto& element : circleElements) {
-            if (resultFn(element.first, convertToBox(element.second))) {
-                return;
-            }
-        }
-        return;
-    }
-
-    auto cx1 = convertToXCellCoord(queryBBox.min.x);
-    auto cy1 = convertToYCellCoord(queryBBox.min.y);
-    auto cx2 = convertToXCellCoord(queryBBox.max.x);
-    auto cy2 = convertToYCellCoord(queryBBox.max.y);
-
-    std::size_t x;
-    std::size_t y;
-    std::size_t cellIndex;
-    for (x = cx1; x <= cx2; ++x) {
-        for (y = cy1; y <= cy2; ++y) {
-            cellIndex = xCellCount * y + x;
-            // Look up other boxes
-            for (auto uid : boxCells[cellIndex]) {
-                if (seenBoxes.count(uid) == 0) {
-                    seenBoxes.insert(uid);
-
-                    auto& pair = boxElements.at(uid);
-                    auto& bbox = pair.second;
-                    if (boxesCollide(queryBBox, bbox)) {
-                        if (resultFn(pair.first, bbox)) {
-                            return;
-                        }
-                    }
-                }
-            }
-            
-            // Look up circles
-            for (auto uid : circleCells[cellIndex]) {
-                if (seenCircles.count(uid) == 0) {
-                    seenCircles.insert(uid);
-
-                    auto& pair = circleElements.at(uid);
-                    auto& bcircle = pair.second;
-                    if (circleAndBoxCollide(bcircle, queryBBox)) {
-                        if (resultFn(pair.first, convertToBox(bcircle))) {
-                            return;
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-template <class T>
-void GridIndex<T>::query(const BCircle& queryBCircle, std::function<bool (const T&, const BBox&)> resultFn) const {
-    std::unordered_set<size_t> seenBoxes;
-    std::unordered_set<size_t> seenCircles;
-
-    BBox queryBBox = convertToBox(queryBCircle);
-    if (noIntersection(queryBBox)) {
-        return;
-    } else if (completeIntersection(queryBBox)) {
-        for (auto& element : boxElements) {
-            if (resultFn(element.first, element.second)) {
-                return;
-            }
-        }
-        for (auto& element : circleElements) {
-            if (resultFn(element.first, convertToBox(element.second))) {
-                return;
-            }
-        }
-    }
-
-    auto cx1 = convertToXCellCoord(queryBCircle.center.x - queryBCircle.radius);
-    auto cy1 = convertToYCellCoord(queryBCircle.center.y - queryBCircle.radius);
-    auto cx2 = convertToXCellCoord(queryBCircle.center.x + queryBCircle.radius);
-    auto cy2 = convertToYCellCoord(queryBCircle.center.y + queryBCircle.radius);
-
-    std::size_t x;
-    std::size_t y;
-    std::size_t cellIndex;
-    for (x = cx1; x <= cx2; ++x) {
-        for (y = cy1; y <= cy2; ++y) {
-            cellIndex = xCellCount * y + x;
-            // Look up boxes
-            for (auto uid : boxCells[cellIndex]) {
-                if (seenBoxes.count(uid) == 0) {
-                    seenBoxes.insert(uid);
-
-                    auto& pair = boxElements.at(uid);
-                    auto& bbox = pair.second;
-                    if (circleAndBoxCollide(queryBCircle, bbox)) {
-                        if (resultFn(pair.first, bbox)) {
-                            return;
-                        }
-                    }
-                }
-            }
-            
-            // Look up other circles
-            for (auto uid : circleCells[cellIndex]) {
-                if (seenCircles.count(uid) == 0) {
-                    seenCircles.insert(uid);
-
-                    auto& pair = circleElements.at(uid);
-                    auto& bcircle = pair.second;
-                    if (circlesCollide(queryBCircle, bcircle)) {
-                        if (resultFn(pair.first, convertToBox(bcircle))) {
-                            return;
-                        }
-                    }
-                }
-            }
-        }
-    }
+typename GridIndex<T>::CellRange GridIndex<T>::convertToCellRange(const BBox& bbox) const {
+    return CellRange{convertToXCellCoord(bbox.min.x),
+                     convertToYCellCoord(bbox.min.y),
+                     convertToXCellCoord(bbox.max.x),
+                     convertToYCellCoord(bbox.max.y)};
 }
 
 template <class T>
@@ -271,14 +131,6 @@ std::size_t GridIndex<T>::convertToYCellCoord(const float y) const {
     return util::max(0.0, util::min(yCellCount - 1.0, std::floor(y * yScale)));
 }
 
-template <class T>
-bool GridIndex<T>::boxesCollide(const BBox& first, const BBox& second) const {
-	return first.min.x <= second.max.x &&
-           first.min.y <= second.max.y &&
-           first.max.x >= second.min.x &&
-           first.max.y >= second.min.y;
-}
-
 template <class T>
 bool GridIndex<T>::circlesCollide(const BCircle& first, const BCircle& second) const {
     auto dx = second.center.x - first.center.x;
@@ -312,9 +164,16 @@ bool GridIndex<T>::circleAndBoxCollide(const BCircle& circle, const BBox& box) c
 
 template <class T>
 bool GridIndex<T>::empty() const {
-    return boxElements.empty() && circleElements.empty();
+    return boxItems.empty() && circleItems.empty();
 }
 
+template <class T>
+std::size_t GridIndex<T>::getMemoryUsage() const {
+    return boxItems.capacity() * sizeof(T) + boxes.capacity() * sizeof(PackedBox) +
+           boxFirstCells.capacity() * sizeof(CellCoordinates) + circleItems.capacity() * sizeof(T) +
+           circles.capacity() * sizeof(BCircle) + circleFirstCells.capacity() * sizeof(CellCoordinates) +
+           (boxCells.capacity() + circleCells.capacity()) * sizeof(Cell) + cellEntries.capacity() * sizeof(CellEntry);
+}
 
 template class GridIndex<IndexedSubfeature>;
 
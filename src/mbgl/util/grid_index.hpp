@@ -4,11 +4,19 @@
 #include <mapbox/geometry/box.hpp>
 #include <mbgl/util/optional.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstddef>
+#include <limits>
 #include <vector>
 #include <functional>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MBGL_GRID_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace mbgl {
 
 namespace geometry {
@@ -51,6 +59,12 @@ constexpr bool operator!=(circle<T> const& lhs, circle<T> const& rhs)
  at least one cell. As long as the geometries are relatively
  uniformly distributed across the plane, this greatly reduces
  the number of comparisons necessary.
+
+ The cell lists are linked lists of entries in a single arena, so
+ that inserting doesn't allocate per cell, and queries don't need
+ to keep track of the items they have already seen: an item that
+ spans several cells is only reported in the first of them that
+ the query visits.
 */
 
 template <class T>
@@ -63,44 +77,282 @@ public:
 
     void insert(T&& t, const BBox&);
     void insert(T&& t, const BCircle&);
-    
+
+    // Reserves room for as many items as `other` holds, e.g. when the
+    // index is rebuilt for a slightly different view.
+    void reserve(const GridIndex& other);
+
     std::vector<T> query(const BBox&) const;
     std::vector<std::pair<T,BBox>> queryWithBoxes(const BBox&) const;
-    
-    bool hitTest(const BBox&, optional<std::function<bool(const T&)>> predicate = nullopt) const;
-    bool hitTest(const BCircle&, optional<std::function<bool(const T&)>> predicate = nullopt) const;
-    
+
+    bool hitTest(const BBox& bbox) const {
+        return hitTest(bbox, [](const T&) { return true; });
+    }
+    bool hitTest(const BCircle& bcircle) const {
+        return hitTest(bcircle, [](const T&) { return true; });
+    }
+
+    // Returns whether any item that intersects with the query geometry matches the predicate.
+    template <typename Predicate>
+    bool hitTest(const BBox&, Predicate&& predicate) const;
+    template <typename Predicate>
+    bool hitTest(const BCircle&, Predicate&& predicate) const;
+
+    // Calls the function with every item and its bounding box, in the order a query covering the
+    // whole index returns them. The function may move the items out, e.g. to merge the index into
+    // another one.
+    template <typename Fn>
+    void forEach(Fn&& fn);
+
     bool empty() const;
 
+    // Returns an estimate of the bytes retained by the index.
+    std::size_t getMemoryUsage() const;
+
 private:
+    // A box stored as {min.x, min.y, -max.x, -max.y}. A box collides with a query box, stored as
+    // {max.x, max.y, -min.x, -min.y}, if all of its components are less than or equal.
+    using PackedBox = std::array<float, 4>;
+
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    struct CellEntry {
+        uint32_t item;
+        uint32_t next;
+    };
+
+    struct Cell {
+        uint32_t first = kNone;
+        uint32_t last = kNone;
+    };
+
+    struct CellRange {
+        std::size_t x1;
+        std::size_t y1;
+        std::size_t x2;
+        std::size_t y2;
+    };
+
+    // First cell of an item, used to report items that span several cells only once.
+    struct CellCoordinates {
+        uint32_t x;
+        uint32_t y;
+    };
+
     bool noIntersection(const BBox& queryBBox) const;
     bool completeIntersection(const BBox& queryBBox) const;
     BBox convertToBox(const BCircle& circle) const;
+    CellRange convertToCellRange(const BBox&) const;
 
-    void query(const BBox&, std::function<bool (const T&, const BBox&)>) const;
-    void query(const BCircle&, std::function<bool (const T&, const BBox&)>) const;
+    template <typename ResultFn>
+    void query(const BBox&, ResultFn&&) const;
+    template <typename ResultFn>
+    void query(const BCircle&, ResultFn&&) const;
+    template <typename ResultFn>
+    bool queryAll(ResultFn&&) const;
+
+    void insertIntoCells(std::vector<Cell>&, const CellRange&, uint32_t item);
 
     std::size_t convertToXCellCoord(float x) const;
     std::size_t convertToYCellCoord(float y) const;
 
-    bool boxesCollide(const BBox&, const BBox&) const;
+    static PackedBox packBox(const BBox&);
+    static PackedBox packQueryBox(const BBox&);
+    static BBox unpackBox(const PackedBox&);
+    static bool boxesCollide(const PackedBox& box, const PackedBox& queryBox);
     bool circlesCollide(const BCircle&, const BCircle&) const;
     bool circleAndBoxCollide(const BCircle&, const BBox&) const;
 
     const float width;
     const float height;
-    
+
     const std::size_t xCellCount;
     const std::size_t yCellCount;
     const double xScale;
     const double yScale;
 
-    std::vector<std::pair<T, BBox>> boxElements;
-    std::vector<std::pair<T, BCircle>> circleElements;
-    
-    std::vector<std::vector<size_t>> boxCells;
-    std::vector<std::vector<size_t>> circleCells;
+    std::vector<T> boxItems;
+    std::vector<PackedBox> boxes;
+    std::vector<CellCoordinates> boxFirstCells;
 
+    std::vector<T> circleItems;
+    std::vector<BCircle> circles;
+    std::vector<CellCoordinates> circleFirstCells;
+
+    std::vector<Cell> boxCells;
+    std::vector<Cell> circleCells;
+    std::vector<CellEntry> cellEntries;
 };
 
+template <class T>
+inline typename GridIndex<T>::PackedBox GridIndex<T>::packBox(const BBox& bbox) {
+    return {{bbox.min.x, bbox.min.y, -bbox.max.x, -bbox.max.y}};
+}
+
+template <class T>
+inline typename GridIndex<T>::PackedBox GridIndex<T>::packQueryBox(const BBox& bbox) {
+    return {{bbox.max.x, bbox.max.y, -bbox.min.x, -bbox.min.y}};
+}
+
+template <class T>
+inline typename GridIndex<T>::BBox GridIndex<T>::unpackBox(const PackedBox& box) {
+    return BBox{{box[0], box[1]}, {-box[2], -box[3]}};
+}
+
+template <class T>
+inline bool GridIndex<T>::boxesCollide(const PackedBox& box, const PackedBox& queryBox) {
+#if defined(MBGL_GRID_INDEX_SSE2)
+    return _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(box.data()), _mm_loadu_ps(queryBox.data()))) == 0xF;
+#else
+    return box[0] <= queryBox[0] && box[1] <= queryBox[1] && box[2] <= queryBox[2] && box[3] <= queryBox[3];
+#endif
+}
+
+template <class T>
+template <typename Predicate>
+bool GridIndex<T>::hitTest(const BBox& queryBBox, Predicate&& predicate) const {
+    bool hit = false;
+    query(queryBBox, [&](const T& t, const auto&) -> bool {
+        hit = predicate(t);
+        return hit;
+    });
+    return hit;
+}
+
+template <class T>
+template <typename Predicate>
+bool GridIndex<T>::hitTest(const BCircle& queryBCircle, Predicate&& predicate) const {
+    bool hit = false;
+    query(queryBCircle, [&](const T& t, const auto&) -> bool {
+        hit = predicate(t);
+        return hit;
+    });
+    return hit;
+}
+
+template <class T>
+template <typename Fn>
+void GridIndex<T>::forEach(Fn&& fn) {
+    for (std::size_t i = 0; i < boxItems.size(); ++i) {
+        fn(boxItems[i], unpackBox(boxes[i]));
+    }
+    for (std::size_t i = 0; i < circleItems.size(); ++i) {
+        fn(circleItems[i], convertToBox(circles[i]));
+    }
+}
+
+// The result functions are called with an item and a getter for its bounding box, which is
+// only evaluated when needed. They return `true` to stop the query.
+template <class T>
+template <typename ResultFn>
+bool GridIndex<T>::queryAll(ResultFn&& resultFn) const {
+    for (std::size_t i = 0; i < boxItems.size(); ++i) {
+        if (resultFn(boxItems[i], [&] { return unpackBox(boxes[i]); })) {
+            return true;
+        }
+    }
+    for (std::size_t i = 0; i < circleItems.size(); ++i) {
+        if (resultFn(circleItems[i], [&] { return convertToBox(circles[i]); })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class T>
+template <typename ResultFn>
+void GridIndex<T>::query(const BBox& queryBBox, ResultFn&& resultFn) const {
+    if (noIntersection(queryBBox)) {
+        return;
+    } else if (completeIntersection(queryBBox)) {
+        queryAll(resultFn);
+        return;
+    }
+
+    const PackedBox packedQueryBox = packQueryBox(queryBBox);
+    const CellRange range = convertToCellRange(queryBBox);
+    for (std::size_t x = range.x1; x <= range.x2; ++x) {
+        for (std::size_t y = range.y1; y <= range.y2; ++y) {
+            const std::size_t cellIndex = xCellCount * y + x;
+            // Look up other boxes
+            for (uint32_t entry = boxCells[cellIndex].first; entry != kNone; entry = cellEntries[entry].next) {
+                const uint32_t uid = cellEntries[entry].item;
+                const CellCoordinates& first = boxFirstCells[uid];
+                if (x != std::max<std::size_t>(first.x, range.x1) || y != std::max<std::size_t>(first.y, range.y1)) {
+                    continue; // Already visited in a previous cell.
+                }
+                const PackedBox& box = boxes[uid];
+                if (boxesCollide(box, packedQueryBox)) {
+                    if (resultFn(boxItems[uid], [&] { return unpackBox(box); })) {
+                        return;
+                    }
+                }
+            }
+
+            // Look up circles
+            for (uint32_t entry = circleCells[cellIndex].first; entry != kNone; entry = cellEntries[entry].next) {
+                const uint32_t uid = cellEntries[entry].item;
+                const CellCoordinates& first = circleFirstCells[uid];
+                if (x != std::max<std::size_t>(first.x, range.x1) || y != std::max<std::size_t>(first.y, range.y1)) {
+                    continue;
+                }
+                const BCircle& bcircle = circles[uid];
+                if (circleAndBoxCollide(bcircle, queryBBox)) {
+                    if (resultFn(circleItems[uid], [&] { return convertToBox(bcircle); })) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+template <typename ResultFn>
+void GridIndex<T>::query(const BCircle& queryBCircle, ResultFn&& resultFn) const {
+    const BBox queryBBox = convertToBox(queryBCircle);
+    if (noIntersection(queryBBox)) {
+        return;
+    } else if (completeIntersection(queryBBox)) {
+        queryAll(resultFn);
+        return;
+    }
+
+    const CellRange range = convertToCellRange(queryBBox);
+    for (std::size_t x = range.x1; x <= range.x2; ++x) {
+        for (std::size_t y = range.y1; y <= range.y2; ++y) {
+            const std::size_t cellIndex = xCellCount * y + x;
+            // Look up boxes
+            for (uint32_t entry = boxCells[cellIndex].first; entry != kNone; entry = cellEntries[entry].next) {
+                const uint32_t uid = cellEntries[entry].item;
+                const CellCoordinates& first = boxFirstCells[uid];
+                if (x != std::max<std::size_t>(first.x, range.x1) || y != std::max<std::size_t>(first.y, range.y1)) {
+                    continue; // Already visited in a previous cell.
+                }
+                const BBox bbox = unpackBox(boxes[uid]);
+                if (circleAndBoxCollide(queryBCircle, bbox)) {
+                    if (resultFn(boxItems[uid], [&] { return bbox; })) {
+                        return;
+                    }
+                }
+            }
+
+            // Look up other circles
+            for (uint32_t entry = circleCells[cellIndex].first; entry != kNone; entry = cellEntries[entry].next) {
+                const uint32_t uid = cellEntries[entry].item;
+                const CellCoordinates& first = circleFirstCells[uid];
+                if (x != std::max<std::size_t>(first.x, range.x1) || y != std::max<std::size_t>(first.y, range.y1)) {
+                    continue;
+                }
+                const BCircle& bcircle = circles[uid];
+                if (circlesCollide(queryBCircle, bcircle)) {
+                    if (resultFn(circleItems[uid], [&] { return convertToBox(bcircle); })) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace mbgl
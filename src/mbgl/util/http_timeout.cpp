@@ -7,6 +7,14 @@
 namespace mbgl {
 namespace http {
 
+namespace {
+
+// Bounds of the random delay added to the revalidation of resources the requester already has.
+constexpr Duration REVALIDATION_JITTER_MIN = Milliseconds(500);
+constexpr Duration REVALIDATION_JITTER_MAX = Seconds(30);
+
+} // namespace
+
 Duration errorRetryTimeout(Response::Error::Reason failedRequestReason, uint32_t failedRequests, optional<Timestamp> retryAfter) {
 
     if (failedRequestReason == Response::Error::Reason::Server) {
@@ -39,5 +47,9 @@ Duration expirationTimeout(optional<Timestamp> expires, uint32_t expiredRequests
     return Duration::max();
 }
 
+Duration revalidationJitterWindow(Duration timeout) {
+    return std::min(std::max(timeout / 8, REVALIDATION_JITTER_MIN), REVALIDATION_JITTER_MAX);
+}
+
 } // namespace http
 } // namespace mbgl
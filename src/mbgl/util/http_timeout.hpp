@@ -11,5 +11,8 @@ Duration errorRetryTimeout(Response::Error::Reason failedRequestReason, uint32_t
 
 Duration expirationTimeout(optional<Timestamp> expires, uint32_t expiredRequests);
 
+// Returns the longest random delay to add to a revalidation that is due after `timeout`.
+Duration revalidationJitterWindow(Duration timeout);
+
 } // namespace http
 } // namespace mbgl
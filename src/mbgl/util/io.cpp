@@ -24,12 +24,37 @@ void write_file(const std::string &filename, const std::string &data) {
     }
 }
 
+namespace {
+
+// Reads the rest of the stream. When the size is known, the result is allocated once and the file is
+// read straight into it instead of going through a growing stringstream buffer and a second copy.
+// Pseudo-files, e.g. in procfs, report a size of zero and are read in chunks until the end.
+std::string readStream(std::ifstream& file) {
+    const std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff end = file.tellg();
+    file.seekg(start);
+
+    if (start >= 0 && end > start && file.good()) {
+        std::string data(static_cast<std::size_t>(end - start), '\0');
+        if (file.read(&data[0], end - start)) {
+            return data;
+        }
+        file.clear();
+        file.seekg(start);
+    }
+
+    std::stringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+} // namespace
+
 std::string read_file(const std::string &filename) {
     std::ifstream file(filename, std::ios::binary);
     if (file.good()) {
-        std::stringstream data;
-        data << file.rdbuf();
-        return data.str();
+        return readStream(file);
     } else {
         throw std::runtime_error(std::string("Cannot read file ") + filename);
     }
@@ -38,9 +63,7 @@ std::string read_file(const std::string &filename) {
 optional<std::string> readFile(const std::string &filename) {
     std::ifstream file(filename, std::ios::binary);
     if (file.good()) {
-        std::stringstream data;
-        data << file.rdbuf();
-        return data.str();
+        return readStream(file);
     }
     return {};
 }
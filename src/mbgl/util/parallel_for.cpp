@@ -0,0 +1,76 @@
+#include <mbgl/util/parallel_for.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace mbgl {
+namespace util {
+
+namespace {
+
+// Shared with the scheduled tasks, which may start running only after
+// parallelFor() has returned; they won't call `fn` in that case.
+struct ParallelForState {
+    ParallelForState(std::size_t count_, const std::function<void(std::size_t)>& fn_) : count(count_), fn(fn_) {}
+
+    // Runs calls until there are none left to start.
+    void run() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+
+            if (++completed == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+    }
+
+    const std::size_t count;
+    const std::function<void(std::size_t)> fn;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> completed{0};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr exception;
+};
+
+} // namespace
+
+void parallelFor(Scheduler& scheduler,
+                 std::size_t count,
+                 std::size_t maxConcurrency,
+                 TaskPriority priority,
+                 const std::function<void(std::size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(count, fn);
+    const std::size_t helpers = std::min(count, std::max<std::size_t>(maxConcurrency, 1u)) - 1;
+    for (std::size_t i = 0; i < helpers; ++i) {
+        scheduler.scheduleWithPriority(priority, [state] { state->run(); });
+    }
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->completed == count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
+
+} // namespace util
+} // namespace mbgl
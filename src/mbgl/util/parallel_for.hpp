@@ -0,0 +1,25 @@
+#pragma once
+
+#include <mbgl/actor/scheduler.hpp>
+
+#include <cstddef>
+#include <functional>
+
+namespace mbgl {
+namespace util {
+
+// Calls `fn(i)` for every `i` in [0, count), distributing the calls over the calling
+// thread and up to `maxConcurrency - 1` tasks scheduled to `scheduler` with the given
+// priority, which should be the one of the caller's own work. Returns once all of the
+// calls have completed, rethrowing the first exception thrown by `fn`.
+//
+// The calling thread takes part in the work and never waits for a call that hasn't
+// been started yet, so it is safe to use from a task running on `scheduler` itself.
+void parallelFor(Scheduler& scheduler,
+                 std::size_t count,
+                 std::size_t maxConcurrency,
+                 TaskPriority priority,
+                 const std::function<void(std::size_t)>& fn);
+
+} // namespace util
+} // namespace mbgl
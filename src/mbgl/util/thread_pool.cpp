@@ -2,58 +2,249 @@
 
 #include <mbgl/platform/settings.hpp>
 #include <mbgl/platform/thread.hpp>
+#include <mbgl/util/optional.hpp>
 #include <mbgl/util/platform.hpp>
 #include <mbgl/util/string.hpp>
 
+#include <algorithm>
+
 namespace mbgl {
 
-ThreadedSchedulerBase::~ThreadedSchedulerBase() = default;
+ThreadedSchedulerBase::ThreadedSchedulerBase(std::size_t minThreads_, std::size_t maxThreads, Duration idleTimeout_)
+    : minThreads(minThreads_), idleTimeout(idleTimeout_), threads(maxThreads), active(maxThreads) {
+    assert(minThreads > 0);
+    assert(minThreads <= maxThreads);
+    queues.reserve(maxThreads);
+    for (std::size_t i = 0u; i < maxThreads; ++i) {
+        queues.emplace_back(std::make_unique<WorkQueue>());
+        active[i] = false;
+    }
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    for (std::size_t i = 0u; i < minThreads; ++i) {
+        startThread();
+    }
+}
+
+ThreadedSchedulerBase::~ThreadedSchedulerBase() {
+    assert(terminated);
+}
 
 void ThreadedSchedulerBase::terminate() {
     {
-        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        std::lock_guard<std::mutex> sleepLock(mutex);
         terminated = true;
     }
     cv.notify_all();
-}
 
-std::thread ThreadedSchedulerBase::makeSchedulerThread(size_t index) {
-    return std::thread([this, index] {
-        auto& settings = platform::Settings::getInstance();
-        auto value = settings.get(platform::EXPERIMENTAL_THREAD_PRIORITY_WORKER);
-        if (auto* priority = value.getDouble()) {
-            platform::setCurrentThreadPriority(*priority);
+    // No threads are started or reassigned after termination, so the thread
+    // objects can be joined without holding the lock exiting workers need.
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            assert(std::this_thread::get_id() != thread.get_id());
+            thread.join();
         }
+    }
+}
+
+// Must be called with threadsMutex held.
+void ThreadedSchedulerBase::startThread() {
+    if (terminated) {
+        return;
+    }
 
-        platform::setCurrentThreadName(std::string{"Worker "} + util::toString(index + 1));
-        platform::attachThread();
+    auto slot = std::find(active.begin(), active.end(), false);
+    if (slot == active.end()) {
+        return;
+    }
 
-        while (true) {
-            std::unique_lock<std::mutex> lock(mutex);
+    const auto index = std::size_t(slot - active.begin());
+    if (threads[index].joinable()) {
+        // A worker that exited after being idle.
+        threads[index].join();
+    }
 
-            cv.wait(lock, [this] { return !queue.empty() || terminated; });
+    *slot = true;
+    ++running;
+    threads[index] = std::thread([this, index] { runThread(index); });
+}
 
-            if (terminated) {
-                platform::detachThread();
-                return;
-            }
+void ThreadedSchedulerBase::runThread(std::size_t index) {
+    auto& settings = platform::Settings::getInstance();
+    auto value = settings.get(platform::EXPERIMENTAL_THREAD_PRIORITY_WORKER);
+    if (auto* priority = value.getDouble()) {
+        platform::setCurrentThreadPriority(*priority);
+    }
+
+    platform::setCurrentThreadName(std::string{"Worker "} + util::toString(index + 1));
+    platform::attachThread();
+    localQueue.set(queues[index].get());
+
+    // Only the workers started on demand shut down when idle.
+    const bool transient = index >= minThreads;
+
+    std::function<void()> function;
+    while (!terminated) {
+        if (popTask(index, function)) {
+            function();
+            function = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        // Announce that this worker is going to sleep before checking for pending
+        // tasks; schedule() does the opposite, so either this worker sees the new
+        // task or schedule() sees the sleeping worker and wakes it up.
+        ++sleeping;
+        const auto wakeUp = [this] { return pending > 0 || terminated; };
+        bool woken = true;
+        if (transient) {
+            woken = cv.wait_for(lock, idleTimeout, wakeUp);
+        } else {
+            cv.wait(lock, wakeUp);
+        }
+        --sleeping;
 
-            auto function = std::move(queue.front());
-            queue.pop();
+        // Tasks scheduled right before the decrement above might not have
+        // started a new worker, so check once more before leaving.
+        if (!woken && pending == 0) {
             lock.unlock();
-            if (function) function();
+            std::lock_guard<std::mutex> threadsLock(threadsMutex);
+            if (!terminated) {
+                active[index] = false;
+                --running;
+            }
+            break;
+        }
+    }
+
+    localQueue.set(nullptr);
+    platform::detachThread();
+}
+
+bool ThreadedSchedulerBase::popTask(std::size_t index, std::function<void()>& task) {
+    // Run this worker's own tasks first, as they tend to share data with the ones it just ran.
+    for (std::size_t lane = 0u; lane < PriorityCount; ++lane) {
+        if (lanePending[lane] > 0 && popTask(*queues[index], lane, task)) {
+            return true;
+        }
+    }
+
+    // Steal from the other workers only once there are none left.
+    for (std::size_t lane = 0u; lane < PriorityCount; ++lane) {
+        if (lanePending[lane] == 0) {
+            continue;
         }
-    });
+
+        for (std::size_t i = 1u; i < queues.size(); ++i) {
+            if (popTask(*queues[(index + i) % queues.size()], lane, task)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool ThreadedSchedulerBase::popTask(WorkQueue& queue, std::size_t lane, std::function<void()>& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto& tasks = queue.lanes[lane];
+    if (tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(tasks.front());
+    tasks.pop_front();
+    --lanePending[lane];
+    --pending;
+    return true;
 }
 
 void ThreadedSchedulerBase::schedule(std::function<void()> fn) {
+    scheduleWithPriority(TaskPriority::Normal, std::move(fn));
+}
+
+void ThreadedSchedulerBase::scheduleWithPriority(TaskPriority priority, std::function<void()> fn) {
     assert(fn);
+    WorkQueue* queue = localQueue.get();
+    if (!queue) {
+        // Transient workers exit in any order, so pick the next slot that has a running
+        // worker. The workers of the first `minThreads` slots never exit. A worker that
+        // exits right after being picked leaves the task to be stolen by the others.
+        const std::size_t start = nextQueue++;
+        for (std::size_t i = 0u; i < queues.size(); ++i) {
+            const std::size_t index = (start + i) % queues.size();
+            if (active[index]) {
+                queue = queues[index].get();
+                break;
+            }
+        }
+        if (!queue) {
+            queue = queues[start % minThreads].get();
+        }
+    }
+
+    const auto lane = static_cast<std::size_t>(priority);
+    assert(lane < PriorityCount);
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        queue.push(std::move(fn));
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->lanes[lane].push_back(std::move(fn));
+        ++lanePending[lane];
+        ++pending;
     }
 
-    cv.notify_one();
+    if (sleeping > 0) {
+        // Acquiring the mutex guarantees that the sleeping worker is either waiting
+        // on the condition variable already or will see the new task when it checks.
+        { std::lock_guard<std::mutex> lock(mutex); }
+        cv.notify_one();
+    } else if (running < queues.size()) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        startThread();
+    }
+}
+
+namespace {
+
+const Duration kIdleTimeout = Seconds(10);
+
+optional<std::size_t> getThreadCountSetting(const char* key) {
+    auto value = platform::Settings::getInstance().get(key);
+    if (auto* unsignedValue = value.getUint()) {
+        if (*unsignedValue > 0) return std::size_t(*unsignedValue);
+    } else if (auto* integer = value.getInt()) {
+        if (*integer > 0) return std::size_t(*integer);
+    } else if (auto* number = value.getDouble()) {
+        if (*number >= 1) return std::size_t(*number);
+    }
+    return {};
+}
+
+std::size_t defaultMaxThreads() {
+    if (auto maxThreads = getThreadCountSetting(platform::EXPERIMENTAL_WORKER_THREADS_MAX)) {
+        return *maxThreads;
+    }
+    // hardware_concurrency() returns 0 if the value is not computable.
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 4u);
+}
+
+std::size_t defaultMinThreads() {
+    auto minThreads = getThreadCountSetting(platform::EXPERIMENTAL_WORKER_THREADS_MIN);
+    // Same as the fixed-size pool this replaced, so that the pool doesn't have to
+    // warm up on every map load.
+    return std::min<std::size_t>(minThreads ? *minThreads : 4u, defaultMaxThreads());
+}
+
+} // namespace
+
+ThreadPool::ThreadPool() : ThreadPool(defaultMinThreads(), defaultMaxThreads()) {}
+
+ThreadPool::ThreadPool(std::size_t minThreads_, std::size_t maxThreads_)
+    : ThreadedSchedulerBase(minThreads_, maxThreads_, kIdleTimeout) {}
+
+ThreadPool::~ThreadPool() {
+    terminate();
 }
 
 } // namespace mbgl
@@ -2,30 +2,99 @@
 
 #include <mbgl/actor/mailbox.hpp>
 #include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/chrono.hpp>
+#include <mbgl/util/thread_local.hpp>
 
 #include <array>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
 
 namespace mbgl {
 
+/**
+ * @brief ThreadedSchedulerBase is a work-stealing task scheduler
+ *
+ * Every worker thread owns a task queue. Tasks scheduled from a worker thread
+ * go to its own queue, tasks scheduled from any other thread are distributed
+ * over the queues in a round-robin fashion. An idle worker first drains its own
+ * queue and then steals from the queues of the other workers, so the threads only
+ * contend on a shared lock when they have nothing left to do.
+ *
+ * Each queue is processed in FIFO order, thus a scheduler with a single thread
+ * executes the tasks in the order they were scheduled. The per-mailbox ordering
+ * guarantees are provided by `Mailbox`, which never has more than one task
+ * scheduled at a time.
+ *
+ * Every queue has a separate lane for each `TaskPriority`. Workers pick up a task
+ * from the highest non-empty lane of all queues, so tasks with different priorities
+ * are not executed in the order they were scheduled.
+ *
+ * The scheduler keeps `minThreads` workers alive at all times. When a task is
+ * scheduled while all of the workers are busy, an extra worker is started, up to
+ * `maxThreads`; extra workers exit again after being idle for `idleTimeout`.
+ */
 class ThreadedSchedulerBase : public Scheduler {
 public:
     void schedule(std::function<void()>) override;
+    void scheduleWithPriority(TaskPriority, std::function<void()>) override;
+
+    // Returns the number of currently running worker threads.
+    std::size_t getThreadCount() const { return running; }
 
 protected:
-    ThreadedSchedulerBase() = default;
+    ThreadedSchedulerBase(std::size_t minThreads, std::size_t maxThreads, Duration idleTimeout);
     ~ThreadedSchedulerBase() override;
 
+    // Stops and joins all worker threads. Must be called by the destructor of the
+    // derived class, before its weak pointer factory is destroyed.
     void terminate();
-    std::thread makeSchedulerThread(size_t index);
 
-    std::queue<std::function<void()>> queue;
+private:
+    static constexpr std::size_t PriorityCount = 3;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::array<std::deque<std::function<void()>>, PriorityCount> lanes;
+    };
+
+    void startThread();
+    void runThread(std::size_t index);
+    bool popTask(std::size_t index, std::function<void()>& task);
+    bool popTask(WorkQueue& queue, std::size_t lane, std::function<void()>& task);
+
+    const std::size_t minThreads;
+    const Duration idleTimeout;
+
+    // One queue per thread slot, allocated up front for `maxThreads` workers.
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    // The queue owned by the current thread, if it is a worker of this scheduler.
+    util::ThreadLocal<WorkQueue> localQueue;
+    std::atomic<std::size_t> nextQueue{0};
+
+    // Number of scheduled tasks that haven't been picked up by a worker yet.
+    std::atomic<std::size_t> pending{0};
+    // Same as above, but for each of the priority lanes separately.
+    std::array<std::atomic<std::size_t>, PriorityCount> lanePending{};
+    // Number of workers blocked (or about to block) on the condition variable.
+    std::atomic<std::size_t> sleeping{0};
+    std::atomic<std::size_t> running{0};
+    std::atomic<bool> terminated{false};
+
+    // Only used for putting idle workers to sleep and waking them up.
     std::mutex mutex;
     std::condition_variable cv;
-    bool terminated{false};
+
+    // Guards starting and stopping of the worker threads.
+    std::mutex threadsMutex;
+    std::vector<std::thread> threads;
+    // Whether each slot has a running worker. Only changed with `threadsMutex` held, but
+    // read without it when distributing tasks.
+    std::vector<std::atomic<bool>> active;
 };
 
 /**
@@ -39,24 +108,13 @@ protected:
 template <std::size_t N>
 class ThreadedScheduler : public ThreadedSchedulerBase {
 public:
-    ThreadedScheduler() {
-        for (std::size_t i = 0u; i < N; ++i) {
-            threads[i] = makeSchedulerThread(i);
-        }
-    }
-
-    ~ThreadedScheduler() override {
-        terminate();
-        for (auto& thread : threads) {
-            assert(std::this_thread::get_id() != thread.get_id());
-            thread.join();
-        }
-    }
+    ThreadedScheduler() : ThreadedSchedulerBase(N, N, Duration::zero()) {}
+
+    ~ThreadedScheduler() override { terminate(); }
 
     mapbox::base::WeakPtr<Scheduler> makeWeakPtr() override { return weakFactory.makeWeakPtr(); }
 
 private:
-    std::array<std::thread, N> threads;
     mapbox::base::WeakPtrFactory<Scheduler> weakFactory{this};
     static_assert(N > 0, "Thread count must be more than zero.");
 };
@@ -66,6 +124,24 @@ class SequencedScheduler : public ThreadedScheduler<1> {};
 template <std::size_t extra>
 using ParallelScheduler = ThreadedScheduler<1 + extra>;
 
-class ThreadPool : public ParallelScheduler<3> {};
+/**
+ * @brief ThreadPool is a scheduler whose thread count is determined at runtime
+ *
+ * The default constructor reads the limits from the EXPERIMENTAL_WORKER_THREADS_MIN
+ * and EXPERIMENTAL_WORKER_THREADS_MAX platform settings. When not set, the pool
+ * keeps 4 workers alive, like the fixed-size pool it replaces, and grows up to
+ * `std::thread::hardware_concurrency()` threads, but no less than 4.
+ */
+class ThreadPool : public ThreadedSchedulerBase {
+public:
+    ThreadPool();
+    ThreadPool(std::size_t minThreads, std::size_t maxThreads);
+    ~ThreadPool() override;
+
+    mapbox::base::WeakPtr<Scheduler> makeWeakPtr() override { return weakFactory.makeWeakPtr(); }
+
+private:
+    mapbox::base::WeakPtrFactory<Scheduler> weakFactory{this};
+};
 
 } // namespace mbgl
@@ -3,6 +3,7 @@
 #include <mbgl/actor/scheduler.hpp>
 #include <mbgl/test/util.hpp>
 #include <mbgl/util/run_loop.hpp>
+#include <mbgl/util/thread_pool.hpp>
 
 #include <chrono>
 #include <functional>
@@ -265,6 +266,82 @@ TEST(Actor, NonConcurrentMailbox) {
     endedFuture.wait();
 }
 
+TEST(Actor, PrioritizedMailbox) {
+    // Messages to an actor with a higher priority are processed first.
+
+    struct TestActor {
+        std::vector<int>& received;
+
+        TestActor(ActorRef<TestActor>, std::vector<int>& received_) : received(received_) {}
+
+        void receive(int i) { received.push_back(i); }
+
+        void end(std::promise<void> promise) { promise.set_value(); }
+    };
+
+    SequencedScheduler scheduler;
+    std::vector<int> received;
+    Actor<TestActor> low(scheduler, std::ref(received));
+    Actor<TestActor> high(scheduler, std::ref(received));
+    low.setPriority(TaskPriority::Low);
+    high.setPriority(TaskPriority::High);
+
+    // Keep the only worker busy until all of the messages are queued.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    scheduler.schedule([released] { released.wait(); });
+
+    low.self().invoke(&TestActor::receive, 1);
+    high.self().invoke(&TestActor::receive, 2);
+
+    std::promise<void> endedPromise;
+    std::future<void> endedFuture = endedPromise.get_future();
+    low.self().invoke(&TestActor::end, std::move(endedPromise));
+
+    release.set_value();
+    endedFuture.wait();
+
+    EXPECT_EQ((std::vector<int>{2, 1}), received);
+}
+
+TEST(Actor, ReprioritizedMailbox) {
+    // Changing the priority moves the messages that are already queued, and processes each of them once.
+
+    struct TestActor {
+        std::vector<int>& received;
+
+        TestActor(ActorRef<TestActor>, std::vector<int>& received_) : received(received_) {}
+
+        void receive(int i) { received.push_back(i); }
+
+        void end(std::promise<void> promise) { promise.set_value(); }
+    };
+
+    SequencedScheduler scheduler;
+    std::vector<int> received;
+    Actor<TestActor> first(scheduler, std::ref(received));
+    Actor<TestActor> second(scheduler, std::ref(received));
+
+    // Keep the only worker busy until all of the messages are queued.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    scheduler.schedule([released] { released.wait(); });
+
+    first.self().invoke(&TestActor::receive, 1);
+    second.self().invoke(&TestActor::receive, 2);
+    second.self().invoke(&TestActor::receive, 3);
+    second.setPriority(TaskPriority::High);
+
+    std::promise<void> endedPromise;
+    std::future<void> endedFuture = endedPromise.get_future();
+    first.self().invoke(&TestActor::end, std::move(endedPromise));
+
+    release.set_value();
+    endedFuture.wait();
+
+    EXPECT_EQ((std::vector<int>{2, 3, 1}), received);
+}
+
 TEST(Actor, Ask) {
     // Asking for a result
 
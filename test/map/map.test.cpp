@@ -10,6 +10,8 @@
 #include <mbgl/gl/context.hpp>
 #include <mbgl/map/map_options.hpp>
 #include <mbgl/math/log2.hpp>
+#include <mbgl/platform/settings.hpp>
+#include <mbgl/renderer/query.hpp>
 #include <mbgl/renderer/renderer.hpp>
 #include <mbgl/renderer/update_parameters.hpp>
 #include <mbgl/storage/file_source_manager.hpp>
@@ -32,6 +34,7 @@
 #include <mbgl/util/image.hpp>
 #include <mbgl/util/io.hpp>
 #include <mbgl/util/run_loop.hpp>
+#include <mbgl/util/string.hpp>
 
 #include <atomic>
 
@@ -1574,3 +1577,65 @@ TEST(Map, VolatileSource) {
     test.runLoop.run();
     EXPECT_EQ(8, requestedTiles);
 }
+
+TEST(Map, IncrementalPlacement) {
+    // Renders two symbol layers of overlapping icons and returns the number of placed symbols.
+    const auto renderPlacedSymbols = [] {
+        MapTest<> test{1, MapMode::Continuous};
+
+        std::string features;
+        for (int x = -60; x <= 60; x += 3) {
+            for (int y = -60; y <= 60; y += 3) {
+                if (!features.empty()) features += ",";
+                features += R"({"type": "Feature", "properties": {}, "geometry": {"type": "Point", "coordinates": [)" +
+                            util::toString(x) + "," + util::toString(y) + "]}}";
+            }
+        }
+
+        test.map.getStyle().loadJSON(R"STYLE({
+          "version": 8,
+          "sources": {
+            "points": {
+              "type": "geojson",
+              "data": {"type": "FeatureCollection", "features": [)STYLE" +
+                                     features + R"STYLE(]}
+            }
+          },
+          "layers": [{
+            "id": "icons-1",
+            "type": "symbol",
+            "source": "points",
+            "layout": {"icon-image": "marker"}
+          }, {
+            "id": "icons-2",
+            "type": "symbol",
+            "source": "points",
+            "layout": {"icon-image": "marker", "icon-offset": [6, 6]}
+          }]
+        })STYLE");
+        test.map.getStyle().addImage(std::make_unique<style::Image>("marker", PremultipliedImage({8, 8}), 1.0f));
+
+        test.observer.didFinishRenderingFrameCallback = [&](MapObserver::RenderFrameStatus status) {
+            if (status.mode == MapObserver::RenderMode::Full && !status.needsRepaint) {
+                test.runLoop.stop();
+            }
+        };
+        test.runLoop.run();
+
+        const Size size = test.frontend.getSize();
+        const ScreenBox box{{0, 0}, {double(size.width), double(size.height)}};
+        return test.frontend.getRenderer()
+            ->queryRenderedFeatures(box, RenderedQueryOptions{std::vector<std::string>{"icons-1", "icons-2"}})
+            .size();
+    };
+
+    const std::size_t placedSymbols = renderPlacedSymbols();
+    EXPECT_LT(0u, placedSymbols);
+
+    // With the smallest budget, every frame places a single bucket, yet the committed placement
+    // is the same as the one computed in one go.
+    auto& settings = platform::Settings::getInstance();
+    settings.set(platform::EXPERIMENTAL_PLACEMENT_TIME_BUDGET, 1e-6);
+    EXPECT_EQ(placedSymbols, renderPlacedSymbols());
+    settings.set(platform::EXPERIMENTAL_PLACEMENT_TIME_BUDGET, mapbox::base::Value{});
+}
@@ -0,0 +1,64 @@
+#include <mbgl/test/util.hpp>
+
+#include <mbgl/renderer/group_by_layout.hpp>
+#include <mbgl/style/expression/dsl.hpp>
+#include <mbgl/style/layers/circle_layer.hpp>
+#include <mbgl/style/layers/circle_layer_impl.hpp>
+#include <mbgl/style/layers/line_layer.hpp>
+#include <mbgl/style/layers/line_layer_impl.hpp>
+
+using namespace mbgl;
+using namespace mbgl::style;
+
+namespace {
+
+Immutable<LayerProperties> lineProperties(const LineLayer& layer) {
+    return makeMutable<LineLayerProperties>(staticImmutableCast<LineLayer::Impl>(layer.baseImpl));
+}
+
+Immutable<LayerProperties> circleProperties(const CircleLayer& layer) {
+    return makeMutable<CircleLayerProperties>(staticImmutableCast<CircleLayer::Impl>(layer.baseImpl));
+}
+
+} // namespace
+
+TEST(GroupByLayout, Related) {
+    LineLayer layerA("a", "source");
+    LineLayer layerB("b", "source");
+    auto result = groupByLayout({lineProperties(layerA), lineProperties(layerB)});
+    ASSERT_EQ(1u, result.size());
+    ASSERT_EQ(2u, result[0].size());
+    EXPECT_EQ("a", result[0][0]->baseImpl->id);
+    EXPECT_EQ("b", result[0][1]->baseImpl->id);
+}
+
+TEST(GroupByLayout, UnrelatedType) {
+    LineLayer layerA("a", "source");
+    CircleLayer layerB("b", "source");
+    auto result = groupByLayout({lineProperties(layerA), circleProperties(layerB)});
+    ASSERT_EQ(2u, result.size());
+}
+
+TEST(GroupByLayout, UnrelatedFilter) {
+    using namespace mbgl::style::expression::dsl;
+    LineLayer layerA("a", "source");
+    LineLayer layerB("b", "source");
+    layerB.setFilter(Filter(get("property")));
+    auto result = groupByLayout({lineProperties(layerA), lineProperties(layerB)});
+    ASSERT_EQ(2u, result.size());
+}
+
+TEST(GroupByLayout, UnrelatedLayout) {
+    LineLayer layerA("a", "source");
+    LineLayer layerB("b", "source");
+    layerB.setLineCap(LineCapType::Square);
+    auto result = groupByLayout({lineProperties(layerA), lineProperties(layerB)});
+    ASSERT_EQ(2u, result.size());
+}
+
+TEST(GroupByLayout, KeyIsResetOnModification) {
+    LineLayer layer("a", "source");
+    const std::string key = layoutKey(*layer.baseImpl);
+    layer.setLineCap(LineCapType::Square);
+    EXPECT_NE(key, layoutKey(*layer.baseImpl));
+}
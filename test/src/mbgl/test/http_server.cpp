@@ -180,6 +180,16 @@ void runServer(std::unique_ptr<httplib::Server>& server) {
         res.set_content("Response", "text/plain");
     });
 
+    std::atomic_int concurrentRequests(0);
+    server->Get("/concurrent", [&](const Request&, Response& res) {
+        // Responds with the number of requests to this route in progress, including this one.
+        const int concurrent = ++concurrentRequests;
+        usleep(100000);
+        --concurrentRequests;
+        res.status = 200;
+        res.set_content(std::to_string(concurrent), "text/plain");
+    });
+
     server->Get(R"(/load/(\d+))", [](const Request req, Response& res) {
         auto numbers = req.matches[1];
         res.set_content("Request " + std::string(numbers), "text/plain");
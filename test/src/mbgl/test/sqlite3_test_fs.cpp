@@ -4,7 +4,9 @@
 
 #include <sqlite3.h>
 
+#include <atomic>
 #include <stdexcept>
+#include <thread>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -16,6 +18,7 @@ static bool sqlite3_test_fs_file_open = true;
 static bool sqlite3_test_fs_file_create = true;
 static int64_t sqlite3_test_fs_read_limit = -1;
 static int64_t sqlite3_test_fs_write_limit = -1;
+static std::atomic<std::chrono::milliseconds::rep> sqlite3_test_fs_read_delay{0};
 
 struct File {
     sqlite3_file base;
@@ -52,6 +55,9 @@ static int sqlite3_test_fs_read(sqlite3_file* pFile, void* zBuf, int iAmt, sqlit
         }
         sqlite3_test_fs_read_limit -= iAmt;
     }
+    if (sqlite3_test_fs_read_delay > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sqlite3_test_fs_read_delay));
+    }
     auto* file = (File*)pFile;
     return file->real->pMethods->xRead(file->real, zBuf, iAmt, iOfst);
 }
@@ -286,6 +292,10 @@ void SQLite3TestFS::setDebug(bool value) {
     sqlite3_test_fs_debug = value;
 }
 
+void SQLite3TestFS::makeDefault() {
+    sqlite3_vfs_register(sqlite3_vfs_find("test_fs"), 1);
+}
+
 void SQLite3TestFS::allowIO(bool value) {
     sqlite3_test_fs_io = value;
 }
@@ -306,6 +316,10 @@ void SQLite3TestFS::setWriteLimit(int64_t value) {
     sqlite3_test_fs_write_limit = value;
 }
 
+void SQLite3TestFS::setReadDelay(std::chrono::milliseconds value) {
+    sqlite3_test_fs_read_delay = value.count();
+}
+
 void SQLite3TestFS::reset() {
     setDebug(false);
     allowIO(true);
@@ -313,6 +327,7 @@ void SQLite3TestFS::reset() {
     allowFileCreate(true);
     setReadLimit(-1);
     setWriteLimit(-1);
+    setReadDelay(std::chrono::milliseconds::zero());
 }
 
 } // namespace test
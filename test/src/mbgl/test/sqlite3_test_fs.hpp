@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 
 namespace mbgl {
@@ -13,6 +14,9 @@ public:
     // When enabled, the VFS will log all I/O operations to stdout.
     void setDebug(bool);
 
+    // Use the VFS for the databases that don't select one with a "vfs" URI parameter too.
+    void makeDefault();
+
     // Allow any type of I/O. Will fail with SQLITE_AUTH if set to false. This is useful to simulate
     // scenarios where the OS blocks an entire app's I/O, e.g. when it's in the background.
     void allowIO(bool);
@@ -30,6 +34,10 @@ public:
     // Allow N bytes to be written, then fail writes with SQLITE_FULL. -1 == unlimited
     // This limit is global, not per file.
     void setWriteLimit(int64_t);
+
+    // Delay every read, e.g. to simulate slow storage. Reads on different threads are delayed
+    // concurrently.
+    void setReadDelay(std::chrono::milliseconds);
     
     // Reset all restrictions.
     void reset();
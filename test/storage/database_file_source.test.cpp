@@ -1,14 +1,33 @@
+#include <mbgl/storage/database_file_source.hpp>
 #include <mbgl/storage/file_source_manager.hpp>
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/resource_options.hpp>
 #include <mbgl/test/util.hpp>
+#include <mbgl/util/io.hpp>
 #include <mbgl/util/run_loop.hpp>
 #include <mbgl/util/timer.hpp>
 
 #include <gtest/gtest.h>
 
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace std::literals::string_literals;
 using namespace mbgl;
 
+namespace {
+
+constexpr const char* filename = "test/fixtures/offline_database/concurrent_reads.db";
+
+void deleteDatabaseFiles() {
+    util::deleteFile(filename);
+    util::deleteFile(filename + "-wal"s);
+    util::deleteFile(filename + "-journal"s);
+}
+
+} // namespace
+
 TEST(DatabaseFileSource, PauseResume) {
     util::RunLoop loop;
 
@@ -54,4 +73,119 @@ TEST(DatabaseFileSource, VolatileResource) {
         });
     });
     loop.run();
-}
\ No newline at end of file
+}
+
+TEST(DatabaseFileSource, WriteBehind) {
+    util::RunLoop loop;
+
+    std::shared_ptr<FileSource> dbfs =
+        FileSourceManager::get()->getFileSource(FileSourceType::Database, ResourceOptions{});
+    dbfs->setProperty(AMBIENT_CACHE_WRITE_BEHIND_KEY, true);
+
+    Resource resource{Resource::Unknown, "http://127.0.0.1:3000/write-behind", {}, Resource::LoadingMethod::CacheOnly};
+    Response response{};
+    response.data = std::make_shared<std::string>("Cached value");
+    std::unique_ptr<mbgl::AsyncRequest> req;
+    bool stored = false;
+    bool received = false;
+
+    dbfs->forward(resource, response, [&] {
+        // Invoked once the write is committed.
+        stored = true;
+        if (received) {
+            loop.stop();
+        }
+    });
+
+    // The pending write is visible before it is committed.
+    req = dbfs->request(resource, [&](Response res) {
+        req.reset();
+        EXPECT_EQ(nullptr, res.error);
+        ASSERT_TRUE(res.data.get());
+        EXPECT_EQ("Cached value", *res.data);
+        received = true;
+        if (stored) {
+            loop.stop();
+        }
+    });
+
+    loop.run();
+    dbfs->setProperty(AMBIENT_CACHE_WRITE_BEHIND_KEY, false);
+}
+
+TEST(DatabaseFileSource, TEST_REQUIRES_WRITE(ConcurrentReads)) {
+    util::RunLoop loop;
+
+    // In-memory databases can't be shared with the read-only connections.
+    deleteDatabaseFiles();
+    auto dbfs = std::make_shared<DatabaseFileSource>(ResourceOptions().withCachePath(filename));
+
+    constexpr std::size_t count = 32;
+    std::vector<Resource> resources;
+    for (std::size_t i = 0; i < count; ++i) {
+        resources.emplace_back(Resource::Unknown,
+                               "http://127.0.0.1:3000/concurrent-" + std::to_string(i),
+                               optional<Resource::TileData>{},
+                               Resource::LoadingMethod::CacheOnly);
+    }
+
+    std::vector<std::unique_ptr<mbgl::AsyncRequest>> requests;
+    std::size_t stored = 0;
+    std::size_t received = 0;
+
+    // The writer stays blocked until all of the requests are answered, which only the read-only
+    // connections can do then.
+    std::promise<void> writerBlocked;
+    std::promise<void> unblock;
+    std::shared_future<void> unblockWriter = unblock.get_future().share();
+    bool unblocked = false;
+    auto unblockOnce = [&] {
+        if (!unblocked) {
+            unblocked = true;
+            unblock.set_value();
+        }
+    };
+
+    util::Timer timeout;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Response response{};
+        response.data = std::make_shared<std::string>("Cached value " + std::to_string(i));
+        dbfs->forward(resources[i], response, [&] {
+            if (++stored < count) {
+                return;
+            }
+
+            dbfs->packDatabase([&](std::exception_ptr) {
+                writerBlocked.set_value();
+                unblockWriter.wait();
+            });
+            writerBlocked.get_future().wait();
+
+            timeout.start(Seconds(10), Duration::zero(), [&] {
+                ADD_FAILURE() << "Requests waited for the writer";
+                unblockOnce();
+            });
+
+            for (std::size_t j = 0; j < count; ++j) {
+                requests.push_back(dbfs->request(resources[j], [&, j](Response res) {
+                    EXPECT_EQ(nullptr, res.error);
+                    ASSERT_TRUE(res.data.get());
+                    EXPECT_EQ("Cached value " + std::to_string(j), *res.data);
+                    if (++received == count) {
+                        timeout.stop();
+                        unblockOnce();
+                        loop.stop();
+                    }
+                }));
+            }
+        });
+    }
+
+    loop.run();
+    EXPECT_EQ(count, received);
+
+    requests.clear();
+    dbfs.reset();
+    deleteDatabaseFiles();
+}
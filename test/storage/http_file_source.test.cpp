@@ -1,3 +1,4 @@
+#include <mbgl/platform/settings.hpp>
 #include <mbgl/storage/http_file_source.hpp>
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/test/util.hpp>
@@ -205,3 +206,38 @@ TEST(HTTPFileSource, TEST_REQUIRES_SERVER(Load)) {
 
     loop.run();
 }
+
+TEST(HTTPFileSource, TEST_REQUIRES_SERVER(ConnectionSettings)) {
+    util::RunLoop loop;
+
+    auto& settings = platform::Settings::getInstance();
+    settings.set(platform::EXPERIMENTAL_HTTP_MULTIPLEXING, false);
+    settings.set(platform::EXPERIMENTAL_HTTP_MAX_HOST_CONNECTIONS, uint64_t(2));
+    settings.set(platform::EXPERIMENTAL_HTTP_MAX_CONCURRENT_STREAMS, uint64_t(10));
+    settings.set(platform::EXPERIMENTAL_HTTP_CONNECTION_CACHE_SIZE, uint64_t(4));
+    HTTPFileSource fs(ResourceOptions::Default());
+
+    // Requests beyond the connection limit wait for a connection, instead of failing.
+    const int count = 10;
+    int completed = 0;
+    std::unique_ptr<AsyncRequest> reqs[count];
+    for (int i = 0; i < count; i++) {
+        reqs[i] = fs.request({Resource::Unknown, "http://127.0.0.1:3000/test"}, [&, i](Response res) {
+            reqs[i].reset();
+            EXPECT_EQ(nullptr, res.error);
+            ASSERT_TRUE(res.data.get());
+            EXPECT_EQ("Hello World!", *res.data);
+            if (++completed == count) {
+                loop.stop();
+            }
+        });
+    }
+
+    loop.run();
+
+    using Value = mapbox::base::Value;
+    settings.set(mapbox::base::ValueObject{{platform::EXPERIMENTAL_HTTP_MULTIPLEXING, Value{}},
+                                           {platform::EXPERIMENTAL_HTTP_MAX_HOST_CONNECTIONS, Value{}},
+                                           {platform::EXPERIMENTAL_HTTP_MAX_CONCURRENT_STREAMS, Value{}},
+                                           {platform::EXPERIMENTAL_HTTP_CONNECTION_CACHE_SIZE, Value{}}});
+}
@@ -825,6 +825,90 @@ TEST(MainResourceLoader, TEST_REQUIRES_SERVER(NoDoubleDispatch)) {
     loop.run();
 }
 
+TEST(MainResourceLoader, TEST_REQUIRES_SERVER(CoalesceIdenticalRequests)) {
+    util::RunLoop loop;
+    MainResourceLoader fs(ResourceOptions{});
+
+    // Every request that reaches the server gets a new response body and etag, so both requesters
+    // seeing the same one proves that only a single request was made.
+    Resource resource{Resource::Unknown, "http://127.0.0.1:3000/revalidate-etag"};
+    resource.loadingMethod = Resource::LoadingMethod::NetworkOnly;
+
+    std::unique_ptr<AsyncRequest> req1;
+    std::unique_ptr<AsyncRequest> req2;
+    std::vector<Response> responses;
+
+    auto callback = [&](std::unique_ptr<AsyncRequest>& req) {
+        return [&](Response res) {
+            req.reset();
+            EXPECT_EQ(nullptr, res.error);
+            ASSERT_TRUE(res.data.get());
+            ASSERT_TRUE(res.etag);
+            responses.push_back(res);
+            if (responses.size() == 2u) {
+                loop.stop();
+            }
+        };
+    };
+
+    req1 = fs.request(resource, callback(req1));
+    req2 = fs.request(resource, callback(req2));
+
+    loop.run();
+
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(*responses[0].data, *responses[1].data);
+    EXPECT_EQ(*responses[0].etag, *responses[1].etag);
+
+    // Once all requesters are gone, a new request goes to the server again.
+    std::unique_ptr<AsyncRequest> req3 = fs.request(resource, [&](Response res) {
+        req3.reset();
+        EXPECT_EQ(nullptr, res.error);
+        ASSERT_TRUE(res.data.get());
+        EXPECT_NE(*responses[0].data, *res.data);
+        ASSERT_TRUE(res.etag);
+        EXPECT_NE(*responses[0].etag, *res.etag);
+        loop.stop();
+    });
+
+    loop.run();
+}
+
+TEST(MainResourceLoader, CompletedRequestsAreNotJoined) {
+    util::RunLoop loop;
+    MainResourceLoader fs(ResourceOptions{});
+    std::shared_ptr<FileSource> dbfs =
+        FileSourceManager::get()->getFileSource(FileSourceType::Database, ResourceOptions{});
+
+    const Resource resource{
+        Resource::Unknown, "http://127.0.0.1:3000/completed", {}, Resource::LoadingMethod::CacheOnly};
+    Response response;
+    response.data = std::make_shared<std::string>("Cached value 1");
+
+    std::unique_ptr<AsyncRequest> req1;
+    std::unique_ptr<AsyncRequest> req2;
+
+    dbfs->forward(resource, response, [&] {
+        // A cache only request is complete after its response, even though it is still alive.
+        req1 = fs.request(resource, [&](Response res1) {
+            ASSERT_TRUE(res1.data.get());
+            EXPECT_EQ("Cached value 1", *res1.data);
+
+            response.data = std::make_shared<std::string>("Cached value 2");
+            dbfs->forward(resource, response, [&] {
+                // So an identical request reads the cache again instead of replaying the response.
+                req2 = fs.request(resource, [&](Response res2) {
+                    ASSERT_TRUE(res2.data.get());
+                    EXPECT_EQ("Cached value 2", *res2.data);
+                    loop.stop();
+                });
+            });
+        });
+    });
+
+    loop.run();
+}
+
 TEST(MainResourceLoader, ResourceOptions) {
     MainResourceLoader fs(
         ResourceOptions().withTileServerOptions(
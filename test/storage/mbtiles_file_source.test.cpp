@@ -0,0 +1,79 @@
+#include <mbgl/storage/mbtiles_file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/storage/sqlite3.hpp>
+#include <mbgl/test/util.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/chrono.hpp>
+#include <mbgl/util/run_loop.hpp>
+
+#ifndef __QT__ // Qt doesn't expose the ability to register virtual file system handlers.
+#include <mbgl/test/sqlite3_test_fs.hpp>
+#endif
+
+#include <unistd.h>
+#include <climits>
+#include <cstdio>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string toAbsolutePath(const std::string& fileName) {
+    char buff[PATH_MAX + 1];
+    char* cwd = getcwd(buff, PATH_MAX + 1);
+    return std::string(cwd) + "/test/fixtures/storage/" + fileName;
+}
+
+} // namespace
+
+using namespace mbgl;
+
+#ifndef __QT__ // Qt doesn't expose the ability to register virtual file system handlers.
+TEST(MaptilerFileSource, TEST_REQUIRES_WRITE(ConcurrentReads)) {
+    const std::string path = toAbsolutePath("tiles.mbtiles");
+    std::remove(path.c_str());
+    {
+        auto db = mapbox::sqlite::Database::open(path, mapbox::sqlite::ReadWriteCreate);
+        db.exec("CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB)");
+        db.exec("INSERT INTO tiles VALUES (0, 0, 0, 'tile')");
+    }
+
+    // Every read from the file is slow, so reads that wait for each other take noticeably longer.
+    test::SQLite3TestFS fs;
+    fs.makeDefault();
+    fs.setReadDelay(std::chrono::milliseconds(50));
+
+    util::RunLoop loop;
+
+    // Returns how long it takes to read the tile with the given number of concurrent requests. Each
+    // file source starts without open connections, so that every request opens its own.
+    auto readTile = [&](std::size_t count) {
+        MaptilerFileSource fileSource(ResourceOptions::Default());
+        const Resource resource =
+            Resource::tile("mbtiles://" + path + "?file={x}/{y}/{z}.pbf", 1.0, 0, 0, 0, Tileset::Scheme::XYZ);
+
+        const auto start = Clock::now();
+        std::vector<std::unique_ptr<AsyncRequest>> requests;
+        std::size_t responses = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            requests.push_back(fileSource.request(resource, [&](Response res) {
+                EXPECT_EQ(nullptr, res.error);
+                ASSERT_TRUE(res.data.get());
+                EXPECT_EQ("tile", *res.data);
+                if (++responses == count) {
+                    loop.stop();
+                }
+            }));
+        }
+        loop.run();
+        return Clock::now() - start;
+    };
+
+    const Duration single = readTile(1);
+    const Duration concurrent = readTile(4);
+    EXPECT_LT(concurrent, single * 2);
+
+    fs.reset();
+    std::remove(path.c_str());
+}
+#endif // __QT__
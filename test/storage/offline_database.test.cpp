@@ -5,6 +5,7 @@
 #include <mbgl/storage/offline_database.hpp>
 #include <mbgl/storage/resource.hpp>
 #include <mbgl/storage/response.hpp>
+#include <mbgl/util/compression.hpp>
 #include <mbgl/util/io.hpp>
 #include <mbgl/util/string.hpp>
 
@@ -148,7 +149,6 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CreateFail)) {
     // We can also still "query" the database even though it is not open, and we will always get an empty result.
     for (const auto& res : { fixture::resource, fixture::tile }) {
         EXPECT_FALSE(bool(db.get(res)));
-        EXPECT_EQ(1u, log.count(warning(ResultCode::CantOpen, "Can't update timestamp: unable to open database file")));
         EXPECT_EQ(1u, log.count(warning(ResultCode::CantOpen, "Can't read resource: unable to open database file")));
         EXPECT_EQ(0u, log.uncheckedCount());
     }
@@ -165,13 +165,12 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CreateFail)) {
     }
 
     // Next, set the file system to read only mode and try to read the data again. While we can't
-    // write anymore, we should still be able to read, and the query that tries to update the last
-    // accessed timestamp may fail without crashing.
+    // write anymore, we should still be able to read, since updating the last accessed timestamp
+    // is deferred and doesn't write to the database.
     fs.allowFileCreate(false);
     fs.setWriteLimit(0);
     for (const auto& res : { fixture::resource, fixture::tile }) {
         auto result = db.get(res);
-        EXPECT_EQ(1u, log.count(warning(ResultCode::CantOpen, "Can't update timestamp: unable to open database file")));
         EXPECT_EQ(0u, log.uncheckedCount());
 
         ASSERT_TRUE(result && result->data);
@@ -180,13 +179,11 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CreateFail)) {
     fs.setDebug(false);
 
     // We're allowing SQLite to create a journal file, but restrict the number of bytes it
-    // can write so that it can start writing the journal file, but eventually fails during the
-    // timestamp update.
+    // can write. Reads still succeed since they don't write at all.
     fs.allowFileCreate(true);
     fs.setWriteLimit(8192);
     for (const auto& res : { fixture::resource, fixture::tile }) {
         auto result = db.get(res);
-        EXPECT_EQ(1u, log.count(warning(ResultCode::Full, "Can't update timestamp: database or disk is full")));
         EXPECT_EQ(0u, log.uncheckedCount());
         ASSERT_TRUE(result && result->data);
         EXPECT_EQ("first", *result->data);
@@ -199,7 +196,6 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CreateFail)) {
     for (const auto& res : { fixture::resource, fixture::tile }) {
         // First, try reading.
         auto result = db.get(res);
-        EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't update timestamp: authorization denied")));
         EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't read resource: authorization denied")));
         EXPECT_EQ(0u, log.uncheckedCount());
         EXPECT_FALSE(result);
@@ -229,7 +225,7 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(SchemaVersion)) {
         OfflineDatabase db(filename, fixture::tileServerOptions);
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
 
     OfflineDatabase db(filename, fixture::tileServerOptions);
     // Now try inserting and reading back to make sure we have a valid database.
@@ -1076,6 +1072,236 @@ TEST(OfflineDatabase, PutEvictsLeastRecentlyUsedResources) {
     EXPECT_EQ(0u, log.uncheckedCount());
 }
 
+TEST(OfflineDatabase, PutAmbientResources) {
+    FixtureLog log;
+    OfflineDatabase db(":memory:", fixture::tileServerOptions);
+    db.setMaximumAmbientCacheSize(1024 * 100);
+
+    Response response;
+    response.data = randomString(1024);
+
+    Response error;
+    error.error = std::make_unique<Response::Error>(Response::Error::Reason::Server, "Server error");
+
+    std::list<std::tuple<Resource, Response>> resources;
+    for (uint32_t i = 1; i <= 101; ++i) {
+        resources.emplace_back(Resource::style("http://example.com/"s + util::toString(i)), response);
+    }
+    resources.emplace_back(Resource::style("http://example.com/error"), error);
+    EXPECT_TRUE(db.putAmbientResources(resources));
+
+    // Resources are evicted within the batch as they would be when put one by one.
+    EXPECT_FALSE(bool(db.get(Resource::style("http://example.com/1"))));
+    EXPECT_TRUE(bool(db.get(Resource::style("http://example.com/2"))));
+    EXPECT_TRUE(bool(db.get(Resource::style("http://example.com/101"))));
+    EXPECT_FALSE(bool(db.get(Resource::style("http://example.com/error"))));
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
+TEST(OfflineDatabase, TEST_REQUIRES_WRITE(JournalMode)) {
+    FixtureLog log;
+    deleteDatabaseFiles();
+
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        EXPECT_EQ(nullptr, db.setJournalMode(OfflineDatabase::JournalMode::WAL));
+        EXPECT_EQ(nullptr, db.setDurability(OfflineDatabase::Durability::Normal));
+
+        Response response;
+        response.data = std::make_shared<std::string>("data");
+        db.put(Resource::style("http://example.com/"), response);
+    }
+    EXPECT_EQ("wal", databaseJournalMode(filename));
+
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        EXPECT_TRUE(bool(db.get(Resource::style("http://example.com/"))));
+    }
+    EXPECT_EQ("delete", databaseJournalMode(filename));
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
+TEST(OfflineDatabase, TEST_REQUIRES_WRITE(DeferredAccessedTimestamps)) {
+    FixtureLog log;
+    deleteDatabaseFiles();
+
+    const Resource resource = Resource::style("http://example.com/");
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        Response response;
+        response.data = std::make_shared<std::string>("data");
+        db.put(resource, response);
+    }
+
+    {
+        mapbox::sqlite::Database db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadWriteCreate);
+        db.exec("UPDATE resources SET accessed = 0");
+    }
+
+    auto accessed = [] {
+        mapbox::sqlite::Database db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadOnly);
+        mapbox::sqlite::Statement stmt{db, "SELECT accessed FROM resources"};
+        mapbox::sqlite::Query query{stmt};
+        query.run();
+        return query.get<int64_t>(0);
+    };
+
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        EXPECT_TRUE(bool(db.get(resource)));
+
+        // Reading doesn't write to the database...
+        EXPECT_EQ(0, accessed());
+    }
+
+    // ...but the accessed timestamp is written when the database is closed.
+    EXPECT_LT(0, accessed());
+
+    {
+        mapbox::sqlite::Database db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadWriteCreate);
+        db.exec("UPDATE resources SET accessed = 0");
+    }
+
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        EXPECT_TRUE(bool(db.get(resource)));
+
+        // Pending timestamps are written before the database is reopened read-only.
+        db.reopenDatabaseReadOnly(true);
+        EXPECT_LT(0, accessed());
+        EXPECT_TRUE(bool(db.get(resource)));
+    }
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
+TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CompressionCodec)) {
+    FixtureLog log;
+    deleteDatabaseFiles();
+
+    auto codecs = [] {
+        std::vector<int> result;
+        mapbox::sqlite::Database db = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadOnly);
+        mapbox::sqlite::Statement stmt{db, "SELECT compressed FROM resources ORDER BY id"};
+        mapbox::sqlite::Query query{stmt};
+        while (query.run()) {
+            result.push_back(query.get<int>(0));
+        }
+        return result;
+    };
+
+    auto payload = [](uint32_t i) {
+        return R"({"type":"Feature","id":)" + util::toString(i) +
+               R"(,"properties":{"class":"residential","name":"Street )" + util::toString(i % 97) +
+               R"("},"geometry":{"type":"LineString","coordinates":[[)" + util::toString(i % 180) + "," +
+               util::toString(i % 90) + "]]}}";
+    };
+
+    Response response;
+    response.data = std::make_shared<std::string>(payload(0) + payload(1) + payload(2));
+
+    if (!util::isCodecAvailable(util::CompressionCodec::Zstd)) {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        EXPECT_NE(nullptr, db.setCompressionCodec(util::CompressionCodec::Zstd));
+        EXPECT_EQ(1u,
+                  log.count({EventSeverity::Error,
+                             Event::Database,
+                             -1,
+                             "Can't set compression codec: zstd isn't available in this build"}));
+
+        // Deflate is still used.
+        db.put(Resource::style("http://example.com/deflate"), response);
+        EXPECT_EQ((std::vector<int>{1}), codecs());
+        EXPECT_EQ(0u, log.uncheckedCount());
+        return;
+    }
+
+    std::vector<std::string> samples;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        samples.push_back(payload(i));
+    }
+    const std::string dictionary = util::trainDictionary(samples, 4096);
+    EXPECT_NE(0u, util::getDictionaryID(dictionary));
+
+    {
+        OfflineDatabase db(filename, fixture::tileServerOptions);
+        db.put(Resource::style("http://example.com/deflate"), response);
+
+        EXPECT_EQ(nullptr, db.setCompressionCodec(util::CompressionCodec::Zstd));
+        db.put(Resource::style("http://example.com/zstd"), response);
+
+        EXPECT_EQ(nullptr, db.setCompressionCodec(util::CompressionCodec::Zstd, dictionary));
+        db.put(Resource::style("http://example.com/dictionary"), response);
+    }
+    EXPECT_EQ((std::vector<int>{1, 2, 2}), codecs());
+
+    // Entries stay readable regardless of the codec new entries are compressed with, as the
+    // dictionary is stored in the database.
+    OfflineDatabase db(filename, fixture::tileServerOptions);
+    for (const auto& url : {"http://example.com/deflate", "http://example.com/zstd", "http://example.com/dictionary"}) {
+        auto result = db.get(Resource::style(url));
+        ASSERT_TRUE(result && result->data) << url;
+        EXPECT_EQ(*response.data, *result->data) << url;
+    }
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
+#ifndef __QT__ // Qt doesn't expose the ability to register virtual file system handlers.
+TEST(OfflineDatabase, TEST_REQUIRES_WRITE(CompressionCodecStoreFailure)) {
+    FixtureLog log;
+    deleteDatabaseFiles();
+    test::SQLite3TestFS fs;
+
+    if (!util::isCodecAvailable(util::CompressionCodec::Zstd)) {
+        return;
+    }
+
+    std::vector<std::string> samples;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        samples.push_back(R"({"type":"Feature","id":)" + util::toString(i) + R"(,"properties":{"name":"Street )" +
+                          util::toString(i % 97) + R"("}})");
+    }
+    const std::string dictionary = util::trainDictionary(samples, 4096);
+    ASSERT_NE(0u, util::getDictionaryID(dictionary));
+
+    Response response;
+    response.data = std::make_shared<std::string>(samples[0] + samples[1] + samples[2]);
+
+    OfflineDatabase db(filename_test_fs, fixture::tileServerOptions);
+    db.put(Resource::style("http://example.com/before"), response);
+
+    // The dictionary can't be stored, so the codec must not change either.
+    fs.allowIO(false);
+    EXPECT_NE(nullptr, db.setCompressionCodec(util::CompressionCodec::Zstd, dictionary));
+    EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't set compression codec: authorization denied")));
+    EXPECT_EQ(0u, log.uncheckedCount());
+
+    fs.allowIO(true);
+    db.put(Resource::style("http://example.com/after"), response);
+    {
+        mapbox::sqlite::Database check = mapbox::sqlite::Database::open(filename, mapbox::sqlite::ReadOnly);
+        mapbox::sqlite::Statement stmt{check, "SELECT compressed FROM resources ORDER BY id"};
+        mapbox::sqlite::Query query{stmt};
+        std::vector<int> codecs;
+        while (query.run()) {
+            codecs.push_back(query.get<int>(0));
+        }
+        EXPECT_EQ((std::vector<int>{1, 1}), codecs);
+    }
+
+    for (const auto& url : {"http://example.com/before", "http://example.com/after"}) {
+        auto result = db.get(Resource::style(url));
+        ASSERT_TRUE(result && result->data) << url;
+        EXPECT_EQ(*response.data, *result->data) << url;
+    }
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+#endif // __QT__
+
 TEST(OfflineDatabase, OfflineRegionDoesNotAffectAmbientCacheSize) {
     FixtureLog log;
     OfflineDatabase db(":memory:", fixture::tileServerOptions);
@@ -1137,6 +1363,42 @@ TEST(OfflineDatabase, PutRegionResourceDoesNotEvict) {
     EXPECT_EQ(0u, log.uncheckedCount());
 }
 
+TEST(OfflineDatabase, BeforeRegionWrite) {
+    FixtureLog log;
+    OfflineDatabase db(":memory:", fixture::tileServerOptions);
+
+    OfflineTilePyramidRegionDefinition definition { "", LatLngBounds::world(), 0, INFINITY, 1.0, true };
+    auto region = db.createRegion(definition, OfflineRegionMetadata());
+    ASSERT_TRUE(region);
+
+    const Resource resource = Resource::style("http://example.com/");
+    Response ambient;
+    ambient.data = std::make_shared<std::string>("ambient");
+    Response regional;
+    regional.data = std::make_shared<std::string>("region");
+
+    // A queued ambient write is written out before the region write, which replaces it.
+    std::list<std::tuple<Resource, Response>> queued{{resource, ambient}};
+    int calls = 0;
+    db.setBeforeRegionWrite([&] {
+        ++calls;
+        EXPECT_TRUE(db.putAmbientResources(queued));
+        queued.clear();
+    });
+
+    db.putRegionResource(region->getID(), resource, regional);
+    EXPECT_EQ(1, calls);
+    auto result = db.get(resource);
+    ASSERT_TRUE(result && result->data);
+    EXPECT_EQ("region", *result->data);
+
+    OfflineRegionStatus status;
+    db.putRegionResources(region->getID(), {{resource, regional}}, status);
+    EXPECT_EQ(2, calls);
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
 TEST(OfflineDatabase, PutFailsWhenEvictionInsuffices) {
     FixtureLog log;
     OfflineDatabase db(":memory:", fixture::tileServerOptions);
@@ -1257,6 +1519,52 @@ TEST(OfflineDatabase, HasRegionResourceTile) {
 
 }
 
+TEST(OfflineDatabase, HasRegionResources) {
+    FixtureLog log;
+    OfflineDatabase db(":memory:", fixture::tileServerOptions);
+
+    OfflineTilePyramidRegionDefinition definition { "", LatLngBounds::world(), 0, INFINITY, 1.0, false };
+    auto region = db.createRegion(definition, OfflineRegionMetadata());
+    ASSERT_TRUE(region);
+
+    Response response;
+    response.data = std::make_shared<std::string>("data");
+
+    // Store every other tile of a 4x4 grid, and a tile outside of the grid on another zoom level.
+    std::vector<Resource> resources;
+    for (int32_t x = 0; x < 4; x++) {
+        for (int32_t y = 0; y < 4; y++) {
+            auto tile = Resource::tile("http://example.com/{z}-{x}-{y}", 1.0, x, y, 2, Tileset::Scheme::XYZ);
+            if ((x + y) % 2 == 0) {
+                db.putRegionResource(region->getID(), tile, response);
+            }
+            resources.push_back(std::move(tile));
+        }
+    }
+    db.putRegionResource(region->getID(),
+                         Resource::tile("http://example.com/{z}-{x}-{y}", 1.0, 1, 1, 3, Tileset::Scheme::XYZ),
+                         response);
+    db.putRegionResource(region->getID(), Resource::style("http://example.com/style"), response);
+    resources.push_back(Resource::style("http://example.com/style"));
+    resources.push_back(Resource::style("http://example.com/missing"));
+    resources.push_back(Resource::tile("http://example.com/{z}-{x}-{y}", 1.0, 1, 1, 3, Tileset::Scheme::XYZ));
+
+    const auto sizes = db.hasRegionResources(resources);
+    ASSERT_EQ(resources.size(), sizes.size());
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        EXPECT_EQ(db.hasRegionResource(resources[i]), sizes[i]);
+    }
+    EXPECT_EQ(4, *sizes[0]);
+    EXPECT_FALSE(bool(sizes[1]));
+    EXPECT_EQ(4, *sizes[16]);
+    EXPECT_FALSE(bool(sizes[17]));
+    EXPECT_EQ(4, *sizes[18]);
+
+    EXPECT_TRUE(db.hasRegionResources({}).empty());
+
+    EXPECT_EQ(0u, log.uncheckedCount());
+}
+
 TEST(OfflineDatabase, OfflineMapboxTileCount) {
     FixtureLog log;
     OfflineDatabase db(":memory:", fixture::tileServerOptions);
@@ -1397,7 +1705,7 @@ TEST(OfflineDatabase, MigrateFromV2Schema) {
         }
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
     EXPECT_LT(databasePageCount(filename),
               databasePageCount("test/fixtures/offline_database/v2.db"));
 
@@ -1420,7 +1728,7 @@ TEST(OfflineDatabase, MigrateFromV3Schema) {
         }
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
 
     EXPECT_EQ(0u, log.uncheckedCount());
 }
@@ -1441,7 +1749,7 @@ TEST(OfflineDatabase, MigrateFromV4Schema) {
         }
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
 
     // Journal mode should be DELETE after migration to v5.
     EXPECT_EQ("delete", databaseJournalMode(filename));
@@ -1469,7 +1777,7 @@ TEST(OfflineDatabase, MigrateFromV5Schema) {
         }
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
 
     EXPECT_EQ((std::vector<std::string>{"id",
                                         "url_template",
@@ -1489,6 +1797,7 @@ TEST(OfflineDatabase, MigrateFromV5Schema) {
         (std::vector<std::string>{
             "id", "url", "kind", "expires", "modified", "etag", "data", "compressed", "accessed", "must_revalidate"}),
         databaseTableColumns(filename, "resources"));
+    EXPECT_EQ((std::vector<std::string>{"id", "data"}), databaseTableColumns(filename, "compression_dictionaries"));
 
     EXPECT_EQ(0u, log.uncheckedCount());
 }
@@ -1526,7 +1835,7 @@ TEST(OfflineDatabase, DowngradeSchema) {
         db.setMaximumAmbientCacheSize(0);
     }
 
-    EXPECT_EQ(6, databaseUserVersion(filename));
+    EXPECT_EQ(7, databaseUserVersion(filename));
 
     EXPECT_EQ((std::vector<std::string>{ "id", "url_template", "pixel_ratio", "z", "x", "y",
                                          "expires", "modified", "etag", "data", "compressed",
@@ -1611,7 +1920,6 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(DisallowedIO)) {
     fs.allowIO(false);
 
     EXPECT_EQ(nullopt, db.get(fixture::resource));
-    EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't update timestamp: authorization denied")));
     EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't read resource: authorization denied")));
     EXPECT_EQ(0u, log.uncheckedCount());
 
@@ -1632,7 +1940,6 @@ TEST(OfflineDatabase, TEST_REQUIRES_WRITE(DisallowedIO)) {
     EXPECT_EQ(0u, log.uncheckedCount());
 
     EXPECT_EQ(nullopt, db.getRegionResource(fixture::resource));
-    EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't update timestamp: authorization denied")));
     EXPECT_EQ(1u, log.count(warning(ResultCode::Auth, "Can't read region resource: authorization denied")));
     EXPECT_EQ(0u, log.uncheckedCount());
 
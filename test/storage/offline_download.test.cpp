@@ -10,6 +10,7 @@
 #include <mbgl/storage/offline_database.hpp>
 #include <mbgl/storage/offline_download.hpp>
 #include <mbgl/storage/http_file_source.hpp>
+#include <mbgl/text/glyph.hpp>
 #include <mbgl/util/run_loop.hpp>
 #include <mbgl/util/io.hpp>
 #include <mbgl/util/compression.hpp>
@@ -18,6 +19,9 @@
 #include <mbgl/storage/sqlite3.hpp>
 #include <gtest/gtest.h>
 
+#include <set>
+#include <thread>
+
 using namespace mbgl;
 using namespace std::literals::string_literals;
 using mapbox::sqlite::ResultCode;
@@ -87,6 +91,29 @@ public:
     }
 };
 
+// Answers the given requests of a FakeFileSource. Styles and sources get their fixtures, so that the
+// download goes on to request the resources they refer to, and everything else gets `data`.
+static void respond(OfflineTest& test,
+                    const std::list<FakeFileSource::FakeFileRequest*>& requests,
+                    const std::shared_ptr<const std::string>& data) {
+    // Copy the callbacks first, as answering a request deallocates it.
+    std::vector<std::pair<Resource::Kind, FileSource::Callback>> callbacks;
+    for (auto* request : requests) {
+        callbacks.emplace_back(request->resource.kind, request->callback);
+    }
+    for (auto& callback : callbacks) {
+        Response response;
+        if (callback.first == Resource::Kind::Style) {
+            response = test.response("style.json");
+        } else if (callback.first == Resource::Kind::Source) {
+            response = test.response("streets.json");
+        } else {
+            response.data = data;
+        }
+        callback.second(response);
+    }
+}
+
 TEST(OfflineDownload, NoSubresources) {
     OfflineTest test;
     auto region = test.createRegion();
@@ -388,6 +415,117 @@ TEST(OfflineDownload, DoesNotFloodTheFileSourceWithRequests) {
     EXPECT_EQ(*fileSource.getProperty(MAX_CONCURRENT_REQUESTS_KEY).getUint(), fileSource.requests.size());
 }
 
+TEST(OfflineDownload, ConcurrencyLimitFollowsLatency) {
+    OfflineTest test;
+    FakeOnlineFileSource fileSource;
+    fileSource.onlineFs->setProperty(MAX_CONCURRENT_REQUESTS_KEY, 8u);
+    auto region = test.createRegion();
+    ASSERT_TRUE(region);
+    OfflineDownload download(
+        region->getID(),
+        OfflineTilePyramidRegionDefinition("http://127.0.0.1:3000/style.json", LatLngBounds::world(), 0.0, 0.0, 1.0, true),
+        test.db, fileSource);
+
+    download.setObserver(std::make_unique<MockObserver>());
+    download.setState(OfflineRegionDownloadState::Active);
+    test.loop.runOnce();
+
+    // Answers every request in flight once it has waited for the given latency, and returns how
+    // many requests the download has in flight afterwards.
+    const auto data = std::make_shared<const std::string>("data");
+    auto respondAfter = [&](Milliseconds latency) {
+        std::this_thread::sleep_for(latency);
+        respond(test, fileSource.requests, data);
+        test.loop.runOnce();
+        return fileSource.requests.size();
+    };
+
+    // The download starts at the file source's maximum.
+    EXPECT_EQ(8u, respondAfter(Milliseconds(10)));
+    EXPECT_EQ(8u, respondAfter(Milliseconds(10)));
+
+    // Once responses take much longer than the fastest ones, it backs off down to the minimum of
+    // two requests.
+    std::size_t inFlight = 8;
+    for (int i = 0; i < 20 && inFlight > 2; ++i) {
+        inFlight = respondAfter(Milliseconds(50));
+    }
+    EXPECT_EQ(2u, inFlight);
+    EXPECT_EQ(2u, respondAfter(Milliseconds(50)));
+
+    // When they are fast again, it grows back to the maximum, but not beyond.
+    for (int i = 0; i < 40 && inFlight < 8; ++i) {
+        inFlight = respondAfter(Milliseconds(10));
+    }
+    EXPECT_EQ(8u, inFlight);
+    EXPECT_EQ(8u, respondAfter(Milliseconds(10)));
+}
+
+TEST(OfflineDownload, BuffersDownloadedResources) {
+    OfflineTest test;
+    FakeOnlineFileSource fileSource;
+    auto region = test.createRegion();
+    ASSERT_TRUE(region);
+    // Covers 21 tiles, so that the download is still going after the first 256 resources.
+    OfflineDownload download(
+        region->getID(),
+        OfflineTilePyramidRegionDefinition("http://127.0.0.1:3000/style.json", LatLngBounds::world(), 0.0, 2.0, 1.0, true),
+        test.db, fileSource);
+
+    download.setObserver(std::make_unique<MockObserver>());
+    download.setState(OfflineRegionDownloadState::Active);
+    test.loop.runOnce();
+
+    auto completedResourceCount = [&] { return test.db.getRegionCompletedStatus(region->getID())->completedResourceCount; };
+
+    // Downloaded resources are stored 256 at a time.
+    const auto data = std::make_shared<const std::string>("data");
+    for (int i = 0; i < 255; ++i) {
+        ASSERT_FALSE(fileSource.requests.empty());
+        respond(test, { fileSource.requests.front() }, data);
+        test.loop.runOnce();
+    }
+    EXPECT_EQ(0u, completedResourceCount());
+
+    respond(test, { fileSource.requests.front() }, data);
+    EXPECT_EQ(256u, completedResourceCount());
+}
+
+TEST(OfflineDownload, BuffersDownloadedResourcesUpTo4MB) {
+    OfflineTest test;
+    FakeOnlineFileSource fileSource;
+    auto region = test.createRegion();
+    ASSERT_TRUE(region);
+    OfflineDownload download(
+        region->getID(),
+        OfflineTilePyramidRegionDefinition("http://127.0.0.1:3000/style.json", LatLngBounds::world(), 0.0, 0.0, 1.0, true),
+        test.db, fileSource);
+
+    download.setObserver(std::make_unique<MockObserver>());
+    download.setState(OfflineRegionDownloadState::Active);
+    test.loop.runOnce();
+
+    auto completedResourceCount = [&] { return test.db.getRegionCompletedStatus(region->getID())->completedResourceCount; };
+
+    // The style and the source are small, so that the buffer fills up with the 1 MB resources.
+    respond(test, fileSource.requests, {});
+    test.loop.runOnce();
+    ASSERT_EQ(Resource::Kind::Source, fileSource.requests.front()->resource.kind);
+    respond(test, { fileSource.requests.front() }, {});
+    test.loop.runOnce();
+
+    const auto data = std::make_shared<const std::string>(1024 * 1024, 'x');
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_FALSE(fileSource.requests.empty());
+        respond(test, { fileSource.requests.front() }, data);
+        test.loop.runOnce();
+    }
+    EXPECT_EQ(0u, completedResourceCount());
+
+    respond(test, { fileSource.requests.front() }, data);
+    EXPECT_EQ(5u, completedResourceCount());
+}
+
 TEST(OfflineDownload, GetStatusNoResources) {
     OfflineTest test;
     auto region = test.createRegion();
@@ -662,6 +800,76 @@ TEST(OfflineDownload, WithPreviouslyExistingTile) {
     test.loop.run();
 }
 
+TEST(OfflineDownload, SkipsStoredResourcesInEveryBatch) {
+    OfflineTest test;
+    auto region = test.createRegion();
+    ASSERT_TRUE(region);
+    OfflineDownload download(
+        region->getID(),
+        OfflineTilePyramidRegionDefinition("http://127.0.0.1:3000/style.json", LatLngBounds::world(), 0.0, 0.0, 1.0, true),
+        test.db, test.fileSource);
+
+    // Every other glyph range is stored already. The download looks queued resources up 256 at a
+    // time, so the stored ranges end up on both sides of the first batch boundary.
+    std::set<std::string> missingGlyphs;
+    for (uint32_t i = 0; i < GLYPH_RANGES_PER_FONT_STACK; ++i) {
+        const Resource glyphs = Resource::glyphs(
+            "http://127.0.0.1:3000/{fontstack}/{range}.pbf", { "Helvetica" }, getGlyphRange(i * GLYPHS_PER_GLYPH_RANGE));
+        if (i % 2 == 0) {
+            test.db.put(glyphs, test.response("glyph.pbf"));
+        } else {
+            missingGlyphs.insert(glyphs.url);
+        }
+    }
+
+    test.fileSource.styleResponse = [&] (const Resource&) {
+        return test.response("style.json");
+    };
+
+    test.fileSource.spriteImageResponse = [&] (const Resource&) {
+        return test.response("sprite.png");
+    };
+
+    test.fileSource.imageResponse = [&] (const Resource&) {
+        return test.response("radar.gif");
+    };
+
+    test.fileSource.spriteJSONResponse = [&] (const Resource&) {
+        return test.response("sprite.json");
+    };
+
+    test.fileSource.glyphsResponse = [&] (const Resource& resource) {
+        EXPECT_EQ(1u, missingGlyphs.erase(resource.url)) << resource.url;
+        return test.response("glyph.pbf");
+    };
+
+    test.fileSource.sourceResponse = [&] (const Resource&) {
+        return test.response("streets.json");
+    };
+
+    test.fileSource.tileResponse = [&] (const Resource&) {
+        return test.response("0-0-0.vector.pbf");
+    };
+
+    auto observer = std::make_unique<MockObserver>();
+
+    observer->statusChangedFn = [&] (OfflineRegionStatus status) {
+        if (status.complete()) {
+            EXPECT_EQ(264u, status.completedResourceCount);
+            EXPECT_EQ(test.size, status.completedResourceSize);
+            EXPECT_TRUE(status.requiredResourceCountIsPrecise);
+            test.loop.stop();
+        }
+    };
+
+    download.setObserver(std::move(observer));
+    download.setState(OfflineRegionDownloadState::Active);
+
+    test.loop.run();
+
+    EXPECT_TRUE(missingGlyphs.empty());
+}
+
 TEST(OfflineDownload, ReactivatePreviouslyCompletedDownload) {
     OfflineTest test;
     auto region = test.createRegion();
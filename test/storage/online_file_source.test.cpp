@@ -9,6 +9,7 @@
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/timer.hpp>
 
+#include <algorithm>
 #include <gtest/gtest.h>
 
 using namespace mbgl;
@@ -596,6 +597,79 @@ TEST(OnlineFileSource, TEST_REQUIRES_SERVER(LowHighPriorityRequestsMany)) {
     loop.run();
 }
 
+TEST(OnlineFileSource, TEST_REQUIRES_SERVER(PriorityLevels)) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+    std::vector<std::string> responses;
+
+    NetworkStatus::Set(NetworkStatus::Status::Offline);
+    fs->setProperty(MAX_CONCURRENT_REQUESTS_KEY, 1u);
+    fs->pause();
+
+    std::vector<std::unique_ptr<AsyncRequest>> requests;
+    auto request = [&](const std::string& name, Resource::Priority priority) {
+        Resource resource{Resource::Unknown, "http://127.0.0.1:3000/load/" + name};
+        resource.setPriority(priority);
+        requests.push_back(fs->request(resource, [&, name](Response) {
+            responses.push_back(name);
+            if (responses.size() == 4) {
+                loop.stop();
+            }
+        }));
+    };
+
+    request("low", Resource::Priority::Low);
+    request("prefetch", Resource::Priority::Prefetch);
+    request("cancelled", Resource::Priority::Regular);
+    request("regular", Resource::Priority::Regular);
+    request("high", Resource::Priority::High);
+
+    // A cancelled request is never started.
+    requests[2].reset();
+
+    fs->resume();
+    NetworkStatus::Set(NetworkStatus::Status::Online);
+    loop.run();
+
+    EXPECT_EQ((std::vector<std::string>{"high", "regular", "prefetch", "low"}), responses);
+}
+
+TEST(OnlineFileSource, TEST_REQUIRES_SERVER(ChangePriorityOfQueuedRequest)) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+    std::vector<std::string> responses;
+
+    fs->setProperty(MAX_CONCURRENT_REQUESTS_KEY, 1u);
+
+    std::vector<std::unique_ptr<AsyncRequest>> requests;
+    auto request = [&](const std::string& name, const std::string& path, Resource::Priority priority) {
+        Resource resource{Resource::Unknown, "http://127.0.0.1:3000/" + path};
+        resource.setPriority(priority);
+        requests.push_back(fs->request(resource, [&, name](Response) {
+            responses.push_back(name);
+            if (responses.size() == 4) {
+                loop.stop();
+            }
+        }));
+    };
+
+    // The delayed request keeps the others queued while the priority changes.
+    request("delayed", "delayed", Resource::Priority::Regular);
+    request("first", "load/1", Resource::Priority::Prefetch);
+    request("second", "load/2", Resource::Priority::Prefetch);
+    request("third", "load/3", Resource::Priority::Prefetch);
+
+    util::Timer timer;
+    timer.start(Milliseconds(50), Duration::zero(), [&] {
+        // Moves ahead of the requests that were queued before it.
+        fs->setPriority(*requests[3], Resource::Priority::Regular);
+    });
+
+    loop.run();
+
+    EXPECT_EQ((std::vector<std::string>{"delayed", "third", "first", "second"}), responses);
+}
+
 TEST(OnlineFileSource, TEST_REQUIRES_SERVER(MaximumConcurrentRequests)) {
     util::RunLoop loop;
     std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
@@ -606,6 +680,128 @@ TEST(OnlineFileSource, TEST_REQUIRES_SERVER(MaximumConcurrentRequests)) {
     ASSERT_EQ(*fs->getProperty(MAX_CONCURRENT_REQUESTS_KEY).getUint(), 10u);
 }
 
+TEST(OnlineFileSource, MaximumConcurrentRevalidations) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+
+    ASSERT_EQ(*fs->getProperty(MAX_CONCURRENT_REVALIDATIONS_KEY).getUint(), 4u);
+
+    fs->setProperty(MAX_CONCURRENT_REVALIDATIONS_KEY, 2u);
+    ASSERT_EQ(*fs->getProperty(MAX_CONCURRENT_REVALIDATIONS_KEY).getUint(), 2u);
+}
+
+TEST(OnlineFileSource, TEST_REQUIRES_SERVER(RevalidationsAreLimited)) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+    fs->setProperty(MAX_CONCURRENT_REVALIDATIONS_KEY, 2u);
+
+    const int count = 6;
+    int responses = 0;
+    int maximumConcurrent = 0;
+    std::vector<std::unique_ptr<AsyncRequest>> requests;
+    for (int i = 0; i < count; ++i) {
+        Resource resource{Resource::Unknown, "http://127.0.0.1:3000/concurrent"};
+        // The requester already has the data, and only asks whether it is still current.
+        resource.priorEtag.emplace("etag");
+        requests.push_back(fs->request(resource, [&](Response res) {
+            EXPECT_EQ(nullptr, res.error);
+            if (res.data) {
+                maximumConcurrent = std::max(maximumConcurrent, std::stoi(*res.data));
+            }
+            if (++responses == count) {
+                loop.stop();
+            }
+        }));
+    }
+
+    loop.run();
+
+    // The server handles up to four requests at once.
+    EXPECT_EQ(2, maximumConcurrent);
+}
+
+TEST(OnlineFileSource, TEST_REQUIRES_SERVER(RevalidationsYieldToNewRequests)) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+    std::vector<std::string> responses;
+
+    NetworkStatus::Set(NetworkStatus::Status::Offline);
+    fs->setProperty(MAX_CONCURRENT_REQUESTS_KEY, 1u);
+    fs->pause();
+
+    std::vector<std::unique_ptr<AsyncRequest>> requests;
+    auto request = [&](const std::string& name, bool revalidation) {
+        Resource resource{Resource::Unknown, "http://127.0.0.1:3000/load/" + name};
+        if (revalidation) {
+            // The requester already has the data, and only asks whether it is still current.
+            resource.priorEtag.emplace("etag");
+        }
+        requests.push_back(fs->request(resource, [&, name](Response) {
+            responses.push_back(name);
+            if (responses.size() == 4) {
+                loop.stop();
+            }
+        }));
+    };
+
+    request("revalidation0", true);
+    request("revalidation1", true);
+    request("new0", false);
+    request("new1", false);
+
+    fs->resume();
+    NetworkStatus::Set(NetworkStatus::Status::Online);
+    loop.run();
+
+    // Whichever request happens to start first, the pending requests for new resources take the
+    // free slots before the pending revalidations.
+    ASSERT_EQ(4u, responses.size());
+    bool revalidated = false;
+    for (std::size_t i = 1; i < responses.size(); ++i) {
+        const bool revalidation = responses[i].rfind("revalidation", 0) == 0;
+        EXPECT_TRUE(revalidation || !revalidated) << responses[i] << " was delayed by a revalidation";
+        revalidated = revalidated || revalidation;
+    }
+    EXPECT_TRUE(revalidated);
+}
+
+TEST(OnlineFileSource, TEST_REQUIRES_SERVER(RevalidationIsConditional)) {
+    util::RunLoop loop;
+    std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
+    fs->setProperty(MAX_CONCURRENT_REVALIDATIONS_KEY, 1u);
+
+    // The server only answers "not modified" if the request carries the prior validators.
+    Resource etagResource{Resource::Unknown, "http://127.0.0.1:3000/revalidate-same"};
+    etagResource.priorEtag.emplace("snowfall");
+    Resource modifiedResource{Resource::Unknown, "http://127.0.0.1:3000/revalidate-modified"};
+    modifiedResource.priorModified.emplace(util::parseTimestamp("jan 1 2015 utc"));
+
+    std::unique_ptr<AsyncRequest> req1;
+    std::unique_ptr<AsyncRequest> req2;
+    unsigned responseCount = 0u;
+
+    auto callback = [&](std::unique_ptr<AsyncRequest>& req) {
+        return [&, start = util::now()](Response res) {
+            req.reset();
+            EXPECT_EQ(nullptr, res.error);
+            EXPECT_TRUE(res.notModified);
+            EXPECT_FALSE(res.data.get());
+            // The revalidation refreshes the expiration time of the data.
+            ASSERT_TRUE(bool(res.expires));
+            EXPECT_LE(start + Seconds(1), *res.expires);
+            EXPECT_TRUE(res.mustRevalidate);
+            if (++responseCount == 2u) {
+                loop.stop();
+            }
+        };
+    };
+
+    req1 = fs->request(etagResource, callback(req1));
+    req2 = fs->request(modifiedResource, callback(req2));
+
+    loop.run();
+}
+
 TEST(OnlineFileSource, TEST_REQUIRES_SERVER(RequestSameUrlMultipleTimes)) {
     util::RunLoop loop;
     std::unique_ptr<FileSource> fs = std::make_unique<OnlineFileSource>(ResourceOptions::Default());
@@ -0,0 +1,51 @@
+#include <mbgl/map/transform.hpp>
+#include <mbgl/test/util.hpp>
+#include <mbgl/text/collision_index.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/mat4.hpp>
+
+using namespace mbgl;
+
+TEST(CollisionIndex, ProjectAnchors) {
+    Transform transform;
+    transform.resize({512, 384});
+    transform.jumpTo(CameraOptions().withCenter(LatLng{0.1, -0.1}).withZoom(4.3).withBearing(12.0).withPitch(50.0));
+    const TransformState& state = transform.getState();
+    CollisionIndex collisionIndex(state, MapMode::Continuous);
+
+    mat4 posMatrix;
+    state.matrixFor(posMatrix, UnwrappedTileID(4, 7, 7));
+    matrix::multiply(posMatrix, state.getProjectionMatrix(), posMatrix);
+
+    // An odd number of anchors, so that vectorized projections also have to deal with a remainder.
+    std::vector<Point<float>> anchors;
+    for (int i = 0; i < 11; ++i) {
+        anchors.emplace_back(i * 800.0f - 200.0f, util::EXTENT - i * 750.0f);
+    }
+
+    ProjectedAnchors projected;
+    collisionIndex.projectAnchors(posMatrix, anchors, projected);
+    ASSERT_EQ(anchors.size(), projected.size());
+
+    const float padding = collisionIndex.getViewportPadding();
+    for (std::size_t i = 0; i < anchors.size(); ++i) {
+        vec4 p = {{anchors[i].x, anchors[i].y, 0, 1}};
+        matrix::transformMat4(p, p, posMatrix);
+        const double x = ((p[0] / p[3] + 1) / 2) * 512 + padding;
+        const double y = ((-p[1] / p[3] + 1) / 2) * 384 + padding;
+        const double perspectiveRatio = 0.5 + 0.5 * state.getCameraToCenterDistance() / p[3];
+
+        const ProjectedAnchor anchor = projected[i];
+        EXPECT_NEAR(x, anchor.point.x, 1e-2);
+        EXPECT_NEAR(y, anchor.point.y, 1e-2);
+        EXPECT_NEAR(p[3], anchor.cameraDistance, 1e-2);
+        EXPECT_NEAR(perspectiveRatio, anchor.perspectiveRatio, 1e-5);
+
+        // Projecting anchors one at a time gives the same result as projecting them in a batch.
+        const ProjectedAnchor single = collisionIndex.projectAnchor(posMatrix, anchors[i]);
+        EXPECT_FLOAT_EQ(anchor.point.x, single.point.x);
+        EXPECT_FLOAT_EQ(anchor.point.y, single.point.y);
+        EXPECT_FLOAT_EQ(anchor.cameraDistance, single.cameraDistance);
+        EXPECT_FLOAT_EQ(anchor.perspectiveRatio, single.perspectiveRatio);
+    }
+}
@@ -417,3 +417,98 @@ TEST(CrossTileSymbolLayerIndex, offscreenSymbols) {
     EXPECT_EQ(symbolBucket.symbolInstances.at(0).crossTileID, 1u);
     EXPECT_EQ(symbolBucket.symbolInstances.at(1).crossTileID, 2u);
 }
+
+namespace {
+
+std::unique_ptr<SymbolBucket> makeSymbolBucket(std::vector<SymbolInstance> instances, uint32_t bucketInstanceId) {
+    Immutable<style::SymbolLayoutProperties::PossiblyEvaluated> layout =
+        makeMutable<style::SymbolLayoutProperties::PossiblyEvaluated>();
+    auto bucket = std::make_unique<SymbolBucket>(layout,
+                                                 std::map<std::string, Immutable<style::LayerProperties>>{},
+                                                 16.0f,
+                                                 1.0f,
+                                                 0,
+                                                 false,
+                                                 false,
+                                                 "test",
+                                                 std::move(instances),
+                                                 std::vector<SortKeyRange>{},
+                                                 1.0f,
+                                                 false,
+                                                 std::vector<style::TextWritingModeType>{},
+                                                 false /*iconsInText*/);
+    bucket->bucketInstanceId = bucketInstanceId;
+    return bucket;
+}
+
+} // namespace
+
+TEST(CrossTileSymbolLayerIndex, matchesAcrossCells) {
+    uint32_t maxCrossTileID = 0;
+    CrossTileSymbolLayerIndex index(maxCrossTileID);
+
+    std::vector<SymbolInstance> mainInstances;
+    mainInstances.push_back(makeSymbolInstance(1000, 1000, u"Detroit"));
+    auto mainBucket = makeSymbolBucket(std::move(mainInstances), 1);
+    index.addBucket(OverscaledTileID(6, 0, 6, 8, 8), mat4{}, *mainBucket);
+    ASSERT_EQ(mainBucket->symbolInstances.at(0).crossTileID, 1u);
+
+    std::vector<SymbolInstance> childInstances;
+    childInstances.push_back(makeSymbolInstance(2112, 2112, u"Detroit"));
+    childInstances.push_back(makeSymbolInstance(2048, 2048, u"Detroit"));
+    auto childBucket = makeSymbolBucket(std::move(childInstances), 2);
+    index.addBucket(OverscaledTileID(7, 0, 7, 16, 16), mat4{}, *childBucket);
+
+    // Too far from the parent symbol
+    ASSERT_EQ(childBucket->symbolInstances.at(0).crossTileID, 2u);
+    // Close to the parent symbol, but on the other side of a bucket boundary
+    ASSERT_EQ(childBucket->symbolInstances.at(1).crossTileID, 1u);
+}
+
+TEST(CrossTileSymbolLayerIndex, matchesAcrossManyZoomLevels) {
+    uint32_t maxCrossTileID = 0;
+    CrossTileSymbolLayerIndex index(maxCrossTileID);
+
+    std::vector<SymbolInstance> childInstances;
+    childInstances.push_back(makeSymbolInstance(0, 0, u"Detroit"));
+    childInstances.push_back(makeSymbolInstance(0, 0, u"Windsor"));
+    auto childBucket = makeSymbolBucket(std::move(childInstances), 1);
+    index.addBucket(OverscaledTileID(14, 0, 14, 2048, 2048), mat4{}, *childBucket);
+    ASSERT_EQ(childBucket->symbolInstances.at(0).crossTileID, 1u);
+    ASSERT_EQ(childBucket->symbolInstances.at(1).crossTileID, 2u);
+
+    std::vector<SymbolInstance> parentInstances;
+    parentInstances.push_back(makeSymbolInstance(20, 20, u"Detroit"));
+    parentInstances.push_back(makeSymbolInstance(100, 100, u"Windsor"));
+    auto parentBucket = makeSymbolBucket(std::move(parentInstances), 2);
+    index.addBucket(OverscaledTileID(6, 0, 6, 8, 8), mat4{}, *parentBucket);
+
+    // Within the tolerance of a tile 8 zoom levels down
+    ASSERT_EQ(parentBucket->symbolInstances.at(0).crossTileID, 1u);
+    ASSERT_EQ(parentBucket->symbolInstances.at(1).crossTileID, 3u);
+}
+
+TEST(CrossTileSymbolLayerIndex, wrapJump) {
+    uint32_t maxCrossTileID = 0;
+    CrossTileSymbolLayerIndex index(maxCrossTileID);
+
+    std::vector<SymbolInstance> mainInstances;
+    mainInstances.push_back(makeSymbolInstance(1000, 1000, u"Detroit"));
+    auto mainBucket = makeSymbolBucket(std::move(mainInstances), 1);
+    index.addBucket(OverscaledTileID(6, 0, 6, 8, 8), mat4{}, *mainBucket);
+    ASSERT_EQ(mainBucket->symbolInstances.at(0).crossTileID, 1u);
+
+    // The tiles that were at wrap 0 are now at wrap 1.
+    index.handleWrapJump(360.0f);
+
+    std::vector<SymbolInstance> childInstances;
+    childInstances.push_back(makeSymbolInstance(2000, 2000, u"Detroit"));
+    auto childBucket = makeSymbolBucket(std::move(childInstances), 2);
+    index.addBucket(OverscaledTileID(7, 1, 7, 16, 16), mat4{}, *childBucket);
+    ASSERT_EQ(childBucket->symbolInstances.at(0).crossTileID, 1u);
+
+    // Re-adding the main bucket at its new wrap keeps its IDs.
+    std::unordered_set<uint32_t> currentIDs{1, 2};
+    EXPECT_FALSE(index.removeStaleBuckets(currentIDs));
+    EXPECT_FALSE(index.addBucket(OverscaledTileID(6, 1, 6, 8, 8), mat4{}, *mainBucket));
+}
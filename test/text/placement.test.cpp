@@ -0,0 +1,104 @@
+#include <mbgl/renderer/buckets/symbol_bucket.hpp>
+#include <mbgl/renderer/render_layer.hpp>
+#include <mbgl/renderer/render_tile.hpp>
+#include <mbgl/style/layers/symbol_layer_impl.hpp>
+#include <mbgl/style/layers/symbol_layer_properties.hpp>
+#include <mbgl/test/util.hpp>
+#include <mbgl/text/placement.hpp>
+#include <mbgl/tile/tile.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+class StubTile : public Tile {
+public:
+    StubTile() : Tile(Tile::Kind::Geometry, OverscaledTileID(0, 0, 0)) {}
+    std::unique_ptr<TileRenderData> createRenderData() override { return nullptr; }
+    bool layerPropertiesUpdated(const Immutable<style::LayerProperties>&) override { return true; }
+};
+
+class StubRenderLayer : public RenderLayer {
+public:
+    StubRenderLayer()
+        : RenderLayer(makeMutable<style::SymbolLayerProperties>(
+              makeMutable<style::SymbolLayer::Impl>("symbols", "source"))) {}
+
+    void setPlacementData(LayerPlacementData data) { placementData = std::move(data); }
+
+    void transition(const TransitionParameters&) override {}
+    void evaluate(const PropertyEvaluationParameters&) override {}
+    bool hasTransition() const override { return false; }
+    bool hasCrossfade() const override { return false; }
+    void render(PaintParameters&) override {}
+};
+
+// Records the buckets it places instead of placing their symbols.
+class RecordingPlacement : public Placement {
+public:
+    std::vector<uint32_t> placedBuckets;
+    bool committed = false;
+
+protected:
+    void placeSymbolBucket(const BucketPlacementData& data, std::set<uint32_t>&) override {
+        placedBuckets.push_back(static_cast<const SymbolBucket&>(data.bucket.get()).bucketInstanceId);
+    }
+    void commit() override { committed = true; }
+};
+
+std::unique_ptr<SymbolBucket> makeBucket(uint32_t bucketInstanceId) {
+    auto bucket = std::make_unique<SymbolBucket>(makeMutable<style::SymbolLayoutProperties::PossiblyEvaluated>(),
+                                                 std::map<std::string, Immutable<style::LayerProperties>>{},
+                                                 16.0f,
+                                                 1.0f,
+                                                 0,
+                                                 false,
+                                                 false,
+                                                 "symbols",
+                                                 std::vector<SymbolInstance>{},
+                                                 std::vector<SortKeyRange>{},
+                                                 1.0f,
+                                                 false,
+                                                 std::vector<style::TextWritingModeType>{},
+                                                 false);
+    bucket->bucketInstanceId = bucketInstanceId;
+    return bucket;
+}
+
+} // namespace
+
+TEST(Placement, IncrementalPlacementFollowsTileChanges) {
+    StubTile tile;
+    RenderTile renderTile(UnwrappedTileID(0, 0, 0), tile);
+    std::vector<std::unique_ptr<SymbolBucket>> buckets;
+    for (uint32_t id = 0; id < 4; ++id) {
+        buckets.push_back(makeBucket(id));
+    }
+    auto placementData = [&](std::vector<uint32_t> ids) {
+        LayerPlacementData data;
+        for (uint32_t id : ids) {
+            data.push_back({*buckets[id], renderTile, nullptr, "source", nullopt});
+        }
+        return data;
+    };
+
+    StubRenderLayer layer;
+    const RenderLayerReferences layers{layer};
+    RecordingPlacement placement;
+
+    // Without a time budget, every call places a single bucket.
+    layer.setPlacementData(placementData({1, 2, 3}));
+    EXPECT_FALSE(placement.placeLayersIncrementally(layers, TimePoint(), Duration::zero()));
+
+    // A tile was added in front of the placed one, and one of the others went away.
+    layer.setPlacementData(placementData({0, 1, 3}));
+    while (!placement.placeLayersIncrementally(layers, TimePoint(), Duration::zero())) {
+        ASSERT_LT(placement.placedBuckets.size(), 4u);
+    }
+
+    EXPECT_TRUE(placement.committed);
+    EXPECT_EQ((std::vector<uint32_t>{1, 0, 3}), placement.placedBuckets);
+}
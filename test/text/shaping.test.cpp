@@ -4,6 +4,7 @@
 #include <mbgl/text/bidi.hpp>
 #include <mbgl/text/tagged_string.hpp>
 #include <mbgl/text/shaping.hpp>
+#include <mbgl/text/shaping_cache.hpp>
 #include <mbgl/util/constants.hpp>
 
 using namespace mbgl;
@@ -105,3 +106,101 @@ TEST(Shaping, ZWSP) {
         ASSERT_EQ(shaping.writingMode, WritingModeType::Horizontal);
     }
 }
+
+TEST(Shaping, Cache) {
+    GlyphPosition glyphPosition;
+    glyphPosition.rect = {0, 0, 24, 24};
+    glyphPosition.metrics.width = 18;
+    glyphPosition.metrics.height = 18;
+    glyphPosition.metrics.left = 2;
+    glyphPosition.metrics.top = -8;
+    glyphPosition.metrics.advance = 21;
+
+    Glyph glyph;
+    glyph.id = u'a';
+    glyph.metrics = glyphPosition.metrics;
+
+    BiDi bidi;
+    const std::vector<std::string> fontStack{{"font-stack"}};
+    const FontStackHash fontStackHash = FontStackHasher()(fontStack);
+    const SectionOptions sectionOptions(1.0f, fontStack);
+    GlyphMap glyphs = {{fontStackHash, {{u'a', Immutable<Glyph>(makeMutable<Glyph>(std::move(glyph)))}}}};
+    ImagePositions imagePositions;
+
+    ShapingCache cache(2);
+    const auto testGetShaping = [&](const TaggedString& string,
+                                    const GlyphPositions& glyphPositions,
+                                    float layoutTextSize = 16.0f,
+                                    float layoutTextSizeAtBucketZoomLevel = 16.0f) {
+        return cache.getShaping(string,
+                                0,      // maxWidth
+                                ONE_EM, // lineHeight
+                                style::SymbolAnchorType::Center,
+                                style::TextJustifyType::Center,
+                                0,              // spacing
+                                {{0.0f, 0.0f}}, // translate
+                                WritingModeType::Horizontal,
+                                bidi,
+                                glyphs,
+                                glyphPositions,
+                                imagePositions,
+                                layoutTextSize,
+                                layoutTextSizeAtBucketZoomLevel,
+                                /*allowVerticalPlacement*/ false);
+    };
+
+    GlyphPositions tile1 = {{fontStackHash, {{u'a', glyphPosition}}}};
+    glyphPosition.rect = {24, 0, 24, 24};
+    GlyphPositions tile2 = {{fontStackHash, {{u'a', glyphPosition}}}};
+
+    // A cached shaping uses the glyph atlas positions of the tile that asks for it.
+    {
+        auto shaping1 = testGetShaping(TaggedString(u"aa", sectionOptions), tile1);
+        EXPECT_EQ(1u, cache.getSize());
+        auto shaping2 = testGetShaping(TaggedString(u"aa", sectionOptions), tile2);
+        EXPECT_EQ(1u, cache.getSize());
+        ASSERT_EQ(1u, shaping2.positionedLines.size());
+        ASSERT_EQ(2u, shaping2.positionedLines[0].positionedGlyphs.size());
+        EXPECT_EQ(shaping1.left, shaping2.left);
+        EXPECT_EQ(shaping1.right, shaping2.right);
+        EXPECT_EQ(shaping1.positionedLines[0].positionedGlyphs[1].x, shaping2.positionedLines[0].positionedGlyphs[1].x);
+        EXPECT_EQ(Rect<uint16_t>(0, 0, 24, 24), shaping1.positionedLines[0].positionedGlyphs[0].rect);
+        EXPECT_EQ(Rect<uint16_t>(24, 0, 24, 24), shaping2.positionedLines[0].positionedGlyphs[0].rect);
+    }
+
+    // Texts without images are shaped the same at every zoom level, whatever their text size.
+    {
+        cache.clear();
+        auto shaping1 = testGetShaping(TaggedString(u"aa", sectionOptions), tile1, 16.0f, 16.0f);
+        auto shaping2 = testGetShaping(TaggedString(u"aa", sectionOptions), tile1, 20.0f, 18.0f);
+        EXPECT_EQ(1u, cache.getSize());
+        EXPECT_EQ(shaping1.left, shaping2.left);
+        EXPECT_EQ(shaping1.right, shaping2.right);
+        EXPECT_EQ(shaping1.top, shaping2.top);
+        EXPECT_EQ(shaping1.bottom, shaping2.bottom);
+        ASSERT_EQ(1u, shaping2.positionedLines.size());
+        EXPECT_EQ(shaping1.positionedLines[0].positionedGlyphs[1].x, shaping2.positionedLines[0].positionedGlyphs[1].x);
+    }
+
+    // Shapings with missing glyphs are not cached, and are not reused on tiles that miss glyphs.
+    {
+        cache.clear();
+        auto shaping = testGetShaping(TaggedString(u"ab", sectionOptions), tile1);
+        EXPECT_EQ(1u, shaping.positionedLines[0].positionedGlyphs.size());
+        EXPECT_EQ(0u, cache.getSize());
+
+        testGetShaping(TaggedString(u"aa", sectionOptions), tile1);
+        EXPECT_EQ(1u, cache.getSize());
+        shaping = testGetShaping(TaggedString(u"aa", sectionOptions), GlyphPositions());
+        EXPECT_FALSE(shaping);
+    }
+
+    // The cache is bounded.
+    {
+        cache.clear();
+        testGetShaping(TaggedString(u"a", sectionOptions), tile1);
+        testGetShaping(TaggedString(u"aa", sectionOptions), tile1);
+        testGetShaping(TaggedString(u"aaa", sectionOptions), tile1);
+        EXPECT_EQ(2u, cache.getSize());
+    }
+}
@@ -85,3 +85,50 @@ TEST(TileCache, Issue15926) {
     EXPECT_FALSE(cache.has(id0));
     EXPECT_TRUE(cache.has(id1));
 }
+
+TEST(TileCache, MemoryBudget) {
+    class SizedTileMock : public VectorTileMock {
+    public:
+        SizedTileMock(const OverscaledTileID& id_,
+                      const TileParameters& parameters,
+                      const Tileset& tileset,
+                      std::size_t memoryUsage_)
+            : VectorTileMock(id_, "source", parameters, tileset), memoryUsage(memoryUsage_) {}
+
+        std::size_t getMemoryUsage() const override { return memoryUsage; }
+
+    private:
+        const std::size_t memoryUsage;
+    };
+
+    VectorTileTest test;
+    TileCache cache(10);
+    OverscaledTileID id0(1, 0, 0);
+    OverscaledTileID id1(1, 1, 0);
+    OverscaledTileID id2(1, 0, 1);
+
+    cache.setMemoryBudget(250);
+    cache.add(id0, std::make_unique<SizedTileMock>(id0, test.tileParameters, test.tileset, 100));
+    cache.add(id1, std::make_unique<SizedTileMock>(id1, test.tileParameters, test.tileset, 100));
+    EXPECT_EQ(200u, cache.getMemoryUsage());
+
+    // Adding a third tile exceeds the budget and evicts the least recently added one.
+    cache.add(id2, std::make_unique<SizedTileMock>(id2, test.tileParameters, test.tileset, 100));
+    EXPECT_FALSE(cache.has(id0));
+    EXPECT_TRUE(cache.has(id1));
+    EXPECT_TRUE(cache.has(id2));
+    EXPECT_EQ(200u, cache.getMemoryUsage());
+
+    EXPECT_NE(nullptr, cache.pop(id1));
+    EXPECT_EQ(100u, cache.getMemoryUsage());
+
+    // Lowering the budget evicts immediately.
+    cache.setMemoryBudget(50);
+    EXPECT_FALSE(cache.has(id2));
+    EXPECT_EQ(0u, cache.getMemoryUsage());
+
+    // A tile that doesn't fit into the budget on its own isn't retained.
+    cache.add(id0, std::make_unique<SizedTileMock>(id0, test.tileParameters, test.tileset, 100));
+    EXPECT_FALSE(cache.has(id0));
+    EXPECT_EQ(0u, cache.getMemoryUsage());
+}
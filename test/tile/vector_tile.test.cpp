@@ -104,4 +104,59 @@ TEST(VectorTileData, ParseResults) {
     ASSERT_EQ(properties.at("disputed"), *feature->getValue("disputed"));
 
     ASSERT_EQ(feature->getValue("invalid"), nullopt);
+
+    const auto& vectorLayer = static_cast<const VectorTileLayer&>(*layer);
+    ASSERT_EQ(vectorLayer.getKeyIndex("invalid"), nullopt);
+    const optional<std::size_t> disputed = vectorLayer.getKeyIndex("disputed");
+    ASSERT_TRUE(disputed);
+    ASSERT_EQ(static_cast<const VectorTileFeature&>(*feature).getValueByKeyIndex(*disputed),
+              feature->getValue("disputed"));
+
+    for (std::size_t i = 0; i < layer->featureCount(); i += 97) {
+        auto other = layer->getFeature(i);
+        for (const auto& property : other->getProperties()) {
+            ASSERT_EQ(property.second, *other->getValue(property.first));
+        }
+    }
+}
+
+TEST(VectorTileData, SharedGeometries) {
+    auto buffer = std::make_shared<std::string>(util::read_file("test/fixtures/map/issue12432/0-0-0.mvt"));
+    VectorTileData data(buffer);
+
+    // Layers read from the same source layer share the decoded geometries of their features.
+    std::unique_ptr<GeometryTileLayer> first = data.getLayer("water");
+    std::unique_ptr<GeometryTileLayer> second = data.getLayer("water");
+    ASSERT_EQ(first->featureCount(), second->featureCount());
+
+    std::unique_ptr<GeometryTileFeature> firstFeature = first->getFeature(0u);
+    std::unique_ptr<GeometryTileFeature> secondFeature = second->getFeature(0u);
+    EXPECT_EQ(&firstFeature->getGeometries(), &secondFeature->getGeometries());
+
+    VectorTileData other(buffer);
+    std::unique_ptr<GeometryTileFeature> otherFeature = other.getLayer("water")->getFeature(0u);
+    EXPECT_EQ(otherFeature->getGeometries(), firstFeature->getGeometries());
+}
+
+TEST(VectorTileData, SharedGeometriesReleasedWithLayers) {
+    auto buffer = std::make_shared<std::string>(util::read_file("test/fixtures/map/issue12432/0-0-0.mvt"));
+    VectorTileData data(buffer);
+
+    std::unique_ptr<GeometryTileLayer> first = data.getLayer("water");
+    std::unique_ptr<GeometryTileLayer> second = data.getLayer("water");
+    std::unique_ptr<GeometryTileFeature> firstFeature = first->getFeature(0u);
+    const GeometryCollection& geometries = firstFeature->getGeometries();
+
+    // The second layer goes away without reading the feature, so the cached geometries are
+    // freed, and a layer read afterwards decodes them again.
+    second.reset();
+    std::unique_ptr<GeometryTileLayer> third = data.getLayer("water");
+    std::unique_ptr<GeometryTileFeature> thirdFeature = third->getFeature(0u);
+    EXPECT_NE(&geometries, &thirdFeature->getGeometries());
+    EXPECT_EQ(geometries, thirdFeature->getGeometries());
+
+    // Features stay valid after their layer is destroyed.
+    first.reset();
+    third.reset();
+    EXPECT_EQ(geometries, firstFeature->getGeometries());
 }
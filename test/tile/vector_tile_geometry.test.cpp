@@ -0,0 +1,92 @@
+#include <mbgl/test/util.hpp>
+#include <mbgl/tile/vector_tile_geometry.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+
+using namespace mbgl;
+
+namespace {
+
+uint32_t encodeZigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+void encodeVarint(std::string& buffer, uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+} // namespace
+
+TEST(VectorTileGeometry, DecodeVarints) {
+    std::mt19937 random(42);
+    std::string buffer;
+    std::vector<uint32_t> expected;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        // Mostly single byte values, with multi byte values in between.
+        const uint32_t value = (i % 23 == 0) ? random() : random() % 128;
+        expected.push_back(value);
+        encodeVarint(buffer, value);
+    }
+
+    std::vector<uint32_t> decoded(expected.size());
+    const char* data = buffer.data();
+    decodeGeometryVarints(data, buffer.data() + buffer.size(), decoded.data(), decoded.size());
+    EXPECT_EQ(buffer.data() + buffer.size(), data);
+    EXPECT_EQ(expected, decoded);
+
+    data = buffer.data();
+    std::vector<uint32_t> tooMany(expected.size() + 1);
+    EXPECT_ANY_THROW(decodeGeometryVarints(data, buffer.data() + buffer.size(), tooMany.data(), tooMany.size()));
+}
+
+TEST(VectorTileGeometry, AppendDeltasMatchesScalar) {
+    std::mt19937 random(42);
+    for (const float scale : { 0.37f, 1.0f, 2.0f }) {
+        for (std::size_t count = 0; count < 40; ++count) {
+            std::vector<uint32_t> parameters;
+            for (std::size_t i = 0; i < 2 * count; ++i) {
+                parameters.push_back(encodeZigzag(static_cast<int32_t>(random() % 400) - 200));
+            }
+
+            Point<int32_t> cursor { 100, -100 };
+            Point<int32_t> scalarCursor = cursor;
+            GeometryCoordinates coordinates;
+            GeometryCoordinates scalarCoordinates;
+            appendGeometryDeltas(parameters.data(), count, cursor, scale, coordinates);
+            appendGeometryDeltasScalar(parameters.data(), count, scalarCursor, scale, scalarCoordinates);
+
+            EXPECT_EQ(scalarCursor, cursor);
+            EXPECT_EQ(scalarCoordinates, coordinates);
+        }
+    }
+}
+
+TEST(VectorTileGeometry, AppendDeltasRounding) {
+    for (const float scale : { 0.5f, 1.5f, 0.25f }) {
+        for (int32_t value = -20; value <= 20; ++value) {
+            const uint32_t parameters[] = { encodeZigzag(value), encodeZigzag(-value), 0, 0 };
+            Point<int32_t> cursor { 0, 0 };
+            GeometryCoordinates coordinates;
+            appendGeometryDeltas(parameters, 2, cursor, scale, coordinates);
+
+            const auto expected = static_cast<int16_t>(std::round(value * scale));
+            ASSERT_EQ(2u, coordinates.size());
+            EXPECT_EQ(expected, coordinates[0].x);
+            EXPECT_EQ(static_cast<int16_t>(std::round(-value * scale)), coordinates[0].y);
+            EXPECT_EQ(expected, coordinates[1].x);
+        }
+    }
+}
+
+TEST(VectorTileGeometry, AppendDeltasOutOfRange) {
+    const uint32_t parameters[] = { encodeZigzag(20000), 0, 0, 0 };
+    Point<int32_t> cursor { 0, 0 };
+    GeometryCoordinates coordinates;
+    EXPECT_ANY_THROW(appendGeometryDeltas(parameters, 2, cursor, 2.0f, coordinates));
+}
@@ -56,3 +56,50 @@ TEST(GridIndex, IndexesFeaturesOverflow) {
     grid.insert(0, {{4500, 4500}, {4900, 4900}});
     EXPECT_EQ(grid.query({{4000, 4000}, {5000, 5000}}), (std::vector<int16_t>{0}));
 }
+
+TEST(GridIndex, SpanningFeaturesAreReportedOnce) {
+    GridIndex<int16_t> grid(100, 100, 10);
+    grid.insert(0, {{5, 5}, {95, 95}});
+    grid.insert(1, {{20, 20}, 25});
+    grid.insert(2, {{42, 42}, {48, 48}});
+
+    EXPECT_EQ(grid.query({{30, 30}, {60, 60}}), (std::vector<int16_t>{0, 1, 2}));
+    EXPECT_EQ(grid.query({{41, 41}, {49, 49}}), (std::vector<int16_t>{0, 2}));
+    EXPECT_EQ(grid.query({{80, 5}, {90, 15}}), (std::vector<int16_t>{0}));
+}
+
+TEST(GridIndex, HitTestPredicate) {
+    GridIndex<int16_t> grid(100, 100, 10);
+    grid.insert(0, {{50, 50}, {60, 60}});
+    grid.insert(1, {{55, 55}, 10});
+
+    EXPECT_TRUE(grid.hitTest({{52, 52}, {58, 58}}, [](int16_t key) { return key == 0; }));
+    EXPECT_TRUE(grid.hitTest({{52, 52}, {58, 58}}, [](int16_t key) { return key == 1; }));
+    EXPECT_FALSE(grid.hitTest({{52, 52}, {58, 58}}, [](int16_t key) { return key == 2; }));
+    EXPECT_TRUE(grid.hitTest({{62, 62}, 1}, [](int16_t key) { return key == 1; }));
+    EXPECT_FALSE(grid.hitTest({{62, 62}, 1}, [](int16_t key) { return key == 0; }));
+    EXPECT_FALSE(grid.hitTest({{-1000, -1000}, {1000, 1000}}, [](int16_t) { return false; }));
+}
+
+TEST(GridIndex, ForEachVisitsEveryItem) {
+    GridIndex<int16_t> grid(100, 100, 10);
+    grid.insert(0, {{4, 10}, {6, 30}});
+    grid.insert(1, {{50, 50}, 10});
+    grid.insert(2, {{-10, 30}, {5, 35}});
+    grid.insert(3, {{150, 150}, {160, 160}});
+
+    std::vector<int16_t> items;
+    std::vector<GridIndex<int16_t>::BBox> boxes;
+    grid.forEach([&](int16_t item, const GridIndex<int16_t>::BBox& box) {
+        items.push_back(item);
+        boxes.push_back(box);
+    });
+
+    EXPECT_EQ(grid.query({{-1000, -1000}, {1000, 1000}}), items);
+    EXPECT_EQ((std::vector<int16_t>{0, 2, 3, 1}), items);
+    ASSERT_EQ(4u, boxes.size());
+    EXPECT_FLOAT_EQ(-10, boxes[1].min.x);
+    EXPECT_FLOAT_EQ(160, boxes[2].max.y);
+    EXPECT_FLOAT_EQ(40, boxes[3].min.x);
+    EXPECT_FLOAT_EQ(60, boxes[3].max.y);
+}
@@ -55,3 +55,15 @@ TEST(HttpRetry, ExpiredNotSet) {
     // No expires header set
     ASSERT_EQ(Duration::max(), expirationTimeout({}, 0));
 }
+
+TEST(HttpRetry, RevalidationJitterWindow) {
+    // An eighth of the time until the revalidation
+    ASSERT_EQ(Seconds(10), revalidationJitterWindow(Seconds(80)));
+
+    // At least half a second
+    ASSERT_EQ(Milliseconds(500), revalidationJitterWindow(Seconds(1)));
+    ASSERT_EQ(Milliseconds(500), revalidationJitterWindow(Duration::zero()));
+
+    // At most 30 seconds
+    ASSERT_EQ(Seconds(30), revalidationJitterWindow(Seconds(3600)));
+}
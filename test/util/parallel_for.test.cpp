@@ -0,0 +1,83 @@
+#include <mbgl/util/parallel_for.hpp>
+#include <mbgl/util/thread_pool.hpp>
+
+#include <mbgl/test/util.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// Runs the scheduled tasks right away and records their priorities.
+class RecordingScheduler : public Scheduler {
+public:
+    void schedule(std::function<void()> fn) override { scheduleWithPriority(TaskPriority::Normal, std::move(fn)); }
+    void scheduleWithPriority(TaskPriority priority, std::function<void()> fn) override {
+        priorities.push_back(priority);
+        fn();
+    }
+    mapbox::base::WeakPtr<Scheduler> makeWeakPtr() override { return weakFactory.makeWeakPtr(); }
+
+    std::vector<TaskPriority> priorities;
+
+private:
+    mapbox::base::WeakPtrFactory<Scheduler> weakFactory{this};
+};
+
+} // namespace
+
+TEST(ParallelFor, CallsEveryIndexOnce) {
+    ThreadPool pool(1, 4);
+    std::vector<std::atomic<int>> calls(100);
+
+    util::parallelFor(pool, calls.size(), 4, TaskPriority::Normal, [&](std::size_t i) { ++calls[i]; });
+
+    for (const auto& count : calls) {
+        EXPECT_EQ(1, count);
+    }
+}
+
+TEST(ParallelFor, NestedInScheduler) {
+    // Must not deadlock when every worker of the pool is waiting in parallelFor().
+    ThreadPool pool(1, 1);
+    std::atomic<int> calls(0);
+
+    std::promise<void> done;
+    pool.schedule([&] {
+        util::parallelFor(pool, 10, 4, TaskPriority::Normal, [&](std::size_t) { ++calls; });
+        done.set_value();
+    });
+    done.get_future().get();
+
+    EXPECT_EQ(10, calls);
+}
+
+TEST(ParallelFor, RethrowsException) {
+    ThreadPool pool(1, 4);
+    std::atomic<int> calls(0);
+
+    EXPECT_THROW(util::parallelFor(pool,
+                                   10,
+                                   4,
+                                   TaskPriority::Normal,
+                                   [&](std::size_t i) {
+                                       ++calls;
+                                       if (i == 5) throw std::runtime_error("failed");
+                                   }),
+                 std::runtime_error);
+    EXPECT_EQ(10, calls);
+}
+
+TEST(ParallelFor, SchedulesWithPriority) {
+    RecordingScheduler scheduler;
+    std::atomic<int> calls(0);
+
+    util::parallelFor(scheduler, 10, 4, TaskPriority::High, [&](std::size_t) { ++calls; });
+
+    EXPECT_EQ(10, calls);
+    EXPECT_EQ(std::vector<TaskPriority>(3, TaskPriority::High), scheduler.priorities);
+}
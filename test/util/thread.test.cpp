@@ -4,10 +4,13 @@
 #include <mbgl/actor/scheduler.hpp>
 #include <mbgl/test/util.hpp>
 #include <mbgl/util/run_loop.hpp>
+#include <mbgl/util/thread_pool.hpp>
 #include <mbgl/util/timer.hpp>
 
 #include <atomic>
+#include <future>
 #include <memory>
+#include <vector>
 
 using namespace mbgl;
 using namespace mbgl::util;
@@ -188,6 +191,36 @@ TEST(Thread, ThreadPoolMessaging) {
     loop->run();
 }
 
+TEST(Thread, ThreadPoolGrowsWithLoad) {
+    ThreadPool pool(1, 4);
+    EXPECT_EQ(1u, pool.getThreadCount());
+
+    // Keep every worker busy, so each new task has to start another one.
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future();
+    std::atomic<unsigned> started(0);
+    std::vector<std::future<void>> finished;
+    for (unsigned i = 0; i < 4; ++i) {
+        auto done = std::make_shared<std::promise<void>>();
+        finished.push_back(done->get_future());
+        pool.schedule([released, &started, done] {
+            ++started;
+            released.wait();
+            done->set_value();
+        });
+        while (started <= i) {
+            std::this_thread::yield();
+        }
+    }
+
+    EXPECT_EQ(4u, pool.getThreadCount());
+
+    release.set_value();
+    for (auto& future : finished) {
+        future.get();
+    }
+}
+
 TEST(Thread, ReferenceCanOutliveThread) {
     auto thread = std::make_unique<Thread<TestWorker>>("Test");
     auto worker = thread->actor();